@@ -1,10 +1,17 @@
 // Comprehensive Benchmark Suite for Cache Performance Testing
 #include "cache.h"
 #include "naive_cache.h"
+#include "combining_cache.h"
+#include "shard_cache.h"
 #include "benchmark_utils.h"
+#include "op_trace.h"
 #include <iostream>
 #include <iomanip>
 #include <unordered_map>
+#include <mutex>
+#include <sstream>
+#include <cstring>
+#include <thread>
 
 using namespace std;
 
@@ -315,6 +322,1076 @@ void benchmarkRehashingSpikes() {
     cout << "\n✓ Spike detection complete!" << endl;
 }
 
+// ===================================================================
+// BENCHMARK 4: Write Contention (mutex vs flat combining)
+// ===================================================================
+// Every thread runs the same insert/get/remove mix against one shared cache.
+// opFn(op, person) performs one operation on the shared instance.
+template <typename OpFn>
+double runContended(int numThreads, int opsPerThread, OpFn opFn) {
+    vector<thread> workers;
+    auto start = high_resolution_clock::now();
+    for (int t = 0; t < numThreads; t++) {
+        workers.push_back(thread([t, opsPerThread, &opFn]() {
+            TestDataGenerator dataGen(42 + t);
+            vector<Person> mine;
+            for (int i = 0; i < opsPerThread; i++) {
+                // 50% insert, 25% get, 25% remove of an earlier insert
+                int kind = i % 4;
+                if (kind == 0 || kind == 2 || mine.empty()) {
+                    Person p = dataGen.generatePerson(i);
+                    mine.push_back(p);
+                    opFn(COMB_INSERT, p);
+                } else if (kind == 1) {
+                    opFn(COMB_GET, mine[i % mine.size()]);
+                } else {
+                    opFn(COMB_REMOVE, mine.back());
+                    mine.pop_back();
+                }
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    auto end = high_resolution_clock::now();
+    double seconds = duration_cast<microseconds>(end - start).count() / 1000000.0;
+    return (numThreads * opsPerThread) / seconds;
+}
+
+void benchmarkContention() {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 4: Write Contention" << endl;
+    cout << "========================================" << endl;
+    cout << "Several threads hammering one shared cache..." << endl;
+
+    // Total work is fixed so the live set stays well below MAXPRIME
+    const int TOTAL_OPERATIONS = 80000;
+    int numThreads = thread::hardware_concurrency();
+    if (numThreads < 4) numThreads = 4;
+    if (numThreads > MAXCOMBTHREADS) numThreads = MAXCOMBTHREADS;
+    const int OPS_PER_THREAD = TOTAL_OPERATIONS / numThreads;
+    cout << "Threads: " << numThreads << endl;
+
+    // Plain mutex around every call
+    double mutexOps = 0;
+    {
+        cout << "\n[1/2] Testing Mutex-Wrapped Cache..." << endl;
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        mutex lock;
+        mutexOps = runContended(numThreads, OPS_PER_THREAD, [&](comb_op_t op, const Person& p) {
+            lock_guard<mutex> guard(lock);
+            if (op == COMB_INSERT) cache.insert(p);
+            else if (op == COMB_REMOVE) cache.remove(p);
+            else cache.getPerson(p.getKey(), p.getID());
+        });
+        cout << "  Throughput: " << fixed << setprecision(0) << mutexOps << " ops/sec" << endl;
+
+        ofstream file("results/contention.csv", ios::app);
+        file << "Mutex," << numThreads << "," << mutexOps << endl;
+        file.close();
+    }
+
+    // Flat combining
+    double combOps = 0;
+    {
+        cout << "\n[2/2] Testing Flat-Combining Cache..." << endl;
+        CombiningCache cache(MINPRIME, hashCode, DOUBLEHASH);
+        combOps = runContended(numThreads, OPS_PER_THREAD, [&](comb_op_t op, const Person& p) {
+            if (op == COMB_INSERT) cache.insert(p);
+            else if (op == COMB_REMOVE) cache.remove(p);
+            else cache.getPerson(p.getKey(), p.getID());
+        });
+        cout << "  Throughput: " << fixed << setprecision(0) << combOps << " ops/sec" << endl;
+        cout << "  Avg batch:  " << fixed << setprecision(2)
+             << (double)cache.getCombinedOps() / cache.getCombineRounds() << " ops/round" << endl;
+
+        ofstream file("results/contention.csv", ios::app);
+        file << "FlatCombining," << numThreads << "," << combOps << endl;
+        file.close();
+    }
+
+    cout << "  Speedup: " << fixed << setprecision(2) << combOps / mutexOps << "x" << endl;
+    cout << "\n✓ Contention benchmark complete!" << endl;
+}
+
+// ===================================================================
+// BENCHMARK 5: Lookup, Update and Remove Latency
+// ===================================================================
+const int OP_ENTRIES = 10000;   // entries loaded before the operations are timed
+const int MIGRATING_WRITES = 2000;  // updateID and remove samples taken during a migration
+
+// std::unordered_map keyed like the throughput benchmark, behind the Cache interface
+class StdMapCache {
+public:
+    bool insert(Person person) {
+        return m_map.emplace(mapKey(person.getKey(), person.getID()), person).second;
+    }
+    bool remove(Person person) {
+        return m_map.erase(mapKey(person.getKey(), person.getID())) > 0;
+    }
+    const Person getPerson(string key, int ID) const {
+        auto it = m_map.find(mapKey(key, ID));
+        return (it == m_map.end()) ? Person("", 0, false) : it->second;
+    }
+    // The ID is part of the map key, so the entry moves
+    bool updateID(Person person, int ID) {
+        auto it = m_map.find(mapKey(person.getKey(), person.getID()));
+        if (it == m_map.end()) {
+            return false;
+        }
+        Person moved = it->second;
+        moved.setID(ID);
+        m_map.erase(it);
+        return m_map.emplace(mapKey(moved.getKey(), ID), moved).second;
+    }
+
+private:
+    static string mapKey(const string& key, int ID) { return key + to_string(ID); }
+    unordered_map<string, Person> m_map;
+};
+
+// reportOperation: One result line and one CSV row
+void reportOperation(const LatencyStats& stats, const string& label, const string& op) {
+    cout << "  " << left << setw(10) << op << right << fixed << setprecision(3)
+         << " P50 " << setw(8) << stats.getP50()
+         << "  P99 " << setw(8) << stats.getP99()
+         << "  P99.9 " << setw(9) << stats.getP999()
+         << "  Max " << setw(10) << stats.getMax() << " μs" << endl;
+    stats.saveToCSV("results/operations.csv", label + "," + op);
+}
+
+// nextID: Another valid ID, for updateID
+int nextID(int ID) {
+    return (ID == MAXID) ? MINID : ID + 1;
+}
+
+// timeOperations: Time hits, misses and, if writes is set, updateID and remove on a loaded cache
+template <typename CacheType>
+void timeOperations(CacheType& cache, vector<Person>& entries, const string& label, bool writes) {
+    LatencyStats hits, misses, updates, removes;
+    Timer timer;
+    mt19937 rng(7);
+
+    for (int i = 0; i < OP_ENTRIES; i++) {
+        const Person& p = entries[rng() % entries.size()];
+        timer.start();
+        cache.getPerson(p.getKey(), p.getID());
+        hits.record(timer.elapsed());
+    }
+    reportOperation(hits, label, "get-hit");
+
+    // Keys never inserted
+    for (int i = 0; i < OP_ENTRIES; i++) {
+        string key = "absent_" + to_string(i);
+        timer.start();
+        cache.getPerson(key, MINID);
+        misses.record(timer.elapsed());
+    }
+    reportOperation(misses, label, "get-miss");
+
+    if (writes == false) {
+        return;
+    }
+    for (unsigned int i = 0; i < entries.size(); i += 2) {
+        int ID = nextID(entries[i].getID());
+        timer.start();
+        cache.updateID(entries[i], ID);
+        updates.record(timer.elapsed());
+        entries[i].setID(ID);
+    }
+    reportOperation(updates, label, "updateID");
+
+    for (unsigned int i = 0; i < entries.size(); i += 2) {
+        timer.start();
+        cache.remove(entries[i]);
+        removes.record(timer.elapsed());
+    }
+    reportOperation(removes, label, "remove");
+}
+
+// loadEntries: Insert OP_ENTRIES distinct keys
+template <typename CacheType>
+vector<Person> loadEntries(CacheType& cache) {
+    TestDataGenerator dataGen;
+    vector<Person> entries;
+    for (int i = 0; i < OP_ENTRIES; i++) {
+        Person p = dataGen.generateUniquePerson(i);
+        if (cache.insert(p)) {
+            entries.push_back(p);
+        }
+    }
+    return entries;
+}
+
+// loadUntilMigrating: Insert from pool into an empty cache until a migration is under way
+// with at least OP_ENTRIES / 2 entries, every call takes the same prefix of pool
+vector<Person> loadUntilMigrating(Cache& cache, const vector<Person>& pool) {
+    vector<Person> entries;
+    for (unsigned int i = 0; i < pool.size(); i++) {
+        if (cache.insert(pool[i])) {
+            entries.push_back(pool[i]);
+        }
+        if ((int)entries.size() >= OP_ENTRIES / 2 && cache.stats().m_migrating) {
+            break;
+        }
+    }
+    return entries;
+}
+
+// timeMigratingWrites: Time updateID and remove while both tables are live
+// updateID leaves the transfer alone, but each remove moves a quarter of the old table, so
+// a migration lasts four removes; the cache is rebuilt up to a fresh one whenever it ends
+void timeMigratingWrites(const vector<Person>& pool, const string& label) {
+    LatencyStats updates, removes;
+    Timer timer;
+    Cache* cache = nullptr;
+    vector<Person> entries;
+    unsigned int next = 0;      // next entry of the current migration to write
+    int migrations = 0;
+
+    for (int phase = 0; phase < 2; phase++) {
+        LatencyStats& stats = (phase == 0) ? updates : removes;
+        while ((int)stats.count() < MIGRATING_WRITES) {
+            if (cache == nullptr || next >= entries.size() || cache->stats().m_migrating == false) {
+                delete cache;
+                cache = new Cache(MINPRIME, hashCode, DOUBLEHASH);
+                entries = loadUntilMigrating(*cache, pool);
+                next = 0;
+                migrations++;
+            }
+            Person& p = entries[next++];
+            if (phase == 0) {
+                int ID = nextID(p.getID());
+                timer.start();
+                cache->updateID(p, ID);
+                stats.record(timer.elapsed());
+                p.setID(ID);
+            } else {
+                timer.start();
+                cache->remove(p);
+                stats.record(timer.elapsed());
+            }
+        }
+        // The removes start on a migration of their own
+        next = entries.size();
+    }
+    delete cache;
+    reportOperation(updates, label, "updateID");
+    reportOperation(removes, label, "remove");
+    cout << "  (" << migrations << " migrations armed for the writes)" << endl;
+}
+
+void benchmarkOperations() {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 5: Lookup, Update and Remove Latency" << endl;
+    cout << "========================================" << endl;
+    cout << "Timing each operation on " << OP_ENTRIES << " distinct keys..." << endl;
+
+    {
+        cout << "\n[1/4] Testing Incremental Rehashing..." << endl;
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        vector<Person> entries = loadEntries(cache);
+        timeOperations(cache, entries, "Incremental", true);
+    }
+
+    // Lookups do not advance the transfer, so a read-only phase stays mid-migration and
+    // pays for checking both tables; the writes are timed on migrations of their own
+    {
+        cout << "\n[2/4] Testing Incremental Rehashing during a migration..." << endl;
+        TestDataGenerator dataGen;
+        vector<Person> pool;
+        for (int i = 0; i < OP_ENTRIES * 4; i++) {
+            pool.push_back(dataGen.generateUniquePerson(i));
+        }
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        vector<Person> entries = loadUntilMigrating(cache, pool);
+        CacheStats before = cache.stats();
+        cout << "  Migration at " << fixed << setprecision(0) << before.migrationProgress() * 100
+             << "% with " << before.m_liveEntries << " entries" << endl;
+        timeOperations(cache, entries, "Incremental-migrating", false);
+        if (cache.stats().m_migrating == false) {
+            cout << "  (the migration finished during the run)" << endl;
+        }
+        timeMigratingWrites(pool, "Incremental-migrating");
+    }
+
+    {
+        cout << "\n[3/4] Testing Naive Full Rehashing..." << endl;
+        NaiveCache cache(MINPRIME, hashCode, DOUBLEHASH);
+        vector<Person> entries = loadEntries(cache);
+        timeOperations(cache, entries, "Naive", true);
+    }
+
+    {
+        cout << "\n[4/4] Testing std::unordered_map..." << endl;
+        StdMapCache cache;
+        vector<Person> entries = loadEntries(cache);
+        timeOperations(cache, entries, "std_unordered_map", true);
+    }
+
+    cout << "\n✓ Operation latency benchmark complete!" << endl;
+}
+
+// ===================================================================
+// BENCHMARK 6: Mixed Workloads
+// ===================================================================
+const int MIX_OPERATIONS = 50000;
+
+// Share of each operation in percent, the four add up to 100
+struct WorkloadMix {
+    string name;
+    int readPct;
+    int insertPct;
+    int removePct;
+    int updatePct;
+};
+
+// runMix: Preload, then draw each operation from the mix; returns ops/sec
+// Reads and writes pick a random live entry, inserts add a new key
+template <typename CacheType>
+double runMix(CacheType& cache, const WorkloadMix& mix, LatencyStats& stats) {
+    vector<Person> live = loadEntries(cache);
+    TestDataGenerator dataGen(43);
+    mt19937 rng(11);
+    Timer timer;
+    int nextIndex = OP_ENTRIES;
+    auto start = high_resolution_clock::now();
+    for (int i = 0; i < MIX_OPERATIONS; i++) {
+        int roll = rng() % 100;
+        if (live.empty()) {
+            roll = mix.readPct;     // nothing to read, remove or update: insert
+        }
+        if (roll < mix.readPct) {
+            const Person& p = live[rng() % live.size()];
+            timer.start();
+            cache.getPerson(p.getKey(), p.getID());
+            stats.record(timer.elapsed());
+        } else if (roll < mix.readPct + mix.insertPct || mix.removePct + mix.updatePct == 0) {
+            Person p = dataGen.generateUniquePerson(nextIndex++);
+            timer.start();
+            cache.insert(p);
+            stats.record(timer.elapsed());
+            live.push_back(p);
+        } else if (roll < mix.readPct + mix.insertPct + mix.removePct) {
+            int index = rng() % live.size();
+            timer.start();
+            cache.remove(live[index]);
+            stats.record(timer.elapsed());
+            live[index] = live.back();
+            live.pop_back();
+        } else {
+            Person& p = live[rng() % live.size()];
+            int ID = nextID(p.getID());
+            timer.start();
+            cache.updateID(p, ID);
+            stats.record(timer.elapsed());
+            p.setID(ID);
+        }
+    }
+    auto end = high_resolution_clock::now();
+    double seconds = duration_cast<nanoseconds>(end - start).count() / 1e9;
+    return MIX_OPERATIONS / seconds;
+}
+
+// reportMix: One result line and one CSV row
+void reportMix(const string& label, const WorkloadMix& mix, double opsPerSec, const LatencyStats& stats) {
+    cout << "  " << left << setw(18) << label << right << fixed << setprecision(0)
+         << setw(10) << opsPerSec << " ops/sec" << setprecision(3)
+         << "  P50 " << setw(7) << stats.getP50()
+         << "  P99 " << setw(8) << stats.getP99()
+         << "  Max " << setw(10) << stats.getMax() << " μs" << endl;
+    ofstream file("results/mixed.csv", ios::app);
+    file << label << "," << mix.name << "," << fixed << setprecision(0) << opsPerSec << ","
+         << setprecision(3) << stats.getP50() << "," << stats.getP99() << ","
+         << stats.getP999() << "," << stats.getMax() << endl;
+    file.close();
+}
+
+void benchmarkMixed(const vector<WorkloadMix>& mixes) {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 6: Mixed Workloads" << endl;
+    cout << "========================================" << endl;
+    cout << MIX_OPERATIONS << " operations per mix after loading " << OP_ENTRIES << " keys..." << endl;
+
+    for (unsigned int m = 0; m < mixes.size(); m++) {
+        const WorkloadMix& mix = mixes[m];
+        cout << "\n[" << m + 1 << "/" << mixes.size() << "] " << mix.name << ": "
+             << mix.readPct << "% get, " << mix.insertPct << "% insert, "
+             << mix.removePct << "% remove, " << mix.updatePct << "% updateID" << endl;
+        {
+            Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+            LatencyStats stats;
+            double ops = runMix(cache, mix, stats);
+            reportMix("Incremental", mix, ops, stats);
+        }
+        {
+            NaiveCache cache(MINPRIME, hashCode, DOUBLEHASH);
+            LatencyStats stats;
+            double ops = runMix(cache, mix, stats);
+            reportMix("Naive", mix, ops, stats);
+        }
+        {
+            StdMapCache cache;
+            LatencyStats stats;
+            double ops = runMix(cache, mix, stats);
+            reportMix("std_unordered_map", mix, ops, stats);
+        }
+    }
+
+    cout << "\n✓ Mixed workload benchmark complete!" << endl;
+}
+
+// ===================================================================
+// BENCHMARK 7: YCSB Workloads
+// ===================================================================
+// Hash tables have no key order, so a YCSB scan reads consecutive record numbers one get
+// at a time, the same on every implementation
+
+// Probes per lookup, which is where clustering and hot slots show up; Cache only
+string probeNote(const Cache& cache) {
+    CacheStats stats = cache.stats();
+    unsigned long long lookups = stats.m_hits + stats.m_misses;
+    ostringstream note;
+    note << fixed << setprecision(2) << "  probes/get "
+         << (lookups > 0 ? double(stats.m_probeSum[STAT_GET]) / lookups : 0.0);
+    return note.str();
+}
+template <typename CacheType>
+string probeNote(const CacheType&) {
+    return "";
+}
+
+// runWorkload: Load the records, then run the operations; returns ops/sec
+// ids holds the current ID of every record, updates move it
+template <typename CacheType>
+double runWorkload(CacheType& cache, const WorkloadSpec& spec, LatencyStats& stats) {
+    WorkloadGenerator gen(spec);
+    vector<int> ids;
+    ids.reserve(spec.recordCount + spec.operationCount);
+    for (int r = 0; r < spec.recordCount; r++) {
+        Person p = gen.record(r);
+        cache.insert(p);
+        ids.push_back(p.getID());
+    }
+    // Draw every operation first so the generator stays out of the timing
+    vector<WorkloadOp> ops;
+    ops.reserve(spec.operationCount);
+    for (int i = 0; i < spec.operationCount; i++) {
+        ops.push_back(gen.next());
+    }
+
+    Timer timer;
+    auto start = high_resolution_clock::now();
+    for (int i = 0; i < spec.operationCount; i++) {
+        const WorkloadOp& op = ops[i];
+        if (op.op == YCSB_INSERT) {
+            Person p = gen.record(op.record);
+            timer.start();
+            cache.insert(p);
+            stats.record(timer.elapsed());
+            ids.push_back(p.getID());
+            continue;
+        }
+        string key = gen.keyOf(op.record);
+        if (op.op == YCSB_READ) {
+            timer.start();
+            cache.getPerson(key, ids[op.record]);
+            stats.record(timer.elapsed());
+        } else if (op.op == YCSB_SCAN) {
+            int last = op.record + op.scanLength;
+            last = last < (int)ids.size() ? last : (int)ids.size();
+            vector<string> keys;
+            for (int r = op.record; r < last; r++) {
+                keys.push_back(gen.keyOf(r));
+            }
+            timer.start();
+            for (int r = op.record; r < last; r++) {
+                cache.getPerson(keys[r - op.record], ids[r]);
+            }
+            stats.record(timer.elapsed());
+        } else {
+            int ID = nextID(ids[op.record]);
+            timer.start();
+            if (op.op == YCSB_RMW) {
+                cache.getPerson(key, ids[op.record]);
+            }
+            cache.updateID(Person(key, ids[op.record], true), ID);
+            stats.record(timer.elapsed());
+            ids[op.record] = ID;
+        }
+    }
+    auto end = high_resolution_clock::now();
+    double seconds = duration_cast<nanoseconds>(end - start).count() / 1e9;
+    return spec.operationCount / seconds;
+}
+
+// reportWorkload: One result line and one CSV row
+void reportWorkload(const string& label, const WorkloadSpec& spec, double opsPerSec,
+                    const LatencyStats& stats, const string& note) {
+    const char* popularity[] = {"uniform", "zipfian", "hotspot", "latest"};
+    cout << "  " << left << setw(18) << label << right << fixed << setprecision(0)
+         << setw(10) << opsPerSec << " ops/sec" << setprecision(3)
+         << "  P50 " << setw(7) << stats.getP50()
+         << "  P99 " << setw(8) << stats.getP99()
+         << "  Max " << setw(10) << stats.getMax() << " μs" << note << endl;
+    ofstream file("results/ycsb.csv", ios::app);
+    file << label << "," << spec.name << "," << popularity[spec.popularity] << ","
+         << spec.recordCount << "," << spec.operationCount << ","
+         << fixed << setprecision(0) << opsPerSec << "," << setprecision(3)
+         << stats.getP50() << "," << stats.getP99() << "," << stats.getP999() << ","
+         << stats.getMax() << endl;
+    file.close();
+}
+
+void benchmarkYCSB(const vector<WorkloadSpec>& specs) {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 7: YCSB Workloads" << endl;
+    cout << "========================================" << endl;
+    cout << "Skewed key popularity over a realistic key space..." << endl;
+
+    for (unsigned int w = 0; w < specs.size(); w++) {
+        const WorkloadSpec& spec = specs[w];
+        cout << "\n[" << w + 1 << "/" << specs.size() << "] " << spec.name << ": "
+             << spec.recordCount << " records, " << spec.operationCount << " operations, keys "
+             << spec.minKeyLength << "-" << spec.maxKeyLength << " bytes" << endl;
+        {
+            Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+            LatencyStats stats;
+            double ops = runWorkload(cache, spec, stats);
+            reportWorkload("Incremental", spec, ops, stats, probeNote(cache));
+        }
+        {
+            NaiveCache cache(MINPRIME, hashCode, DOUBLEHASH);
+            LatencyStats stats;
+            double ops = runWorkload(cache, spec, stats);
+            reportWorkload("Naive", spec, ops, stats, probeNote(cache));
+        }
+        {
+            StdMapCache cache;
+            LatencyStats stats;
+            double ops = runWorkload(cache, spec, stats);
+            reportWorkload("std_unordered_map", spec, ops, stats, probeNote(cache));
+        }
+    }
+
+    cout << "\n✓ YCSB benchmark complete!" << endl;
+}
+
+// ===================================================================
+// BENCHMARK 8: Multi-Threaded Scaling
+// ===================================================================
+// N pinned workers run one YCSB workload against a shared instance, each with its own
+// generator, and start together from a barrier. Updates rewrite a record with its own ID,
+// so every thread's view of the IDs stays right whatever the others do; inserts go to a
+// record range of the thread's own.
+const int SCALING_OPS_PER_THREAD = 20000;
+
+// Operation of a worker, persons[m_first .. m_first + m_count) are its operands
+struct ScalingOp {
+    ycsb_op_t m_op;
+    int       m_first;
+    int       m_count;
+};
+
+// planWorker: Draw a worker's operations before the start so the generator stays out of
+// the timing; at most maxInserts inserts, later ones become reads
+void planWorker(const WorkloadSpec& spec, int worker, int opsPerThread, int maxInserts,
+                vector<ScalingOp>& ops, vector<Person>& persons) {
+    WorkloadGenerator gen(spec, 42 + worker);
+    int inserted = 0;
+    int insertBase = spec.recordCount + worker * maxInserts;
+    for (int i = 0; i < opsPerThread; i++) {
+        WorkloadOp op = gen.next();
+        if (op.op == YCSB_INSERT) {
+            if (inserted < maxInserts) {
+                inserted++;
+            } else {
+                op.op = YCSB_READ;
+                op.record %= spec.recordCount;
+            }
+        }
+        ScalingOp planned = {op.op, (int)persons.size(), op.op == YCSB_SCAN ? op.scanLength : 1};
+        for (int k = 0; k < planned.m_count; k++) {
+            int record = op.record + k;
+            if (record >= spec.recordCount) {
+                record = insertBase + (record - spec.recordCount);
+            }
+            persons.push_back(gen.record(record));
+        }
+        ops.push_back(planned);
+    }
+}
+
+// runScaling: One run with the given number of workers; returns ops/sec
+// opFn(op, person) performs a single YCSB_READ, YCSB_UPDATE or YCSB_INSERT on the shared
+// instance, firstCore is where worker 0 is pinned
+template <typename OpFn>
+double runScaling(int threads, const WorkloadSpec& spec, int opsPerThread, int firstCore,
+                  OpFn opFn, LatencyStats& merged, double& worstThreadP999) {
+    int maxInserts = (MAXPRIME / 4 - spec.recordCount) / threads;
+    vector<vector<ScalingOp> > ops(threads);
+    vector<vector<Person> > persons(threads);
+    for (int t = 0; t < threads; t++) {
+        planWorker(spec, t, opsPerThread, maxInserts, ops[t], persons[t]);
+    }
+    vector<LatencyStats> perThread(threads);
+    StartBarrier barrier;
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&, t]() {
+            pinThread(firstCore + t);
+            Timer timer;
+            LatencyStats& stats = perThread[t];
+            const vector<Person>& mine = persons[t];
+            barrier.arrive();
+            for (unsigned int i = 0; i < ops[t].size(); i++) {
+                const ScalingOp& op = ops[t][i];
+                timer.start();
+                if (op.m_op == YCSB_SCAN) {
+                    for (int k = 0; k < op.m_count; k++) {
+                        opFn(YCSB_READ, mine[op.m_first + k]);
+                    }
+                } else if (op.m_op == YCSB_RMW) {
+                    opFn(YCSB_READ, mine[op.m_first]);
+                    opFn(YCSB_UPDATE, mine[op.m_first]);
+                } else {
+                    opFn(op.m_op, mine[op.m_first]);
+                }
+                stats.record(timer.elapsed());
+            }
+        }));
+    }
+    barrier.waitForAll(threads);
+    auto start = high_resolution_clock::now();
+    barrier.release();
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    auto end = high_resolution_clock::now();
+
+    worstThreadP999 = 0;
+    for (int t = 0; t < threads; t++) {
+        merged.merge(perThread[t]);
+        worstThreadP999 = max(worstThreadP999, perThread[t].getP999());
+    }
+    double seconds = duration_cast<nanoseconds>(end - start).count() / 1e9;
+    return double(threads) * opsPerThread / seconds;
+}
+
+// preloadRecords: Insert the workload's records through opFn
+template <typename OpFn>
+void preloadRecords(const WorkloadSpec& spec, OpFn& opFn) {
+    WorkloadGenerator loader(spec);
+    for (int r = 0; r < spec.recordCount; r++) {
+        opFn(YCSB_INSERT, loader.record(r));
+    }
+}
+
+// scaleImplementation: Every thread count, measureFn(threads, merged, worst) builds a fresh
+// instance, preloads it and returns runScaling's ops/sec, or a negative value if the run
+// did not measure what the label says; such a row is left out
+template <typename MeasureFn>
+void scaleImplementation(const string& label, const WorkloadSpec& spec, const vector<int>& threadCounts,
+                         MeasureFn measureFn) {
+    cout << "\n  " << label << endl;
+    cout << "  " << setw(7) << "threads" << setw(12) << "ops/sec" << setw(12) << "efficiency"
+         << setw(10) << "P50 μs" << setw(10) << "P99 μs" << setw(12) << "P99.9 μs"
+         << setw(20) << "worst thread P99.9" << endl;
+    double single = 0;
+    for (unsigned int c = 0; c < threadCounts.size(); c++) {
+        int threads = threadCounts[c];
+        LatencyStats merged;
+        double worst = 0;
+        double ops = measureFn(threads, merged, worst);
+        if (ops < 0) {
+            cout << "  " << setw(7) << threads << "  not reported, the run did not take the measured path" << endl;
+            continue;
+        }
+        if (single == 0) {
+            single = ops / threads;
+        }
+        double efficiency = ops / (threads * single);
+        cout << "  " << setw(7) << threads << fixed << setprecision(0) << setw(12) << ops
+             << setprecision(2) << setw(12) << efficiency << setprecision(3)
+             << setw(10) << merged.getP50() << setw(10) << merged.getP99()
+             << setw(12) << merged.getP999() << setw(20) << worst << endl;
+        ofstream file("results/scaling.csv", ios::app);
+        file << label << "," << spec.name << "," << threads << "," << fixed << setprecision(0) << ops << ","
+             << setprecision(3) << efficiency << "," << merged.getP50() << "," << merged.getP99() << ","
+             << merged.getP999() << "," << worst << endl;
+        file.close();
+    }
+}
+
+void benchmarkScaling(const WorkloadSpec& spec, int maxThreads, int opsPerThread) {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 8: Multi-Threaded Scaling" << endl;
+    cout << "========================================" << endl;
+    int cores = thread::hardware_concurrency();
+    cout << spec.name << ", " << opsPerThread << " operations per thread, "
+         << cores << " hardware threads" << endl;
+    if (maxThreads > MAXCOMBTHREADS) {
+        maxThreads = MAXCOMBTHREADS;
+    }
+    // Powers of two up to the maximum, and the maximum itself
+    vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2) {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(maxThreads);
+    // Shard owners take the first cores, the workers are pinned after them
+    int shards = max(1, cores / 2);
+
+    scaleImplementation("Mutex-Cache", spec, threadCounts,
+        [&](int threads, LatencyStats& merged, double& worst) {
+            Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+            mutex lock;
+            auto opFn = [&](ycsb_op_t op, const Person& p) {
+                lock_guard<mutex> guard(lock);
+                if (op == YCSB_READ) cache.getPerson(p.getKey(), p.getID());
+                else if (op == YCSB_UPDATE) cache.updateID(p, p.getID());
+                else cache.insert(p);
+            };
+            preloadRecords(spec, opFn);
+            return runScaling(threads, spec, opsPerThread, 0, opFn, merged, worst);
+        });
+
+    scaleImplementation("FlatCombining", spec, threadCounts,
+        [&](int threads, LatencyStats& merged, double& worst) {
+            CombiningCache cache(MINPRIME, hashCode, DOUBLEHASH);
+            auto opFn = [&](ycsb_op_t op, const Person& p) {
+                if (op == YCSB_READ) cache.getPerson(p.getKey(), p.getID());
+                else if (op == YCSB_UPDATE) cache.updateID(p, p.getID());
+                else cache.insert(p);
+            };
+            // Preload from a thread that exits, so its slot is free again for the workers
+            thread loader([&]() { preloadRecords(spec, opFn); });
+            loader.join();
+            double ops = runScaling(threads, spec, opsPerThread, 0, opFn, merged, worst);
+            // Requests of threads without a slot ran under the plain lock
+            if (cache.getDirectOps() != 0) {
+                cout << "  " << cache.getDirectOps() << " requests bypassed the combiner" << endl;
+                return -1.0;
+            }
+            return ops;
+        });
+
+    scaleImplementation("Sharded-" + to_string(shards), spec, threadCounts,
+        [&](int threads, LatencyStats& merged, double& worst) {
+            ShardedCache cache(shards, MINPRIME, hashCode, DOUBLEHASH);
+            auto opFn = [&](ycsb_op_t op, const Person& p) {
+                if (op == YCSB_READ) cache.getPerson(p.getKey(), p.getID()).get();
+                else if (op == YCSB_UPDATE) cache.updateID(p, p.getID()).get();
+                else cache.insert(p).get();
+            };
+            preloadRecords(spec, opFn);
+            return runScaling(threads, spec, opsPerThread, shards, opFn, merged, worst);
+        });
+
+    scaleImplementation("Mutex-unordered_map", spec, threadCounts,
+        [&](int threads, LatencyStats& merged, double& worst) {
+            StdMapCache cache;
+            mutex lock;
+            auto opFn = [&](ycsb_op_t op, const Person& p) {
+                lock_guard<mutex> guard(lock);
+                if (op == YCSB_READ) cache.getPerson(p.getKey(), p.getID());
+                else if (op == YCSB_UPDATE) cache.updateID(p, p.getID());
+                else cache.insert(p);
+            };
+            preloadRecords(spec, opFn);
+            return runScaling(threads, spec, opsPerThread, 0, opFn, merged, worst);
+        });
+
+    cout << "\n✓ Scaling benchmark complete!" << endl;
+}
+
+// ===================================================================
+// BENCHMARK 9: Open-Loop Latency
+// ===================================================================
+// The benchmarks above are closed-loop: an operation starts only when the one before it has
+// finished, so a rehash pause delays the following operations without any of them being
+// measured as late. Here operation i is due at start + i / rate whatever happened before it,
+// and its latency runs from that due time, so the queue that builds up behind a pause is
+// counted (coordinated omission correction). A rate of 0 runs closed-loop, as fast as possible.
+const int OPENLOOP_OPERATIONS = 40000;
+const double OPENLOOP_LOADS[] = {0.1, 0.25, 0.5, 0.75, 0.9, 1.0, 1.2};   // shares of the capacity
+
+// runOpenLoop: Issue the planned operations at ratePerSec; returns the achieved ops/sec
+// corrected is measured from the due time, service from the moment the operation really started
+template <typename OpFn>
+double runOpenLoop(const vector<ScalingOp>& ops, const vector<Person>& persons, double ratePerSec,
+                   OpFn& opFn, LatencyStats& corrected, LatencyStats& service) {
+    double nsPerTick = TscClock::nsPerTick();
+    double interval = ratePerSec > 0 ? 1e9 / ratePerSec / nsPerTick : 0;
+    uint64_t start = TscClock::ticks();
+    uint64_t end = start;
+    for (unsigned int i = 0; i < ops.size(); i++) {
+        uint64_t due = start + (uint64_t)(i * interval);
+        uint64_t begin = TscClock::ticks();
+        while (begin < due) {
+            begin = TscClock::ticks();
+        }
+        if (interval == 0) {
+            due = begin;
+        }
+        const ScalingOp& op = ops[i];
+        if (op.m_op == YCSB_SCAN) {
+            for (int k = 0; k < op.m_count; k++) {
+                opFn(YCSB_READ, persons[op.m_first + k]);
+            }
+        } else if (op.m_op == YCSB_RMW) {
+            opFn(YCSB_READ, persons[op.m_first]);
+            opFn(YCSB_UPDATE, persons[op.m_first]);
+        } else {
+            opFn(op.m_op, persons[op.m_first]);
+        }
+        end = TscClock::ticks();
+        corrected.recordNs((uint64_t)((end - due) * nsPerTick));
+        service.recordNs((uint64_t)((end - begin) * nsPerTick));
+    }
+    double seconds = (end - start) * nsPerTick / 1e9;
+    return seconds > 0 ? ops.size() / seconds : 0;
+}
+
+// openLoopImplementation: The rate sweep of one implementation, measureFn(rate, corrected,
+// service) builds a fresh instance, preloads it and returns runOpenLoop's ops/sec
+template <typename MeasureFn>
+void openLoopImplementation(const string& label, const WorkloadSpec& spec, const vector<double>& rates,
+                            MeasureFn measureFn) {
+    cout << "\n  " << label << endl;
+    cout << "  " << setw(12) << "target/sec" << setw(12) << "achieved" << setw(10) << "P50 μs"
+         << setw(11) << "P99 μs" << setw(12) << "P99.9 μs" << setw(12) << "Max μs"
+         << setw(20) << "service P99 μs" << endl;
+    for (unsigned int r = 0; r < rates.size(); r++) {
+        LatencyStats corrected;
+        LatencyStats service;
+        double achieved = measureFn(rates[r], corrected, service);
+        cout << "  " << fixed << setprecision(0) << setw(12) << rates[r] << setw(12) << achieved
+             << setprecision(3) << setw(10) << corrected.getP50() << setw(11) << corrected.getP99()
+             << setw(12) << corrected.getP999() << setw(12) << corrected.getMax()
+             << setw(20) << service.getP99() << endl;
+        ofstream file("results/openloop.csv", ios::app);
+        file << label << "," << spec.name << "," << fixed << setprecision(0) << rates[r] << "," << achieved << ","
+             << setprecision(3) << corrected.getP50() << "," << corrected.getP99() << ","
+             << corrected.getP999() << "," << corrected.getMax() << ","
+             << service.getP99() << "," << service.getMax() << endl;
+        file.close();
+    }
+}
+
+void benchmarkOpenLoop(const WorkloadSpec& spec) {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 9: Open-Loop Latency" << endl;
+    cout << "========================================" << endl;
+    cout << spec.name << ": " << spec.recordCount << " records, " << spec.operationCount
+         << " operations issued at fixed rates, latency measured from the intended start..." << endl;
+
+    // One plan for every run, the inserts grow the table through several rehashes
+    vector<ScalingOp> ops;
+    vector<Person> persons;
+    planWorker(spec, 0, spec.operationCount, MAXPRIME / 4 - spec.recordCount, ops, persons);
+
+    auto incremental = [&](double rate, LatencyStats& corrected, LatencyStats& service) {
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        auto opFn = [&](ycsb_op_t op, const Person& p) {
+            if (op == YCSB_READ) cache.getPerson(p.getKey(), p.getID());
+            else if (op == YCSB_UPDATE) cache.updateID(p, p.getID());
+            else cache.insert(p);
+        };
+        preloadRecords(spec, opFn);
+        return runOpenLoop(ops, persons, rate, opFn, corrected, service);
+    };
+    auto naive = [&](double rate, LatencyStats& corrected, LatencyStats& service) {
+        NaiveCache cache(MINPRIME, hashCode, DOUBLEHASH);
+        auto opFn = [&](ycsb_op_t op, const Person& p) {
+            if (op == YCSB_READ) cache.getPerson(p.getKey(), p.getID());
+            else if (op == YCSB_UPDATE) cache.updateID(p, p.getID());
+            else cache.insert(p);
+        };
+        preloadRecords(spec, opFn);
+        return runOpenLoop(ops, persons, rate, opFn, corrected, service);
+    };
+
+    // Capacity: the closed-loop rate, the sweep offers shares of the larger of the two
+    LatencyStats unused;
+    LatencyStats unusedService;
+    double capacity = max(incremental(0, unused, unusedService), naive(0, unused, unusedService));
+    cout << "Capacity (closed loop, the faster implementation): " << fixed << setprecision(0)
+         << capacity << " ops/sec" << endl;
+    vector<double> rates;
+    for (double load : OPENLOOP_LOADS) {
+        rates.push_back(capacity * load);
+    }
+
+    openLoopImplementation("Incremental", spec, rates, incremental);
+    openLoopImplementation("Naive", spec, rates, naive);
+
+    cout << "\nAbove capacity the queue grows for the whole run, so those rows measure the run length." << endl;
+    cout << "\n✓ Open-loop benchmark complete!" << endl;
+}
+
+// openLoopSpec: Half reads, half inserts from a small start, so the run crosses several rehashes
+WorkloadSpec openLoopSpec() {
+    WorkloadSpec spec = WorkloadSpec::preset('A');
+    spec.name = "open-loop";
+    spec.recordCount = 1000;
+    spec.operationCount = OPENLOOP_OPERATIONS;
+    spec.readProportion = 0.5;
+    spec.updateProportion = 0;
+    spec.insertProportion = 0.5;
+    spec.scanProportion = 0;
+    spec.rmwProportion = 0;
+    return spec;
+}
+
+// ===================================================================
+// BENCHMARK 10: Trace Replay
+// ===================================================================
+// A trace captured with TracingCache (op_trace.h) is fed to candidate configurations: the
+// probing policy, the initial capacity, NaiveCache or std::unordered_map. At speed 0 the records
+// run back to back, otherwise record i is issued at its recorded time divided by speed and
+// measured from then, as in the open-loop benchmark. The whole trace is decoded before the
+// run so decoding stays out of the timing.
+const char* SAMPLE_TRACE = "results/sample.trace";
+
+// replayTrace: Feed the records to cache; returns ops/sec
+// mismatches counts results that differ from the recorded ones, 0 for a deterministic replay
+// of a trace that started with an empty cache
+template <typename CacheType>
+double replayTrace(CacheType& cache, const vector<TraceRecord>& records, double speed,
+                   LatencyStats& stats, long long& mismatches) {
+    double nsPerTick = TscClock::nsPerTick();
+    mismatches = 0;
+    uint64_t start = TscClock::ticks();
+    uint64_t end = start;
+    for (unsigned int i = 0; i < records.size(); i++) {
+        uint64_t begin = TscClock::ticks();
+        uint64_t due = begin;
+        if (speed > 0) {
+            due = start + (uint64_t)(records[i].m_timeNs / speed / nsPerTick);
+            while (begin < due) {
+                begin = TscClock::ticks();
+            }
+        }
+        bool ok = applyTraceRecord(cache, records[i]);
+        end = TscClock::ticks();
+        stats.recordNs((uint64_t)((end - due) * nsPerTick));
+        mismatches += ok != records[i].m_ok ? 1 : 0;
+    }
+    double seconds = (end - start) * nsPerTick / 1e9;
+    return seconds > 0 ? records.size() / seconds : 0;
+}
+
+// paceName: "max" or the speed factor, e.g. "2.5x"
+string paceName(double speed) {
+    if (speed <= 0) {
+        return "max";
+    }
+    ostringstream name;
+    name << speed << "x";
+    return name.str();
+}
+
+// reportReplay: One result line and one CSV row
+void reportReplay(const string& label, const string& probing, int capacity, double speed,
+                  unsigned int records, double opsPerSec, const LatencyStats& stats, long long mismatches) {
+    cout << "  " << left << setw(20) << label << setw(11) << probing << right << setw(8) << capacity
+         << fixed << setprecision(0) << setw(12) << opsPerSec << setprecision(3)
+         << setw(10) << stats.getP50() << setw(11) << stats.getP99() << setw(12) << stats.getP999()
+         << setw(12) << stats.getMax() << setw(12) << mismatches << endl;
+    ofstream file("results/replay.csv", ios::app);
+    file << label << "," << probing << "," << capacity << ","
+         << paceName(speed) << "," << records << ","
+         << fixed << setprecision(0) << opsPerSec << "," << setprecision(3)
+         << stats.getP50() << "," << stats.getP99() << "," << stats.getP999() << ","
+         << stats.getMax() << "," << mismatches << endl;
+    file.close();
+}
+
+// recordSampleTrace: Capture a YCSB A run, loading included, through TracingCache
+bool recordSampleTrace(const string& path) {
+    Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+    TraceWriter writer(path);
+    TracingCache traced(cache, writer);
+    LatencyStats unused;
+    runWorkload(traced, WorkloadSpec::preset('A'), unused);
+    return writer.flush();
+}
+
+void benchmarkReplay(const string& path, const vector<double>& speeds, int capacity) {
+    cout << "\n========================================" << endl;
+    cout << "BENCHMARK 10: Trace Replay" << endl;
+    cout << "========================================" << endl;
+    string tracePath = path;
+    if (tracePath == "") {
+        tracePath = SAMPLE_TRACE;
+        cout << "Recording a YCSB A run to " << tracePath << "..." << endl;
+        if (recordSampleTrace(tracePath) == false) {
+            cerr << "Cannot write " << tracePath << endl;
+            return;
+        }
+    }
+    vector<TraceRecord> records;
+    TraceReader reader(tracePath);
+    if (reader.isOpen() == false) {
+        cerr << "Cannot read a trace from " << tracePath << endl;
+        return;
+    }
+    TraceRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        cerr << tracePath << " holds no operations" << endl;
+        return;
+    }
+    cout << records.size() << " operations over " << fixed << setprecision(3)
+         << records.back().m_timeNs / 1e9 << " s from " << tracePath
+         << (reader.truncated() ? " (cut-off record at the end dropped)" : "") << endl;
+
+    const prob_t policies[] = {QUADRATIC, DOUBLEHASH, LINEAR};
+    const char* policyNames[] = {"quadratic", "doublehash", "linear"};
+    for (unsigned int s = 0; s < speeds.size(); s++) {
+        double speed = speeds[s];
+        cout << "\n  Pacing: " << (speed > 0 ? paceName(speed) + " recorded speed" : string("maximum speed")) << endl;
+        cout << "  " << left << setw(20) << "implementation" << setw(11) << "probing" << right
+             << setw(8) << "size" << setw(12) << "ops/sec" << setw(10) << "P50 μs" << setw(11) << "P99 μs"
+             << setw(12) << "P99.9 μs" << setw(12) << "Max μs" << setw(12) << "mismatches" << endl;
+        for (int p = 0; p < 3; p++) {
+            Cache cache(capacity, hashCode, policies[p]);
+            LatencyStats stats;
+            long long mismatches;
+            double ops = replayTrace(cache, records, speed, stats, mismatches);
+            reportReplay("Incremental", policyNames[p], capacity, speed, records.size(), ops, stats, mismatches);
+        }
+        {
+            // Sized for the largest table up front, so the replay never rehashes
+            Cache cache(MAXPRIME, hashCode, DOUBLEHASH);
+            LatencyStats stats;
+            long long mismatches;
+            double ops = replayTrace(cache, records, speed, stats, mismatches);
+            reportReplay("Incremental", "doublehash", MAXPRIME, speed, records.size(), ops, stats, mismatches);
+        }
+        {
+            NaiveCache cache(capacity, hashCode, DOUBLEHASH);
+            LatencyStats stats;
+            long long mismatches;
+            double ops = replayTrace(cache, records, speed, stats, mismatches);
+            reportReplay("Naive", "doublehash", capacity, speed, records.size(), ops, stats, mismatches);
+        }
+        {
+            StdMapCache cache;
+            LatencyStats stats;
+            long long mismatches;
+            double ops = replayTrace(cache, records, speed, stats, mismatches);
+            reportReplay("std_unordered_map", "-", 0, speed, records.size(), ops, stats, mismatches);
+        }
+    }
+
+    cout << "\n✓ Trace replay benchmark complete!" << endl;
+}
+
 // ===================================================================
 // Print Summary
 // ===================================================================
@@ -362,6 +1439,13 @@ void printSummary() {
     cout << "   - latency.csv" << endl;
     cout << "   - throughput.csv" << endl;
     cout << "   - spikes.csv" << endl;
+    cout << "   - contention.csv" << endl;
+    cout << "   - operations.csv" << endl;
+    cout << "   - mixed.csv" << endl;
+    cout << "   - ycsb.csv" << endl;
+    cout << "   - scaling.csv" << endl;
+    cout << "   - openloop.csv" << endl;
+    cout << "   - replay.csv" << endl;
     
     cout << "\n3. Next steps:" << endl;
     cout << "   - Review CSV files for detailed data" << endl;
@@ -372,12 +1456,96 @@ void printSummary() {
 // ===================================================================
 // MAIN
 // ===================================================================
-int main() {
+// Usage: ./benchmark                                  all benchmarks
+//        ./benchmark mix READ INSERT REMOVE UPDATE      only the mixed workload, percentages
+//        ./benchmark ycsb [A-F|all] [RECORDS] [OPERATIONS] [uniform|zipfian|hotspot|latest]
+//                                                     only YCSB, default all six presets
+//        ./benchmark scaling [THREADS] [OPS_PER_THREAD] [A-F]
+//                                                     only the thread scaling, default YCSB B
+//        ./benchmark openloop [OPERATIONS] [A-F]     only the open-loop rate sweep, default half
+//                                                     reads and half inserts
+//        ./benchmark replay [TRACE] [max|SPEED] [CAPACITY]
+//                                                     only the trace replay, default a recorded
+//                                                     YCSB A run at maximum and recorded speed
+int main(int argc, char* argv[]) {
+    vector<WorkloadMix> mixes = {
+        {"read-mostly", 95, 3, 1, 1},
+        {"balanced", 50, 25, 15, 10},
+        {"write-heavy", 10, 50, 30, 10},
+    };
+    vector<WorkloadSpec> workloads;
+    for (char w = 'A'; w <= 'F'; w++) {
+        workloads.push_back(WorkloadSpec::preset(w));
+    }
+    string only = (argc > 1) ? argv[1] : "";
+    if (only == "mix") {
+        if (argc != 6) {
+            cerr << "Usage: " << argv[0] << " mix READ INSERT REMOVE UPDATE" << endl;
+            return 1;
+        }
+        WorkloadMix custom = {"custom", atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), atoi(argv[5])};
+        if (custom.readPct < 0 || custom.insertPct < 0 || custom.removePct < 0 || custom.updatePct < 0 ||
+            custom.readPct + custom.insertPct + custom.removePct + custom.updatePct != 100) {
+            cerr << "The four percentages must be non-negative and add up to 100" << endl;
+            return 1;
+        }
+        mixes.assign(1, custom);
+    } else if (only == "ycsb") {
+        string which = (argc > 2) ? argv[2] : "all";
+        if (which != "all") {
+            if (which.size() != 1 || toupper(which[0]) < 'A' || toupper(which[0]) > 'F') {
+                cerr << "Usage: " << argv[0] << " ycsb [A-F|all] [RECORDS] [OPERATIONS] [POPULARITY]" << endl;
+                return 1;
+            }
+            workloads.assign(1, WorkloadSpec::preset(which[0]));
+        }
+        const char* popularity[] = {"uniform", "zipfian", "hotspot", "latest"};
+        for (unsigned int w = 0; w < workloads.size(); w++) {
+            // The Cache tops out at MAXPRIME slots, half of them live
+            if (argc > 3) workloads[w].recordCount = max(1, min(atoi(argv[3]), MAXPRIME / 4));
+            if (argc > 4) workloads[w].operationCount = max(1, min(atoi(argv[4]), 10000000));
+            for (int p = 0; argc > 5 && p < 4; p++) {
+                if (string(argv[5]) == popularity[p]) {
+                    workloads[w].popularity = (popularity_t)p;
+                }
+            }
+        }
+    } else if (only == "scaling") {
+        if (argc > 4 && (strlen(argv[4]) != 1 || toupper(argv[4][0]) < 'A' || toupper(argv[4][0]) > 'F')) {
+            cerr << "Usage: " << argv[0] << " scaling [THREADS] [OPS_PER_THREAD] [A-F]" << endl;
+            return 1;
+        }
+    } else if (only == "openloop") {
+        if (argc > 3 && (strlen(argv[3]) != 1 || toupper(argv[3][0]) < 'A' || toupper(argv[3][0]) > 'F')) {
+            cerr << "Usage: " << argv[0] << " openloop [OPERATIONS] [A-F]" << endl;
+            return 1;
+        }
+    } else if (only == "replay") {
+        if ((argc > 3 && string(argv[3]) != "max" && atof(argv[3]) <= 0) || (argc > 4 && atoi(argv[4]) < 1)) {
+            cerr << "Usage: " << argv[0] << " replay [TRACE] [max|SPEED] [CAPACITY]" << endl;
+            return 1;
+        }
+    } else if (only != "") {
+        cerr << "Unknown benchmark " << only << endl;
+        return 1;
+    }
     cout << "========================================" << endl;
     cout << "   HASH TABLE BENCHMARK SUITE" << endl;
     cout << "   Comparing Incremental vs Full Rehashing" << endl;
     cout << "========================================" << endl;
-    cout << "\nThis will run 3 comprehensive benchmarks." << endl;
+    if (only == "mix") {
+        cout << "\nRunning the mixed workload benchmark only." << endl;
+    } else if (only == "ycsb") {
+        cout << "\nRunning the YCSB benchmark only." << endl;
+    } else if (only == "scaling") {
+        cout << "\nRunning the scaling benchmark only." << endl;
+    } else if (only == "openloop") {
+        cout << "\nRunning the open-loop benchmark only." << endl;
+    } else if (only == "replay") {
+        cout << "\nRunning the trace replay benchmark only." << endl;
+    } else {
+        cout << "\nThis will run 10 comprehensive benchmarks." << endl;
+    }
     cout << "Estimated time: 2-3 minutes\n" << endl;
     
     // Create results directory (cross-platform)
@@ -388,6 +1556,65 @@ int main() {
     #endif
     
     // Initialize CSV files with headers
+    ofstream replayFile("results/replay.csv");
+    replayFile << "Implementation,Probing,Capacity,Pacing,Records,OpsPerSecond,P50,P99,P999,Max,Mismatches" << endl;
+    replayFile.close();
+    
+    // Maximum speed, then the recorded pacing
+    vector<double> replaySpeeds = {0, 1};
+    if (only == "replay") {
+        if (argc > 3) {
+            replaySpeeds.assign(1, string(argv[3]) == "max" ? 0 : atof(argv[3]));
+        }
+        int capacity = (argc > 4) ? atoi(argv[4]) : MINPRIME;
+        benchmarkReplay(argc > 2 ? argv[2] : "", replaySpeeds, capacity);
+        return 0;
+    }
+    
+    ofstream openLoopFile("results/openloop.csv");
+    openLoopFile << "Implementation,Workload,TargetOpsPerSecond,AchievedOpsPerSecond,P50,P99,P999,Max,"
+                    "ServiceP99,ServiceMax" << endl;
+    openLoopFile.close();
+    
+    WorkloadSpec openLoop = openLoopSpec();
+    if (only == "openloop") {
+        if (argc > 3) {
+            openLoop = WorkloadSpec::preset(argv[3][0]);
+        }
+        // Inserts past MAXPRIME / 4 live entries turn into reads
+        openLoop.operationCount = (argc > 2) ? max(1, min(atoi(argv[2]), 10000000)) : OPENLOOP_OPERATIONS;
+        benchmarkOpenLoop(openLoop);
+        return 0;
+    }
+    
+    ofstream mixedFile("results/mixed.csv");
+    mixedFile << "Implementation,Workload,OpsPerSecond,P50,P99,P999,Max" << endl;
+    mixedFile.close();
+    
+    ofstream scalingFile("results/scaling.csv");
+    scalingFile << "Implementation,Workload,Threads,OpsPerSecond,Efficiency,P50,P99,P999,WorstThreadP999" << endl;
+    scalingFile.close();
+    
+    int maxThreads = max(1, (int)thread::hardware_concurrency());
+    if (only == "scaling") {
+        if (argc > 2) maxThreads = max(1, atoi(argv[2]));
+        int opsPerThread = (argc > 3) ? max(1, atoi(argv[3])) : SCALING_OPS_PER_THREAD;
+        benchmarkScaling(WorkloadSpec::preset(argc > 4 ? argv[4][0] : 'B'), maxThreads, opsPerThread);
+        return 0;
+    }
+    
+    ofstream ycsbFile("results/ycsb.csv");
+    ycsbFile << "Implementation,Workload,Popularity,Records,Operations,OpsPerSecond,P50,P99,P999,Max" << endl;
+    ycsbFile.close();
+    
+    if (only == "mix") {
+        benchmarkMixed(mixes);
+        return 0;
+    } else if (only == "ycsb") {
+        benchmarkYCSB(workloads);
+        return 0;
+    }
+    
     ofstream latencyFile("results/latency.csv");
     latencyFile << "Implementation,Operations,Average,P50,P95,P99,Max" << endl;
     latencyFile.close();
@@ -400,10 +1627,25 @@ int main() {
     spikesFile << "Implementation,BeforeMax,DuringMax,SpikeRatio" << endl;
     spikesFile.close();
     
+    ofstream contentionFile("results/contention.csv");
+    contentionFile << "Implementation,Threads,OpsPerSecond" << endl;
+    contentionFile.close();
+    
+    ofstream operationsFile("results/operations.csv");
+    operationsFile << "Implementation,Operation,Operations,Average,P50,P95,P99,Max" << endl;
+    operationsFile.close();
+    
     // Run benchmarks
     benchmarkInsertionLatency();
     benchmarkThroughput();
     benchmarkRehashingSpikes();
+    benchmarkContention();
+    benchmarkOperations();
+    benchmarkMixed(mixes);
+    benchmarkYCSB(workloads);
+    benchmarkScaling(WorkloadSpec::preset('B'), maxThreads, SCALING_OPS_PER_THREAD);
+    benchmarkOpenLoop(openLoop);
+    benchmarkReplay("", replaySpeeds, MINPRIME);
     
     // Print summary
     printSummary();
@@ -10,102 +10,247 @@
 #include <fstream>
 #include <iomanip>
 #include <random>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <cctype>
+#include <stdint.h>
 #include "cache.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define BENCH_TSC 1
+#endif
 
 using namespace std;
 using namespace std::chrono;
 
+// ===================================================================
+// Time stamp counter clock, calibrated against steady_clock once
+// ===================================================================
+class TscClock {
+public:
+    // Current tick count; steady_clock nanoseconds when the TSC is not usable
+    static uint64_t ticks() {
+#ifdef BENCH_TSC
+        if (usingTsc()) {
+            _mm_lfence();   // keep earlier instructions out of the measurement
+            return __rdtsc();
+        }
+#endif
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // True if ticks() reads the TSC
+    static bool usingTsc() {
+        return tscRate() > 0;
+    }
+
+    // Nanoseconds per tick
+    static double nsPerTick() {
+        return usingTsc() ? tscRate() : 1.0;
+    }
+
+private:
+    // Nanoseconds per TSC tick, measured on the first call (about 10ms), 0 if not usable
+    static double tscRate() {
+        static const double rate = calibrate();
+        return rate;
+    }
+
+    // Only an invariant TSC ticks at a constant rate through frequency changes
+    static double calibrate() {
+#ifdef BENCH_TSC
+        unsigned int a, b, c, d;
+        if (__get_cpuid(0x80000007, &a, &b, &c, &d) == 0 || (d & (1u << 8)) == 0) {
+            return 0;
+        }
+        steady_clock::time_point wallStart = steady_clock::now();
+        uint64_t tscStart = __rdtsc();
+        while (steady_clock::now() - wallStart < milliseconds(10)) {
+        }
+        uint64_t tscEnd = __rdtsc();
+        double ns = duration_cast<nanoseconds>(steady_clock::now() - wallStart).count();
+        return tscEnd > tscStart ? ns / double(tscEnd - tscStart) : 0;
+#else
+        return 0;
+#endif
+    }
+};
+
 // ===================================================================
 // Timer class for measuring operation latency
 // ===================================================================
 class Timer {
 private:
-    high_resolution_clock::time_point m_start;
-    
+    uint64_t m_start;   // TscClock ticks
+
 public:
     // Start the timer
     void start() {
-        m_start = high_resolution_clock::now();
+        m_start = TscClock::ticks();
     }
-    
-    // Returns elapsed time in microseconds (μs)
+
+    // Returns elapsed time in nanoseconds
+    double elapsedNs() {
+        return double(TscClock::ticks() - m_start) * TscClock::nsPerTick();
+    }
+
+    // Returns elapsed time in microseconds (μs), with the fraction kept
     // 1 second = 1,000,000 microseconds
     double elapsed() {
-        auto end = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(end - m_start);
-        return duration.count();
+        return elapsedNs() / 1000.0;
     }
 };
 
 // ===================================================================
 // Statistics calculator for latency measurements
+// HDR histogram over nanoseconds: values below 2048ns are counted exactly, larger ones in
+// buckets 1/1024 of their magnitude wide, up to about 68 seconds. Recording is O(1), memory
+// is fixed (about 216KB) and histograms of several threads merge by adding counts.
+// Percentiles report the highest value of their bucket; the average, min and max are exact.
 // ===================================================================
+const int HDRSUBBITS = 11;                          // 2048 sub-buckets, 3 significant digits
+const int HDRSUB = 1 << HDRSUBBITS;
+const int HDRHALF = HDRSUB / 2;
+const int HDRMAXBITS = 36;                          // largest value tracked: 2^36 ns
+const int HDRBUCKETS = HDRSUB + (HDRMAXBITS - HDRSUBBITS) * HDRHALF;
+
 class LatencyStats {
 private:
-    vector<double> m_latencies; // stores all latencies in microseconds
-    
+    vector<uint64_t> m_counts;  // HDRBUCKETS counters
+    uint64_t m_total;
+    double   m_sumNs;
+    uint64_t m_minNs;
+    uint64_t m_maxNs;
+
+    // Counter of a value
+    static int bucketOf(uint64_t ns) {
+        if (ns < (uint64_t)HDRSUB) {
+            return (int)ns;
+        }
+        int msb = 63 - __builtin_clzll(ns);
+        if (msb >= HDRMAXBITS) {
+            return HDRBUCKETS - 1;
+        }
+        int shift = msb - (HDRSUBBITS - 1);
+        return HDRSUB + (shift - 1) * HDRHALF + (int)((ns >> shift) - HDRHALF);
+    }
+
+    // Highest value counted by a bucket
+    static uint64_t highestOf(int bucket) {
+        if (bucket < HDRSUB) {
+            return bucket;
+        }
+        int shift = (bucket - HDRSUB) / HDRHALF + 1;
+        uint64_t sub = (bucket - HDRSUB) % HDRHALF + HDRHALF;
+        return ((sub + 1) << shift) - 1;
+    }
+
 public:
-    // Record a single latency measurement
+    LatencyStats() : m_counts(HDRBUCKETS, 0) {
+        clear();
+    }
+
+    // Record a single latency measurement in microseconds
     void record(double latency) {
-        m_latencies.push_back(latency);
+        recordNs(latency <= 0 ? 0 : (uint64_t)(latency * 1000.0 + 0.5));
     }
-    
+
+    // Record a single latency measurement in nanoseconds
+    void recordNs(uint64_t ns) {
+        m_counts[bucketOf(ns)]++;
+        m_total++;
+        m_sumNs += ns;
+        m_minNs = ns < m_minNs ? ns : m_minNs;
+        m_maxNs = ns > m_maxNs ? ns : m_maxNs;
+    }
+
+    // Add the samples of another histogram, e.g. one per thread
+    void merge(const LatencyStats& other) {
+        for (int b = 0; b < HDRBUCKETS; b++) {
+            m_counts[b] += other.m_counts[b];
+        }
+        m_total += other.m_total;
+        m_sumNs += other.m_sumNs;
+        m_minNs = other.m_minNs < m_minNs ? other.m_minNs : m_minNs;
+        m_maxNs = other.m_maxNs > m_maxNs ? other.m_maxNs : m_maxNs;
+    }
+
     // Clear all recorded data
     void clear() {
-        m_latencies.clear();
+        fill(m_counts.begin(), m_counts.end(), 0);
+        m_total = 0;
+        m_sumNs = 0;
+        m_minNs = UINT64_MAX;
+        m_maxNs = 0;
     }
-    
+
     // Calculate average latency
     double getAverage() const {
-        if (m_latencies.empty()) return 0.0;
-        double sum = accumulate(m_latencies.begin(), m_latencies.end(), 0.0);
-        return sum / m_latencies.size();
+        if (m_total == 0) return 0.0;
+        return m_sumNs / m_total / 1000.0;
     }
-    
+
+    // Get a specific percentile in nanoseconds
+    // percentile should be between 0.0 and 1.0
+    uint64_t getPercentileNs(double percentile) const {
+        if (m_total == 0) return 0;
+        uint64_t rank = (uint64_t)ceil(percentile * m_total);
+        rank = rank < 1 ? 1 : (rank > m_total ? m_total : rank);
+        uint64_t seen = 0;
+        for (int b = 0; b < HDRBUCKETS; b++) {
+            seen += m_counts[b];
+            if (seen >= rank) {
+                uint64_t value = highestOf(b);
+                value = value > m_maxNs ? m_maxNs : value;
+                return value < m_minNs ? m_minNs : value;
+            }
+        }
+        return m_maxNs;
+    }
+
     // Get a specific percentile
     // percentile should be between 0.0 and 1.0
     // Example: 0.99 for P99 (99th percentile)
     double getPercentile(double percentile) const {
-        if (m_latencies.empty()) return 0.0;
-        
-        // Make a sorted copy of the latencies
-        vector<double> sorted = m_latencies;
-        sort(sorted.begin(), sorted.end());
-        
-        // Calculate the index for this percentile
-        size_t index = (size_t)(percentile * sorted.size());
-        if (index >= sorted.size()) index = sorted.size() - 1;
-        
-        return sorted[index];
+        return getPercentileNs(percentile) / 1000.0;
     }
-    
+
     // Convenience functions for common percentiles
     double getP50() const { return getPercentile(0.50); }  // Median
     double getP95() const { return getPercentile(0.95); }  // 95th percentile
     double getP99() const { return getPercentile(0.99); }  // 99th percentile
-    double getMax() const { return getPercentile(1.0); }   // Maximum value
-    
+    double getP999() const { return getPercentile(0.999); }
+    double getMin() const { return m_total == 0 ? 0.0 : m_minNs / 1000.0; }
+    double getMax() const { return m_maxNs / 1000.0; }     // Maximum value
+
     // Get the number of recorded operations
-    size_t count() const { return m_latencies.size(); }
-    
+    size_t count() const { return m_total; }
+
     // Print a summary of statistics to console
     void printSummary(const string& name) const {
         cout << "\n=== " << name << " ===" << endl;
         cout << "Operations: " << count() << endl;
-        cout << fixed << setprecision(2);
+        cout << fixed << setprecision(3);
         cout << "Average:    " << getAverage() << " μs" << endl;
         cout << "P50:        " << getP50() << " μs" << endl;
         cout << "P95:        " << getP95() << " μs" << endl;
         cout << "P99:        " << getP99() << " μs" << endl;
+        cout << "P99.9:      " << getP999() << " μs" << endl;
         cout << "Max:        " << getMax() << " μs" << endl;
     }
-    
+
     // Save statistics to CSV file for later graphing
     void saveToCSV(const string& filename, const string& label) const {
         ofstream file(filename, ios::app); // append mode
         file << label << ","
              << count() << ","
-             << fixed << setprecision(2)
+             << fixed << setprecision(3)
              << getAverage() << ","
              << getP50() << ","
              << getP95() << ","
@@ -143,6 +288,14 @@ public:
         return Person(key, id, true);
     }
     
+    // Generate a Person whose key no other index gets
+    // generatePerson draws from 8 keys, so every entry of one key shares a probe sequence
+    Person generateUniquePerson(int index) {
+        string key = searchStr[m_keyDist(m_generator)] + "_" + to_string(index);
+        int id = m_idDist(m_generator);
+        return Person(key, id, true);
+    }
+    
     // Generate a batch of random Persons
     vector<Person> generateBatch(int count) {
         vector<Person> batch;
@@ -154,4 +307,253 @@ public:
     }
 };
 
+// ===================================================================
+// YCSB-style workload generator
+// Key popularity follows the YCSB core workloads: uniform, scrambled Zipfian (popular keys
+// spread over the key space), hotspot (a hot set gets most operations) or latest (Zipfian
+// over recency, the newest keys are the most popular). Keys are "user" plus a scrambled
+// record number, padded to a length drawn between the minimum and maximum.
+// ===================================================================
+enum ycsb_op_t {YCSB_READ, YCSB_UPDATE, YCSB_INSERT, YCSB_SCAN, YCSB_RMW};
+enum popularity_t {POP_UNIFORM, POP_ZIPFIAN, POP_HOTSPOT, POP_LATEST};
+
+struct WorkloadSpec {
+    string name;
+    int recordCount;            // keys loaded before the run
+    int operationCount;
+    // Operation mix, the proportions add up to 1
+    double readProportion;
+    double updateProportion;    // updateID to a new ID
+    double insertProportion;    // a new key
+    double scanProportion;      // gets of consecutive records
+    double rmwProportion;       // getPerson, then updateID
+    popularity_t popularity;
+    double zipfianConstant;     // 0.99 in YCSB
+    double hotsetFraction;      // hotspot: share of the keys that is hot ...
+    double hotOpnFraction;      // ... and the share of operations that go to it
+    int minKeyLength;
+    int maxKeyLength;
+    int maxScanLength;          // scan lengths are uniform in 1..maxScanLength
+
+    // Defaults of the YCSB core workload with an empty mix
+    WorkloadSpec()
+        : name("custom"), recordCount(10000), operationCount(50000),
+          readProportion(0), updateProportion(0), insertProportion(0),
+          scanProportion(0), rmwProportion(0), popularity(POP_ZIPFIAN),
+          zipfianConstant(0.99), hotsetFraction(0.2), hotOpnFraction(0.8),
+          minKeyLength(8), maxKeyLength(24), maxScanLength(100) {
+    }
+
+    // YCSB core workloads A to F
+    static WorkloadSpec preset(char workload) {
+        WorkloadSpec spec;
+        spec.name = string("ycsb-") + (char)toupper(workload);
+        switch (toupper(workload)) {
+        case 'A':   // update heavy
+            spec.readProportion = 0.5;
+            spec.updateProportion = 0.5;
+            break;
+        case 'B':   // read mostly
+            spec.readProportion = 0.95;
+            spec.updateProportion = 0.05;
+            break;
+        case 'C':   // read only
+            spec.readProportion = 1.0;
+            break;
+        case 'D':   // read latest
+            spec.readProportion = 0.95;
+            spec.insertProportion = 0.05;
+            spec.popularity = POP_LATEST;
+            break;
+        case 'E':   // short ranges
+            spec.scanProportion = 0.95;
+            spec.insertProportion = 0.05;
+            break;
+        default:    // 'F': read-modify-write
+            spec.readProportion = 0.5;
+            spec.rmwProportion = 0.5;
+            break;
+        }
+        return spec;
+    }
+};
+
+struct WorkloadOp {
+    ycsb_op_t op;
+    int record;         // record number; for inserts the new one
+    int scanLength;
+};
+
+// Zipfian ranks 0..n-1 after Gray et al., as in YCSB; n may grow between calls
+class ZipfianGenerator {
+private:
+    double m_theta;
+    double m_zeta2;
+    double m_zetaN;
+    long long m_n;
+
+    void extendZeta(long long n) {
+        for (long long i = m_n + 1; i <= n; i++) {
+            m_zetaN += 1.0 / pow((double)i, m_theta);
+        }
+        m_n = n;
+    }
+
+public:
+    ZipfianGenerator(double theta = 0.99) : m_theta(theta), m_zetaN(0), m_n(0) {
+        m_zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+    }
+
+    // Rank for a uniform u in [0, 1), rank 0 is the most popular
+    long long next(long long n, double u) {
+        if (n > m_n) {
+            extendZeta(n);
+        }
+        double alpha = 1.0 / (1.0 - m_theta);
+        double eta = (1.0 - pow(2.0 / n, 1.0 - m_theta)) / (1.0 - m_zeta2 / m_zetaN);
+        double uz = u * m_zetaN;
+        if (uz < 1.0) return 0;
+        if (uz < m_zeta2) return n > 1 ? 1 : 0;
+        long long rank = (long long)(n * pow(eta * u - eta + 1.0, alpha));
+        return rank < n ? rank : n - 1;
+    }
+};
+
+class WorkloadGenerator {
+private:
+    WorkloadSpec m_spec;
+    mt19937_64 m_rng;
+    uniform_real_distribution<double> m_unit;
+    ZipfianGenerator m_zipf;
+    int m_records;              // records that exist: loaded plus inserted
+
+    // 64-bit FNV-1a of the record number, scrambles Zipfian ranks and key names
+    static uint64_t scramble(uint64_t value) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (int i = 0; i < 8; i++) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    // chooseRecord: A record number by the popularity distribution
+    int chooseRecord() {
+        double u = m_unit(m_rng);
+        if (m_spec.popularity == POP_UNIFORM) {
+            return (int)(u * m_records);
+        } else if (m_spec.popularity == POP_HOTSPOT) {
+            int hot = (int)(m_records * m_spec.hotsetFraction);
+            hot = hot < 1 ? 1 : hot;
+            double v = m_unit(m_rng);
+            if (u < m_spec.hotOpnFraction || hot == m_records) {
+                return (int)(v * hot);
+            }
+            return hot + (int)(v * (m_records - hot));
+        } else if (m_spec.popularity == POP_LATEST) {
+            return m_records - 1 - (int)m_zipf.next(m_records, u);
+        }
+        // Scrambled Zipfian: ranks are drawn over a fixed space so popularity does not
+        // shift as records are added, then spread over the records by a hash
+        long long rank = m_zipf.next(m_spec.recordCount, u);
+        return (int)(scramble(rank) % m_records);
+    }
+
+public:
+    WorkloadGenerator(const WorkloadSpec& spec, int seed = 42)
+        : m_spec(spec), m_rng(seed), m_unit(0.0, 1.0), m_zipf(spec.zipfianConstant),
+          m_records(spec.recordCount) {
+    }
+
+    const WorkloadSpec& spec() const { return m_spec; }
+    int recordCount() const { return m_records; }
+
+    // Key of a record, the same for every generator with this spec
+    string keyOf(int record) const {
+        string key = "user" + to_string(scramble(record) % 1000000007ull) + "_" + to_string(record);
+        int span = m_spec.maxKeyLength - m_spec.minKeyLength + 1;
+        int length = m_spec.minKeyLength + (span > 1 ? (int)(scramble(record + 0x9e3779b9ull) % span) : 0);
+        // Padding keeps the number at the end, so keys stay distinct at any length
+        if ((int)key.size() < length) {
+            key.insert(4, string(length - key.size(), 'x'));
+        }
+        return key;
+    }
+
+    // The record with its initial ID, for loading and for inserts
+    Person record(int record) const {
+        return Person(keyOf(record), MINID + (int)(scramble(record) % (MAXID - MINID + 1)), true);
+    }
+
+    // next: The next operation of the run
+    WorkloadOp next() {
+        WorkloadOp op;
+        op.scanLength = 0;
+        double roll = m_unit(m_rng);
+        double insertEdge = m_spec.readProportion + m_spec.updateProportion + m_spec.insertProportion;
+        if (roll >= m_spec.readProportion + m_spec.updateProportion && roll < insertEdge) {
+            op.op = YCSB_INSERT;
+            op.record = m_records++;
+            return op;
+        }
+        op.record = chooseRecord();
+        if (roll < m_spec.readProportion) {
+            op.op = YCSB_READ;
+        } else if (roll < m_spec.readProportion + m_spec.updateProportion) {
+            op.op = YCSB_UPDATE;
+        } else if (roll < insertEdge + m_spec.scanProportion) {
+            op.op = YCSB_SCAN;
+            op.scanLength = 1 + (int)(m_unit(m_rng) * m_spec.maxScanLength);
+        } else {
+            op.op = YCSB_RMW;
+        }
+        return op;
+    }
+};
+
+// ===================================================================
+// Thread helpers for the multi-threaded benchmarks
+// ===================================================================
+// pinThread: Bind the calling thread to a core, modulo the core count (Linux only)
+inline bool pinThread(int core) {
+#ifdef __linux__
+    int cores = thread::hardware_concurrency();
+    if (cores > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core % cores, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+#endif
+    return false;
+}
+
+// Start line for worker threads: each calls arrive() once it is set up and waits there;
+// the coordinator waits for all of them, takes the start time and calls release()
+class StartBarrier {
+private:
+    atomic<int>  m_ready;
+    atomic<bool> m_go;
+
+public:
+    StartBarrier() : m_ready(0), m_go(false) {}
+
+    void arrive() {
+        m_ready.fetch_add(1);
+        while (m_go.load(memory_order_acquire) == false) {
+            this_thread::yield();
+        }
+    }
+
+    void waitForAll(int workers) {
+        while (m_ready.load() < workers) {
+            this_thread::yield();
+        }
+    }
+
+    void release() {
+        m_go.store(true, memory_order_release);
+    }
+};
+
 #endif // BENCHMARK_UTILS_H
@@ -1,4 +1,11 @@
 #include "cache.h"
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
 // Constructor
 Cache::Cache(int size, hash_fn hash, prob_t probing = DEFPOLCY){
     // Store hash
@@ -31,9 +38,45 @@ Cache::Cache(int size, hash_fn hash, prob_t probing = DEFPOLCY){
     m_oldProbing = m_currProbing;
     // Initialize transfer index
     m_transferIndex = 0;
+    m_deferTransfer = false;
+    m_rehashEpoch = 1;
+    // Unbounded until setMaxEntries is called
+    m_maxEntries = 0;
+    m_evictPolicy = NOEVICT;
+    m_lruHead = nullptr;
+    m_lruTail = nullptr;
+    m_clockHand = 0;
+    m_oldHand = 0;
+    m_evictDebt = 0;
+    // Admission filter is off until setAdmissionFilter is called
+    m_admission = false;
+    m_windowHead = nullptr;
+    m_windowTail = nullptr;
+    m_windowCount = 0;
+    m_windowCap = 1;
+    // The timing wheel turns with the steady clock
+    m_timers.reset(nowMs());
+    // Negative lookup filters are off until setNegativeFilter is called
+    m_negFilter = false;
+    // So is the ID index
+    m_useIDIndex = false;
+    // Key groups start with the first getAllByKey or setKeyGroups call
+    m_keyGroups = false;
+    m_log = nullptr;
+    m_snapshotChild = 0;
+    m_snapshotOK = false;
+    m_opProbes = 0;
 }
+// Constructor: Built-in hash function
+Cache::Cache(int size, hashkind_t hash, prob_t probing) : Cache(size, builtinHash(hash), probing) {}
 // Destructor: Deallocates the memory
 Cache::~Cache(){
+    // Reap a running snapshot writer, it holds its own copy of the tables
+    waitSnapshot();
+    freeTables();
+}
+// freeTables: Deallocates both tables and every entry in them
+void Cache::freeTables(){
     if (m_currentTable != nullptr) {
         // Loop through array and deallocate all the memory
         for (int i = 0; i < m_currentCap; i++) {
@@ -75,24 +118,28 @@ void Cache::changeProbPolicy(prob_t policy){
 }
 //probeIndex: Get the right index
 int Cache::probeIndex(int hashedKey, int i, int capacity, prob_t policy) const {
-    int value = 0;
+    // hashedKey carries the unsigned hash value, widen it so the formulas below
+    // can neither go negative nor overflow for long probe sequences
+    unsigned long long key = (unsigned int)hashedKey;
+    unsigned long long step = i;
+    unsigned long long value = 0;
     // Linear probing formula
     if (policy == LINEAR) {
-        value = (hashedKey + i) % capacity;
+        value = (key + step) % capacity;
     // Quadratic probing formula
     } else if (policy == QUADRATIC) {
-        value = (hashedKey + i * i) % capacity;
+        value = (key + step * step) % capacity;
     // Double hashing formula
     } else if (policy == DOUBLEHASH) {
         // if secondary hash function is 0, then set it to 1 to prevent infinite loop
-        int dbValue = 11 - (hashedKey % 11);
+        unsigned long long dbValue = 11 - (key % 11);
         if (dbValue == 0) {
             dbValue = 1;
         }
         // Compute double hashing index
-        value = (hashedKey + i * dbValue) % capacity;
+        value = (key + step * dbValue) % capacity;
     }
-    return value;
+    return (int)value;
 }
 // locateInesrtionSlot: Probe table and get valid empty slot index
 int Cache::locateInsertionSlot(Person& p, Person** table, int capacity, prob_t policy) {
@@ -103,6 +150,7 @@ int Cache::locateInsertionSlot(Person& p, Person** table, int capacity, prob_t p
     for (int i = 0; i < capacity; i++) {
         // Get index based on probing method
         index = probeIndex(hashedKey, i, capacity, policy);
+        CACHE_STAT(m_opProbes++);
         // Check the index location in the table
         if (table[index] == nullptr) {
             return index;
@@ -138,6 +186,7 @@ bool Cache::personExists(Person& p, Person** table, int capacity, prob_t policy)
 
 // startNewHash: Initiate new hash when load factor exceeds 0.5 or deleted ratio exceeds 0.8
 void Cache::startNewRehash() {
+    CACHE_STAT(m_stats.m_rehashes++);
     // Move current table into old table
     m_oldTable = m_currentTable;
     m_oldCap = m_currentCap;
@@ -162,11 +211,29 @@ void Cache::startNewRehash() {
     m_currProbing = m_newPolicy;
     // Rehashing moves 25% of old table per opertion so reset transfer progress
     m_transferIndex = 0;
+    // Outstanding scan cursors refer to the previous generation now
+    m_rehashEpoch++;
+    if (m_rehashEpoch == 0) {
+        m_rehashEpoch = 1;
+    }
+    // The filter follows its table into the old generation
+    if (m_negFilter == true) {
+        m_oldFilter.swap(m_currFilter);
+        m_currFilter.resize(m_currentCap);
+    }
+    // The CLOCK hand follows the table it was sweeping into the old generation
+    m_oldHand = m_clockHand;
+    m_clockHand = 0;
     
 }
 // reinsertFromOld: Grab the person from old table and insert into current table
 void Cache::reinsertFromOld(Person* p) {
     int hashedKey = m_hash(p->getKey());
+    if (m_negFilter == true) {
+        unsigned long long fingerprint = mixHash((unsigned int)hashedKey);
+        m_oldFilter.remove(fingerprint);
+        m_currFilter.insert(fingerprint);
+    }
 
     for (int i = 0; i < m_currentCap; i++) {
         int index = probeIndex(hashedKey, i, m_currentCap, m_currProbing);
@@ -177,9 +244,11 @@ void Cache::reinsertFromOld(Person* p) {
             m_currentSize++;
             return;
         } else if (m_currentTable[index] != nullptr && m_currentTable[index]->m_used == false) {
+            // Reuse the deleted slot, it is already counted in m_currentSize
+            delete m_currentTable[index];
             m_currentTable[index] = p;
             m_currentTable[index]->m_used = true;
-            m_currentSize++;
+            m_currNumDeleted--;
             return;
         } else if (m_currentTable[index] != nullptr && m_currentTable[index]->m_used == true) {
             continue;
@@ -192,10 +261,24 @@ void Cache::transferPartOfTable() {
     if (m_oldTable == nullptr) {
         return;
     }
+    // Reinserting probes the new table, that is not the probe length of the calling operation
+    CACHE_STAT(int savedProbes = m_opProbes);
+    CACHE_STAT(chrono::steady_clock::time_point started = chrono::steady_clock::now());
     // Calculate the 25% that needs to be transferred
     int partToTransfer = floor(m_oldCap * 0.25);
     // Loop throught the old table
     for (int i = m_transferIndex; i < (m_transferIndex + partToTransfer) && i < m_oldCap; i++) {
+        // CLOCK mode: this pass doubles as the hand, unreferenced entries are evicted
+        // instead of moved while an insert still needs room
+        if (m_evictDebt > 0 && m_oldTable[i] != nullptr && m_oldTable[i]->m_used == true) {
+            if (m_oldTable[i]->m_ref == false) {
+                markDeleted(m_oldTable, i);
+                m_evictDebt--;
+                CACHE_STAT(m_stats.m_evictions++);
+            } else {
+                m_oldTable[i]->m_ref = false;
+            }
+        }
         // If the index contains a person
         if (m_oldTable[i] != nullptr && m_oldTable[i]->m_used == true) {
             // Store the person and insert into the new table
@@ -228,41 +311,116 @@ void Cache::transferPartOfTable() {
         m_oldCap = 0;
         m_oldSize = 0;
         m_oldNumDeleted = 0;
+        m_oldFilter.clear();
     }
+    CACHE_STAT(m_stats.m_transferSteps++);
+    CACHE_STAT(m_stats.m_transferNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count());
+    CACHE_STAT(m_opProbes = savedProbes);
 }
 
 // insert: Inserts an object into the current hash table
 bool Cache::insert(Person person){
+    return insert(person, 0);
+}
+// insert: Inserts an object that expires ttl milliseconds from now (never if ttl is 0)
+bool Cache::insert(Person person, int ttl){
+    CACHE_STAT(m_opProbes = 0);
+    // Validate ID
+    bool validID = (person.getID() >= MINID && person.getID() <= MAXID);
+    // Check is the person already exists in the current and old tables
+    // The transfer below only moves entries between the two tables, so the answer stays valid
+    // An expired copy does not count, it is reclaimed here
+    bool exists = false;
+    if (validID == true) {
+        int index = findPersonIndex(person, m_currentTable, m_currentCap, m_currProbing);
+        if (index >= 0 && isExpired(m_currentTable[index])) {
+            markDeleted(m_currentTable, index);
+            index = -1;
+        }
+        int oldIndex = -1;
+        if (index < 0 && m_oldTable != nullptr) {
+            oldIndex = findPersonIndex(person, m_oldTable, m_oldCap, m_oldProbing);
+            if (oldIndex >= 0 && isExpired(m_oldTable[oldIndex])) {
+                markDeleted(m_oldTable, oldIndex);
+                oldIndex = -1;
+            }
+        }
+        exists = (index >= 0 || oldIndex >= 0);
+    }
     // Insert causes the transfer
-    if (m_oldTable != nullptr) {
+    if (m_oldTable != nullptr && m_deferTransfer == false) {
+        // In CLOCK mode the transfer step also evicts the room this insert needs
+        if (validID == true && exists == false && m_evictPolicy == CLOCK && m_admission == false) {
+            m_evictDebt = liveCount() - m_maxEntries + 1;
+        }
         transferPartOfTable();
+        m_evictDebt = 0;
     }
-    // Validate ID
-    if (person.getID() < MINID || person.getID() > MAXID) {
-        return false;
-    }    
-    // Check is the person already exists in the current and old tables
-    if (personExists(person, m_currentTable, m_currentCap, m_currProbing) == true) {
-        return false;
-    } else if (m_oldTable != nullptr && personExists(person, m_oldTable, m_oldCap, m_oldProbing) == true) {
+    // Expiry work shares the per-operation budget with the transfer
+    if (m_deferTransfer == false) {
+        expireDue();
+    }
+    if (validID == false || exists == true) {
+        CACHE_STAT(m_stats.m_failedInserts++);
+        CACHE_STAT(recordProbes(STAT_INSERT));
         return false;
     }
+    // Bounded mode: make room before placing the new entry
+    // With the admission filter the new entry is placed first and competes for room afterwards
+    if (m_maxEntries > 0 && m_admission == false) {
+        while (liveCount() >= m_maxEntries && evictOne()) {}
+    }
     // Get the insertion spot
     int insertionSpot = locateInsertionSlot(person, m_currentTable, m_currentCap, m_currProbing);
     // Validate insertion spot
     if (insertionSpot == -1) {
+        CACHE_STAT(m_stats.m_failedInserts++);
+        CACHE_STAT(recordProbes(STAT_INSERT));
         return false;
     }
     // If the spot was previously used, then decrement the number deleted since the spot is now goin to be occupied again.
+    // The slot is already counted in m_currentSize, and its old object is no longer referenced.
     if (m_currentTable[insertionSpot] != nullptr && m_currentTable[insertionSpot]->m_used == false) {
         m_currNumDeleted--;
+        delete m_currentTable[insertionSpot];
+    } else {
+        m_currentSize++;
     }
     // Allocate new person
     Person* newPerson = new Person(person);
     // Insert to the spot and set values
     m_currentTable[insertionSpot] = newPerson;
     newPerson->m_used = true;
-    m_currentSize++;
+    if (m_negFilter == true) {
+        m_currFilter.insert(mixHash(m_hash(newPerson->m_key)));
+    }
+    // Entries move between the tables by pointer, so the index never needs updating for the transfer
+    if (m_useIDIndex == true) {
+        m_idIndex.insert(newPerson->m_id, newPerson);
+    }
+    if (m_keyGroups == true) {
+        linkKeyGroup(newPerson);
+    }
+    if (ttl > 0) {
+        newPerson->links().m_expireAt = nowMs() + ttl;
+        m_timers.schedule(newPerson->m_key, newPerson->m_id, newPerson->expireAt());
+    }
+    if (m_log != nullptr) {
+        // The log outlives the process, so the expiry is recorded in wall clock time
+        long long expireAt = 0;
+        if (ttl > 0) {
+            expireAt = chrono::duration_cast<chrono::milliseconds>(
+                chrono::system_clock::now().time_since_epoch()).count() + ttl;
+        }
+        logMutation(LOG_INSERT, newPerson->m_key, newPerson->m_id, expireAt);
+    }
+    trackEntry(newPerson);
+    CACHE_STAT(m_stats.m_inserts++);
+    CACHE_STAT(recordProbes(STAT_INSERT));
+    if (m_admission == true && m_maxEntries > 0) {
+        m_sketch.increment(sketchHash(newPerson->m_key, newPerson->m_id));
+        admitFromWindow();
+    }
 
     if (m_oldTable == nullptr) {
         // Calculate load factor
@@ -279,10 +437,18 @@ bool Cache::insert(Person person){
 int Cache::findPersonIndex(Person& p, Person** table, int capacity, prob_t policy) const {
     // Compute hash
     int hashedKey = m_hash(p.getKey());
+    // A key the table's filter has never seen is a miss without probing
+    if (m_negFilter == true) {
+        const QuotientFilter& filter = (table == m_currentTable) ? m_currFilter : m_oldFilter;
+        if (filter.mayContain(mixHash((unsigned int)hashedKey)) == false) {
+            return -1;
+        }
+    }
     // Loop through the table
     for (int i = 0; i < capacity; i++) {
         // Get index
         int index = probeIndex(hashedKey, i, capacity, policy);
+        CACHE_STAT(m_opProbes++);
         // Check index location of the table
         if (table[index] == nullptr) {
             return -1;
@@ -300,19 +466,26 @@ int Cache::findPersonIndex(Person& p, Person** table, int capacity, prob_t polic
 }
 // remove: Removes a data point from either the current hash table or the old hash table where the object is stored
 bool Cache::remove(Person person){
+    CACHE_STAT(m_opProbes = 0);
     // Remove causes the transfer
-    if (m_oldTable != nullptr) {
+    if (m_oldTable != nullptr && m_deferTransfer == false) {
         transferPartOfTable();
     }
+    // Expiry work shares the per-operation budget with the transfer
+    if (m_deferTransfer == false) {
+        expireDue();
+    }
 
     bool removedFromCurrTable = false;
+    // An expired entry is reclaimed as well, but for the caller it was already gone
+    bool expired = false;
     // Get index of the person
     int personIndex = findPersonIndex(person, m_currentTable, m_currentCap, m_currProbing);
     // Validate index
     if (personIndex >= 0) {
         // If index is valid, then set the person's m_used to false and decrement counter
-        m_currentTable[personIndex]->m_used = false;
-        m_currNumDeleted++;
+        expired = isExpired(m_currentTable[personIndex]);
+        markDeleted(m_currentTable, personIndex);
         removedFromCurrTable = true;
     }
     // Check old table
@@ -320,9 +493,16 @@ bool Cache::remove(Person person){
         int oldTableIndex = findPersonIndex(person, m_oldTable, m_oldCap, m_oldProbing);
         // If person exists in old table, then set the person's m_used to false and decrement counter
         if (oldTableIndex >= 0) {
-            m_oldTable[oldTableIndex]->m_used = false;
-            m_oldNumDeleted++;
-            return true;
+            expired = isExpired(m_oldTable[oldTableIndex]);
+            markDeleted(m_oldTable, oldTableIndex);
+            if (expired == false) {
+                logMutation(LOG_REMOVE, person.getKey(), person.getID(), 0);
+                CACHE_STAT(m_stats.m_removes++);
+            } else {
+                CACHE_STAT(m_stats.m_failedRemoves++);
+            }
+            CACHE_STAT(recordProbes(STAT_REMOVE));
+            return expired == false;
         }
     }
     // Check for rehash and make sure no hash is in progress.
@@ -335,7 +515,14 @@ bool Cache::remove(Person person){
             startNewRehash();
         }
     }
-    return removedFromCurrTable;
+    CACHE_STAT(recordProbes(STAT_REMOVE));
+    if (removedFromCurrTable && expired == false) {
+        logMutation(LOG_REMOVE, person.getKey(), person.getID(), 0);
+        CACHE_STAT(m_stats.m_removes++);
+        return true;
+    }
+    CACHE_STAT(m_stats.m_failedRemoves++);
+    return false;
 }
 // getPerson: Looks for the Person object with the sequence and the ID in the database
 const Person Cache::getPerson(string key, int ID) const{
@@ -344,11 +531,24 @@ const Person Cache::getPerson(string key, int ID) const{
     tempPerson.m_key = key;
     tempPerson.m_id = ID;
     tempPerson.m_used = true;
+    // The admission filter counts every lookup, hits and misses alike
+    if (m_admission == true) {
+        m_sketch.increment(sketchHash(key, ID));
+    }
+    CACHE_STAT(m_opProbes = 0);
     // Get index
     int personIndex = findPersonIndex(tempPerson, m_currentTable, m_currentCap, m_currProbing);
     // Validate index
     if (personIndex >= 0) {
+        CACHE_STAT(recordProbes(STAT_GET));
+        // An expired entry is a miss even before it is reclaimed
+        if (isExpired(m_currentTable[personIndex])) {
+            CACHE_STAT(m_stats.m_misses++);
+            return Person("", 0, false);
+        }
+        CACHE_STAT(m_stats.m_hits++);
         // Return person
+        touchEntry(m_currentTable[personIndex]);
         return *m_currentTable[personIndex];
     }
     // Check old table
@@ -356,43 +556,443 @@ const Person Cache::getPerson(string key, int ID) const{
         
         int personOldIndex = findPersonIndex(tempPerson, m_oldTable, m_oldCap, m_oldProbing);
         // Validate index
-        if (personOldIndex >= 0) {
+        if (personOldIndex >= 0 && isExpired(m_oldTable[personOldIndex]) == false) {
+            CACHE_STAT(recordProbes(STAT_GET));
+            CACHE_STAT(m_stats.m_hits++);
             // Return person
+            touchEntry(m_oldTable[personOldIndex]);
             return *m_oldTable[personOldIndex];
         }
     }
+    CACHE_STAT(recordProbes(STAT_GET));
+    CACHE_STAT(m_stats.m_misses++);
     // Return empty person if not found
     return Person("", 0, false);
 }
 // updateID: Looks for the Person object in the database
 bool Cache::updateID(Person person, int ID){
     if (ID < MINID || ID > MAXID) {
+        CACHE_STAT(m_stats.m_failedUpdates++);
         return false;
     }
+    CACHE_STAT(m_opProbes = 0);
 
     Person tempPerson;
     tempPerson.m_key = person.getKey();
     tempPerson.m_id = person.getID();
     tempPerson.m_used = true;
 
+    Person* target = nullptr;
     int index = findPersonIndex(tempPerson, m_currentTable, m_currentCap, m_currProbing);
 
     if (index >= 0) {
-        m_currentTable[index]->m_id = ID;
-        return true;
+        target = m_currentTable[index];
     } else {
         if (m_oldTable != nullptr) {
             int oldIndex = findPersonIndex(tempPerson, m_oldTable, m_oldCap, m_oldProbing);
 
             if (oldIndex >= 0) {
-                m_oldTable[oldIndex]->m_id = ID;
-                return true;
+                target = m_oldTable[oldIndex];
             }
         }
     }
-
+    CACHE_STAT(recordProbes(STAT_UPDATE));
+    // An expired entry cannot be updated any more
+    if (target == nullptr || isExpired(target)) {
+        CACHE_STAT(m_stats.m_failedUpdates++);
+        return false;
+    }
+    CACHE_STAT(m_stats.m_updates++);
+    // Reposition the entry in the ID index
+    if (m_useIDIndex == true) {
+        m_idIndex.remove(target->m_id, target);
+        m_idIndex.insert(ID, target);
+    }
+    logMutation(LOG_UPDATE, target->m_key, target->m_id, ID);
+    target->m_id = ID;
+    // The pending expiry follows the entry to its new ID, the old timer goes stale
+    if (target->expireAt() != 0) {
+        m_timers.schedule(target->m_key, ID, target->expireAt());
+    }
+    touchEntry(target);
+    return true;
+}
+// getByID: Looks for the first live entry with the ID, whatever its key
+const Person Cache::getByID(int ID) const {
+    vector<Person*> found;
+    collectByID(ID, ID, found);
+    for (unsigned int i = 0; i < found.size(); i++) {
+        if (isExpired(found[i]) == false) {
+            return *found[i];
+        }
+    }
+    // Return empty person if not found
+    return Person("", 0, false);
+}
+// getByIDRange: Copies of all live entries with lo <= ID <= hi, ordered by ID
+// A range scan reads many entries once, so it does not count as an access for eviction
+vector<Person> Cache::getByIDRange(int lo, int hi) const {
+    vector<Person*> found;
+    collectByID(lo, hi, found);
+    vector<Person> result;
+    result.reserve(found.size());
+    for (unsigned int i = 0; i < found.size(); i++) {
+        if (isExpired(found[i]) == false) {
+            result.push_back(*found[i]);
+        }
+    }
+    return result;
+}
+// getAllByKey: Every live entry with the key, walked in place through its key group
+KeyRange Cache::getAllByKey(const string& key) {
+    if (m_keyGroups == false) {
+        setKeyGroups(true);
+    }
+    unordered_map<string, Person*>::const_iterator it = m_keyHeads.find(key);
+    if (it == m_keyHeads.end()) {
+        return KeyRange();
+    }
+    return KeyRange(it->second, nowMs());
+}
+// scan: Walk the old table, then the current table, count slots at a time
+// The cursor holds the rehash epoch (32 bits), the table (1 bit, 0 is old) and the slot index (31 bits)
+unsigned long long Cache::scan(unsigned long long cursor, int count, std::function<void(const Person&)> callback) const {
+    if (count < 1) {
+        count = 1;
+    }
+    bool inOld = true;
+    int index = 0;
+    if (cursor != 0) {
+        unsigned int cursorEpoch = (unsigned int)(cursor >> 32);
+        inOld = ((cursor >> 31) & 1) == 0;
+        index = (int)(cursor & 0x7FFFFFFF);
+        unsigned int behind = m_rehashEpoch - cursorEpoch;
+        if (behind == 1 && inOld == false) {
+            // The current table the cursor was walking is the old table now, with the same slots
+            inOld = true;
+        } else if (behind != 0) {
+            // The previous old table was drained before the rehash, so the table that became
+            // old holds everything the cursor has not seen yet
+            inOld = true;
+            index = 0;
+        }
+    }
+    long long now = nowMs();
+    int examined = 0;
+    while (examined < count) {
+        Person** table = inOld ? m_oldTable : m_currentTable;
+        int capacity = inOld ? m_oldCap : m_currentCap;
+        // Old slots below the transfer index are empty, their entries are in the current table
+        if (inOld == true && index < m_transferIndex) {
+            index = m_transferIndex;
+        }
+        if (table == nullptr || index >= capacity) {
+            if (inOld == false) {
+                return 0;
+            }
+            // Entries moved out of the old table meanwhile are ahead in the current table
+            inOld = false;
+            index = 0;
+            continue;
+        }
+        Person* p = table[index];
+        if (p != nullptr && p->m_used == true && (p->expireAt() == 0 || p->expireAt() > now)) {
+            callback(*p);
+        }
+        index++;
+        examined++;
+    }
+    if (inOld == false && index >= m_currentCap) {
+        return 0;
+    }
+    return ((unsigned long long)m_rehashEpoch << 32) | ((unsigned long long)(inOld ? 0 : 1) << 31) | (unsigned long long)index;
+}
+// Snapshot file header, the entries follow it back to back
+struct SnapshotHeader {
+    unsigned int m_magic;
+    unsigned int m_version;
+    unsigned int m_hashCheck;   // hash of SNAPHASHPROBE, tells whether the stored hashes can be reused
+    unsigned int m_probing;
+    unsigned int m_capacity;    // capacity of the table the entries end up in
+    unsigned int m_count;       // number of entries
+};
+// Fixed part of every entry, followed by m_keyLength bytes of key
+struct SnapshotEntry {
+    unsigned int m_hash;
+    int          m_id;
+    int          m_ttl;         // milliseconds left to live, 0 means never expires
+    unsigned int m_keyLength;
+};
+// appendRaw: Append the bytes of a value to the snapshot buffer
+static void appendRaw(vector<char>& buffer, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+// saveSnapshot: Write every live entry to a binary file in one write
+// Layout (native byte order): SnapshotHeader, then per entry SnapshotEntry and the key bytes
+// The file is written under a temporary name and renamed, so a crash never leaves half a snapshot
+bool Cache::saveSnapshot(const string& path) const {
+    SnapshotHeader header;
+    header.m_magic = SNAPMAGIC;
+    header.m_version = SNAPVERSION;
+    header.m_hashCheck = m_hash(SNAPHASHPROBE);
+    header.m_probing = (unsigned int)m_currProbing;
+    // The current table is already sized for the entries of both tables
+    header.m_capacity = (unsigned int)m_currentCap;
+    header.m_count = 0;
+    vector<char> buffer;
+    buffer.reserve(sizeof(header) + (size_t)liveCount() * (sizeof(SnapshotEntry) + 16));
+    appendRaw(buffer, &header, sizeof(header));
+    long long now = nowMs();
+    for (int t = 0; t < 2; t++) {
+        Person** table = (t == 0) ? m_oldTable : m_currentTable;
+        int capacity = (t == 0) ? m_oldCap : m_currentCap;
+        for (int i = 0; i < capacity; i++) {
+            Person* p = table[i];
+            if (p == nullptr || p->m_used == false) {
+                continue;
+            }
+            SnapshotEntry entry;
+            entry.m_ttl = 0;
+            if (p->expireAt() != 0) {
+                // Expired entries are not saved
+                if (p->expireAt() <= now) {
+                    continue;
+                }
+                entry.m_ttl = (int)(p->expireAt() - now);
+            }
+            entry.m_hash = m_hash(p->m_key);
+            entry.m_id = p->m_id;
+            entry.m_keyLength = (unsigned int)p->m_key.size();
+            appendRaw(buffer, &entry, sizeof(entry));
+            appendRaw(buffer, p->m_key.data(), p->m_key.size());
+            header.m_count++;
+        }
+    }
+    // More than one table can hold would not load again
+    if (header.m_count > (unsigned int)MAXPRIME) {
+        return false;
+    }
+    memcpy(&buffer[0], &header, sizeof(header));
+    string tempPath = path + ".tmp";
+    ofstream out(tempPath.c_str(), ios::binary | ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(&buffer[0], buffer.size());
+    out.close();
+    if (!out) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+// saveSnapshotAsync: Fork a child that writes the snapshot from its copy-on-write image
+// The parent only pays for copying the page tables, pages are copied when either side
+// writes them, so inserts and removes continue while the file is written
+bool Cache::saveSnapshotAsync(const string& path) {
+    if (snapshotPending()) {
+        return false;
+    }
+    pid_t child = fork();
+    if (child < 0) {
+        return false;
+    }
+    if (child == 0) {
+        // Only this thread exists in the child. saveSnapshot allocates its buffer and the
+        // ofstream, which is safe only because glibc's malloc resets its locks in fork's
+        // atfork handlers; the cache itself holds no locks to inherit
+        // _exit skips the destructors and stream flushes that belong to the parent
+        _exit(saveSnapshot(path) ? 0 : 1);
+    }
+    m_snapshotChild = (int)child;
+    m_snapshotOK = false;
+    return true;
+}
+// snapshotPending: Check on the background snapshot writer without blocking
+bool Cache::snapshotPending() {
+    if (m_snapshotChild == 0) {
+        return false;
+    }
+    int status = 0;
+    pid_t done = waitpid((pid_t)m_snapshotChild, &status, WNOHANG);
+    if (done == 0) {
+        return true;
+    }
+    m_snapshotOK = (done > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    m_snapshotChild = 0;
     return false;
-    
+}
+// waitSnapshot: Wait for the background snapshot writer to exit
+bool Cache::waitSnapshot() {
+    if (m_snapshotChild != 0) {
+        int status = 0;
+        pid_t done = waitpid((pid_t)m_snapshotChild, &status, 0);
+        m_snapshotOK = (done > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        m_snapshotChild = 0;
+    }
+    return m_snapshotOK;
+}
+// loadSnapshot: Replace the contents with a snapshot, returns false and leaves the cache
+// untouched if the file is missing or malformed
+// The table is allocated at its final size and filled in one pass without the insert checks
+bool Cache::loadSnapshot(const string& path) {
+    ifstream in(path.c_str(), ios::binary | ios::ate);
+    if (!in) {
+        return false;
+    }
+    streamoff fileSize = in.tellg();
+    if (fileSize < (streamoff)sizeof(SnapshotHeader)) {
+        return false;
+    }
+    vector<char> buffer((size_t)fileSize);
+    in.seekg(0, ios::beg);
+    if (!in.read(&buffer[0], fileSize)) {
+        return false;
+    }
+    SnapshotHeader header;
+    memcpy(&header, &buffer[0], sizeof(header));
+    if (header.m_magic != SNAPMAGIC || header.m_version != SNAPVERSION || header.m_probing > LINEAR ||
+        header.m_count > (unsigned int)MAXPRIME) {
+        return false;
+    }
+    // Parse everything first, so a truncated file does not touch the cache
+    vector<Person*> nodes;
+    vector<unsigned int> hashes;
+    vector<int> ttls;
+    nodes.reserve(header.m_count);
+    hashes.reserve(header.m_count);
+    ttls.reserve(header.m_count);
+    size_t offset = sizeof(header);
+    bool valid = true;
+    for (unsigned int i = 0; i < header.m_count && valid; i++) {
+        SnapshotEntry entry;
+        if (offset + sizeof(entry) > buffer.size()) {
+            valid = false;
+            break;
+        }
+        memcpy(&entry, &buffer[offset], sizeof(entry));
+        offset += sizeof(entry);
+        if (entry.m_keyLength > buffer.size() - offset || entry.m_id < MINID || entry.m_id > MAXID) {
+            valid = false;
+            break;
+        }
+        nodes.push_back(new Person(string(&buffer[offset], entry.m_keyLength), entry.m_id, true));
+        hashes.push_back(entry.m_hash);
+        ttls.push_back(entry.m_ttl);
+        offset += entry.m_keyLength;
+    }
+    if (valid == false || offset != buffer.size()) {
+        for (unsigned int i = 0; i < nodes.size(); i++) {
+            delete nodes[i];
+        }
+        return false;
+    }
+    // The stored hashes are only good for the same hash function
+    bool reuseHashes = (header.m_hashCheck == m_hash(SNAPHASHPROBE));
+
+    // Use the saved geometry unless it would be more than half full, the table never
+    // grows past MAXPRIME, so a cache that filled it is reloaded into one of that size
+    int capacity = (int)header.m_capacity;
+    if (capacity < MINPRIME || capacity > MAXPRIME || isPrime(capacity) == false ||
+        (int)header.m_count * 2 > capacity) {
+        capacity = findNextPrime((int)header.m_count * 4);
+    }
+    prob_t probing = (prob_t)header.m_probing;
+    // Place every entry before touching the cache: entries are unique and the table is
+    // fresh, so the first empty slot is the right one, but past half full a quadratic
+    // probe sequence may not reach one
+    Person** table = new Person*[capacity];
+    for (int i = 0; i < capacity; i++) {
+        table[i] = nullptr;
+    }
+    for (unsigned int n = 0; n < nodes.size() && valid; n++) {
+        int hashedKey = reuseHashes ? (int)hashes[n] : (int)m_hash(nodes[n]->m_key);
+        valid = false;
+        for (int i = 0; i < capacity && valid == false; i++) {
+            int index = probeIndex(hashedKey, i, capacity, probing);
+            if (table[index] == nullptr) {
+                table[index] = nodes[n];
+                valid = true;
+            }
+        }
+    }
+    if (valid == false) {
+        delete [] table;
+        for (unsigned int i = 0; i < nodes.size(); i++) {
+            delete nodes[i];
+        }
+        return false;
+    }
+
+    // Drop the current contents and every structure pointing into them
+    freeTables();
+    m_lruHead = nullptr;
+    m_lruTail = nullptr;
+    m_windowHead = nullptr;
+    m_windowTail = nullptr;
+    m_windowCount = 0;
+    m_clockHand = 0;
+    m_oldHand = 0;
+    m_transferIndex = 0;
+    m_timers = TimingWheel();
+    long long now = nowMs();
+    m_timers.reset(now);
+    // Outstanding scan cursors start over in the new table
+    m_rehashEpoch++;
+    if (m_rehashEpoch == 0) {
+        m_rehashEpoch = 1;
+    }
+
+    m_currProbing = probing;
+    m_newPolicy = m_currProbing;
+    m_currentCap = capacity;
+    m_currentTable = table;
+    m_currentSize = (int)nodes.size();
+    for (unsigned int n = 0; n < nodes.size(); n++) {
+        Person* p = nodes[n];
+        if (ttls[n] > 0) {
+            p->links().m_expireAt = now + ttls[n];
+            m_timers.schedule(p->m_key, p->m_id, p->expireAt());
+        }
+        // Saved entries were admitted once already, they skip the admission window
+        joinMain(p);
+    }
+    // Rebuild the optional structures from the new table
+    if (m_negFilter == true) {
+        buildFilter(m_currFilter, m_currentTable, m_currentCap);
+        m_oldFilter.clear();
+    }
+    if (m_useIDIndex == true) {
+        setIDIndex(true);
+    }
+    if (m_keyGroups == true) {
+        setKeyGroups(true);
+    }
+    if (m_maxEntries > 0) {
+        while (liveCount() > m_maxEntries && evictOne()) {}
+    }
+    return true;
+}
+// collectByID: Live entries with an ID in [lo, hi], from the index or from a scan of both tables
+void Cache::collectByID(int lo, int hi, vector<Person*>& out) const {
+    if (m_useIDIndex == true) {
+        m_idIndex.range(lo, hi, out);
+        return;
+    }
+    for (int i = 0; i < m_oldCap; i++) {
+        if (m_oldTable[i] != nullptr && m_oldTable[i]->m_used == true &&
+            m_oldTable[i]->m_id >= lo && m_oldTable[i]->m_id <= hi) {
+            out.push_back(m_oldTable[i]);
+        }
+    }
+    for (int i = 0; i < m_currentCap; i++) {
+        if (m_currentTable[i] != nullptr && m_currentTable[i]->m_used == true &&
+            m_currentTable[i]->m_id >= lo && m_currentTable[i]->m_id <= hi) {
+            out.push_back(m_currentTable[i]);
+        }
+    }
+    std::stable_sort(out.begin(), out.end(), [](const Person* a, const Person* b) { return a->m_id < b->m_id; });
 }
 // lambda: Returns the load factor of the current hash table
 float Cache::lambda() const {
@@ -408,6 +1008,523 @@ float Cache::deletedRatio() const {
     return float(m_currNumDeleted) / m_currentSize;
 }
 
+// setMaxEntries: Bound the number of live entries, evicting right away if already over the bound
+void Cache::setMaxEntries(int maxEntries, evict_t policy) {
+    if (maxEntries <= 0 || policy == NOEVICT) {
+        m_maxEntries = 0;
+        m_evictPolicy = NOEVICT;
+        return;
+    }
+    // The table can never grow past MAXPRIME, and it rehashes at load factor 0.5
+    if (maxEntries > MAXPRIME / 2) {
+        maxEntries = MAXPRIME / 2;
+    }
+    // Entries inserted before LRU was turned on are not on the recency list yet,
+    // link them now in table order
+    if (policy == LRU && m_evictPolicy != LRU) {
+        m_lruHead = nullptr;
+        m_lruTail = nullptr;
+        for (int i = 0; i < m_oldCap; i++) {
+            if (m_oldTable[i] != nullptr && m_oldTable[i]->m_used == true && m_oldTable[i]->m_window == false) {
+                linkFront(m_oldTable[i], m_lruHead, m_lruTail);
+            }
+        }
+        for (int i = 0; i < m_currentCap; i++) {
+            if (m_currentTable[i] != nullptr && m_currentTable[i]->m_used == true && m_currentTable[i]->m_window == false) {
+                linkFront(m_currentTable[i], m_lruHead, m_lruTail);
+            }
+        }
+    }
+    m_maxEntries = maxEntries;
+    m_evictPolicy = policy;
+    if (m_admission == true) {
+        sizeAdmission();
+    }
+    while (liveCount() > m_maxEntries && evictOne()) {}
+}
+// setAdmissionFilter: Turn the TinyLFU admission filter on or off
+void Cache::setAdmissionFilter(bool enabled) {
+    if (enabled == true) {
+        m_admission = true;
+        sizeAdmission();
+        return;
+    }
+    m_admission = false;
+    // Entries still waiting in the window go straight to the main space
+    while (m_windowTail != nullptr) {
+        Person* p = m_windowTail;
+        untrackEntry(p);
+        joinMain(p);
+    }
+}
+// setNegativeFilter: Turn the per-table negative lookup filters on or off
+void Cache::setNegativeFilter(bool enabled) {
+    m_negFilter = enabled;
+    if (enabled == false) {
+        m_currFilter.clear();
+        m_oldFilter.clear();
+        return;
+    }
+    // Entries inserted before are added now
+    buildFilter(m_currFilter, m_currentTable, m_currentCap);
+    buildFilter(m_oldFilter, m_oldTable, m_oldCap);
+}
+// setIDIndex: Turn the ordered ID index on or off
+void Cache::setIDIndex(bool enabled) {
+    m_useIDIndex = enabled;
+    m_idIndex.clear();
+    if (enabled == false) {
+        return;
+    }
+    // Entries inserted before are added now
+    for (int i = 0; i < m_oldCap; i++) {
+        if (m_oldTable[i] != nullptr && m_oldTable[i]->m_used == true) {
+            m_idIndex.insert(m_oldTable[i]->m_id, m_oldTable[i]);
+        }
+    }
+    for (int i = 0; i < m_currentCap; i++) {
+        if (m_currentTable[i] != nullptr && m_currentTable[i]->m_used == true) {
+            m_idIndex.insert(m_currentTable[i]->m_id, m_currentTable[i]);
+        }
+    }
+}
+// setKeyGroups: Turn the key group chains on or off
+void Cache::setKeyGroups(bool enabled) {
+    m_keyGroups = enabled;
+    m_keyHeads.clear();
+    // Entries inserted before are chained now, turning it off leaves the stale links
+    // unused until the entries are chained again
+    if (enabled == false) {
+        return;
+    }
+    for (int i = 0; i < m_oldCap; i++) {
+        if (m_oldTable[i] != nullptr && m_oldTable[i]->m_used == true) {
+            linkKeyGroup(m_oldTable[i]);
+        }
+    }
+    for (int i = 0; i < m_currentCap; i++) {
+        if (m_currentTable[i] != nullptr && m_currentTable[i]->m_used == true) {
+            linkKeyGroup(m_currentTable[i]);
+        }
+    }
+}
+// advanceMigration: Do the work of one operation's transfer step on its own
+bool Cache::advanceMigration() {
+    transferPartOfTable();
+    expireDue();
+    return m_oldTable != nullptr;
+}
+// stats: Counters plus the current table figures
+CacheStats Cache::stats() const {
+    CacheStats result = m_stats;
+    result.m_migrating = (m_oldTable != nullptr);
+    result.m_transferIndex = (m_oldTable != nullptr) ? m_transferIndex : 0;
+    result.m_oldCap = m_oldCap;
+    result.m_liveEntries = liveCount();
+    result.m_capacity = m_currentCap;
+    result.m_lambda = lambda();
+    result.m_deletedRatio = deletedRatio();
+    return result;
+}
+// memoryUsage: Both generations, then the structures that exist whether their feature is on or not
+CacheMemory Cache::memoryUsage() const {
+    CacheMemory usage;
+    usage.m_object = sizeof(Cache);
+    tableMemory(m_currentTable, m_currentCap, usage);
+    if (m_oldTable != nullptr) {
+        tableMemory(m_oldTable, m_oldCap, usage);
+        usage.m_oldTable.addBlock(m_oldTable, m_oldCap * sizeof(Person*));
+    }
+    m_sketch.memoryUsage(usage.m_aux);
+    m_timers.memoryUsage(usage.m_aux);
+    m_currFilter.memoryUsage(usage.m_aux);
+    m_oldFilter.memoryUsage(usage.m_aux);
+    m_idIndex.memoryUsage(usage.m_aux);
+    // Hash map nodes cannot be located, so they are sized as libstdc++ lays them out:
+    // next pointer, key, value and the cached hash; one bucket lives inside the map
+    if (m_keyHeads.bucket_count() > 1) {
+        usage.m_aux.addBlock(nullptr, m_keyHeads.bucket_count() * sizeof(void*));
+    }
+    for (unordered_map<string, Person*>::const_iterator it = m_keyHeads.begin(); it != m_keyHeads.end(); it++) {
+        usage.m_aux.addBlock(nullptr, sizeof(void*) + sizeof(*it) + sizeof(size_t));
+        usage.m_aux.addString(it->first);
+    }
+    return usage;
+}
+// tableMemory: The slot array, then every node it points to, deleted ones are tombstones
+void Cache::tableMemory(Person** table, int capacity, CacheMemory& usage) const {
+    if (table == nullptr) {
+        return;
+    }
+    usage.m_tables.addBlock(table, capacity * sizeof(Person*));
+    for (int i = 0; i < capacity; i++) {
+        Person* p = table[i];
+        if (p == nullptr) {
+            continue;
+        }
+        if (p->m_used) {
+            usage.m_nodes.addBlock(p, sizeof(Person));
+            if (p->m_links != nullptr) {
+                usage.m_nodes.addBlock(p->m_links, sizeof(EntryLinks));
+            }
+            usage.m_keys.addString(p->m_key);
+            usage.m_liveEntries++;
+        } else {
+            usage.m_tombstones.addBlock(p, sizeof(Person));
+            if (p->m_links != nullptr) {
+                usage.m_tombstones.addBlock(p->m_links, sizeof(EntryLinks));
+            }
+            usage.m_tombstones.addString(p->m_key);
+            usage.m_tombstoneCount++;
+        }
+    }
+}
+// resetStats: Zero the counters
+void Cache::resetStats() {
+    m_stats = CacheStats();
+}
+// recordProbes: Histogram bucket of the probe length, long walks share the last bucket
+void Cache::recordProbes(statop_t op) const {
+    int bucket = (m_opProbes < PROBEBUCKETS) ? m_opProbes : PROBEBUCKETS - 1;
+    m_stats.m_probes[op][bucket]++;
+    m_stats.m_probeSum[op] += m_opProbes;
+}
+// setMutationLog: Log the mutations from now on, the log is not owned
+void Cache::setMutationLog(MutationLog* log) {
+    m_log = log;
+}
+// logMutation: Append one record, with FSYNC_ALWAYS wait until it is on disk
+// Under a combiner the wait is left to the owner so one sync covers a whole round
+void Cache::logMutation(logop_t op, const string& key, int id, long long arg) {
+    if (m_log == nullptr) {
+        return;
+    }
+    unsigned long long lsn = m_log->append(op, key, id, arg);
+    // 0: the log has failed, there is nothing to wait for
+    if (lsn != 0 && m_log->getPolicy() == FSYNC_ALWAYS && m_deferTransfer == false) {
+        m_log->waitDurable(lsn);
+    }
+}
+// linkKeyGroup: Put an entry at the front of its key's chain
+void Cache::linkKeyGroup(Person* p) {
+    Person*& head = m_keyHeads[p->m_key];
+    EntryLinks& links = p->links();
+    links.m_keyPrev = nullptr;
+    links.m_keyNext = head;
+    if (head != nullptr) {
+        head->links().m_keyPrev = p;
+    }
+    head = p;
+}
+// unlinkKeyGroup: Take an entry out of its key's chain, the last one removes the key
+void Cache::unlinkKeyGroup(Person* p) {
+    EntryLinks& links = p->links();
+    if (links.m_keyPrev != nullptr) {
+        links.m_keyPrev->m_links->m_keyNext = links.m_keyNext;
+    } else if (links.m_keyNext != nullptr) {
+        m_keyHeads[p->m_key] = links.m_keyNext;
+    } else {
+        m_keyHeads.erase(p->m_key);
+    }
+    if (links.m_keyNext != nullptr) {
+        links.m_keyNext->m_links->m_keyPrev = links.m_keyPrev;
+    }
+    links.m_keyPrev = nullptr;
+    links.m_keyNext = nullptr;
+}
+// buildFilter: Fill a filter with the keys of the live entries of one table
+void Cache::buildFilter(QuotientFilter& filter, Person** table, int capacity) {
+    if (table == nullptr) {
+        filter.clear();
+        return;
+    }
+    filter.resize(capacity);
+    for (int i = 0; i < capacity; i++) {
+        if (table[i] != nullptr && table[i]->m_used == true) {
+            filter.insert(mixHash(m_hash(table[i]->m_key)));
+        }
+    }
+}
+// sizeAdmission: The window holds 1% of the bound, the sketch has a counter per entry
+void Cache::sizeAdmission() {
+    m_windowCap = m_maxEntries / 100;
+    if (m_windowCap < 1) {
+        m_windowCap = 1;
+    }
+    m_sketch.resize(m_maxEntries > 0 ? m_maxEntries : MINPRIME);
+}
+// nowMs: Current steady clock time in milliseconds
+long long Cache::nowMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+// isExpired: Check the TTL of a live entry, entries without one never expire
+bool Cache::isExpired(const Person* p) const {
+    return p->expireAt() != 0 && p->expireAt() <= nowMs();
+}
+// expireDue: Reclaim up to EXPIREBUDGET entries whose time is up, using the lazy delete
+void Cache::expireDue() {
+    if (m_timers.empty()) {
+        return;
+    }
+    // The lookups below are not part of the calling operation's probe length
+    CACHE_STAT(int savedProbes = m_opProbes);
+    vector<TimerEntry> due;
+    m_timers.advance(nowMs(), EXPIREBUDGET, due);
+    for (unsigned int i = 0; i < due.size(); i++) {
+        Person target(due[i].m_key, due[i].m_id, true);
+        // A timer whose entry was removed, updated or re-inserted since is stale,
+        // only an entry with the very same expiry time is reclaimed
+        int index = findPersonIndex(target, m_currentTable, m_currentCap, m_currProbing);
+        if (index >= 0) {
+            if (m_currentTable[index]->expireAt() == due[i].m_expireAt) {
+                markDeleted(m_currentTable, index);
+                CACHE_STAT(m_stats.m_expirations++);
+            }
+            continue;
+        }
+        if (m_oldTable != nullptr) {
+            index = findPersonIndex(target, m_oldTable, m_oldCap, m_oldProbing);
+            if (index >= 0 && m_oldTable[index]->expireAt() == due[i].m_expireAt) {
+                markDeleted(m_oldTable, index);
+                CACHE_STAT(m_stats.m_expirations++);
+            }
+        }
+    }
+    CACHE_STAT(m_opProbes = savedProbes);
+}
+// liveCount: Returns the number of live entries in the current and old tables
+int Cache::liveCount() const {
+    int live = m_currentSize - m_currNumDeleted;
+    if (m_oldTable != nullptr) {
+        live += m_oldSize - m_oldNumDeleted;
+    }
+    return live;
+}
+// markDeleted: Lazily delete the live entry at table[index], table is either the current or the old table
+void Cache::markDeleted(Person** table, int index) {
+    Person* p = table[index];
+    p->m_used = false;
+    if (table == m_currentTable) {
+        m_currNumDeleted++;
+    } else {
+        m_oldNumDeleted++;
+    }
+    if (m_useIDIndex == true) {
+        m_idIndex.remove(p->m_id, p);
+    }
+    if (m_keyGroups == true) {
+        unlinkKeyGroup(p);
+    }
+    if (m_negFilter == true) {
+        unsigned long long fingerprint = mixHash(m_hash(p->m_key));
+        if (table == m_currentTable) {
+            m_currFilter.remove(fingerprint);
+        } else {
+            m_oldFilter.remove(fingerprint);
+        }
+    }
+    untrackEntry(p);
+}
+// deleteEntry: Lazily delete a live entry object from whichever table holds it
+bool Cache::deleteEntry(Person* p) {
+    int index = findPersonIndex(*p, m_currentTable, m_currentCap, m_currProbing);
+    if (index >= 0 && m_currentTable[index] == p) {
+        markDeleted(m_currentTable, index);
+        return true;
+    }
+    if (m_oldTable != nullptr) {
+        index = findPersonIndex(*p, m_oldTable, m_oldCap, m_oldProbing);
+        if (index >= 0 && m_oldTable[index] == p) {
+            markDeleted(m_oldTable, index);
+            return true;
+        }
+    }
+    return false;
+}
+// evictOne: Evict one entry chosen by the eviction policy, returns false if nothing could be evicted
+bool Cache::evictOne() {
+    bool evicted = false;
+    if (m_evictPolicy == LRU && m_lruTail != nullptr) {
+        evicted = deleteEntry(m_lruTail);
+    } else if (m_evictPolicy == CLOCK && evictClock() == true) {
+        evicted = true;
+    } else if (m_windowTail != nullptr) {
+        // The main space is empty, only window entries are left
+        evicted = deleteEntry(m_windowTail);
+    }
+    CACHE_STAT(m_stats.m_evictions += evicted ? 1 : 0);
+    return evicted;
+}
+// clockVictim: Second-chance sweep, referenced entries get their bit cleared and are skipped
+// Returns the first unreferenced main-space entry and leaves the hand on it, nullptr if there is none
+Person* Cache::clockVictim() {
+    // The part of the old table not transferred yet is swept first, the transfer walks it next anyway
+    if (m_oldTable != nullptr) {
+        if (m_oldHand < m_transferIndex) {
+            m_oldHand = m_transferIndex;
+        }
+        while (m_oldHand < m_oldCap) {
+            Person* p = m_oldTable[m_oldHand];
+            if (p != nullptr && p->m_used == true && p->m_window == false) {
+                if (p->m_ref == false) {
+                    return p;
+                }
+                p->m_ref = false;
+            }
+            m_oldHand++;
+        }
+    }
+    // Two turns over the current table are enough, the first one clears every bit
+    for (int step = 0; step < 2 * m_currentCap; step++) {
+        if (m_clockHand >= m_currentCap) {
+            m_clockHand = 0;
+        }
+        Person* p = m_currentTable[m_clockHand];
+        if (p != nullptr && p->m_used == true && p->m_window == false) {
+            if (p->m_ref == false) {
+                return p;
+            }
+            p->m_ref = false;
+        }
+        m_clockHand++;
+    }
+    return nullptr;
+}
+// evictClock: Evict the entry under the CLOCK hand
+bool Cache::evictClock() {
+    Person* victim = clockVictim();
+    if (victim == nullptr) {
+        return false;
+    }
+    if (m_oldTable != nullptr && m_oldHand < m_oldCap && m_oldTable[m_oldHand] == victim) {
+        markDeleted(m_oldTable, m_oldHand);
+        m_oldHand++;
+    } else {
+        markDeleted(m_currentTable, m_clockHand);
+        m_clockHand++;
+    }
+    return true;
+}
+// admitFromWindow: Window overflow competes with the main space victim on access frequency
+void Cache::admitFromWindow() {
+    while (m_windowCount > m_windowCap) {
+        Person* candidate = m_windowTail;
+        // Still room in the main space, nothing has to go
+        if (liveCount() <= m_maxEntries) {
+            untrackEntry(candidate);
+            joinMain(candidate);
+            continue;
+        }
+        // The candidate stays flagged as a window entry until the decision, so the hand skips it
+        Person* victim = nullptr;
+        if (m_evictPolicy == LRU) {
+            victim = m_lruTail;
+        } else if (m_evictPolicy == CLOCK) {
+            victim = clockVictim();
+        }
+        if (victim == nullptr ||
+            m_sketch.frequency(sketchHash(candidate->m_key, candidate->m_id)) >
+            m_sketch.frequency(sketchHash(victim->m_key, victim->m_id))) {
+            // The candidate is more popular, it replaces the victim
+            if (victim != nullptr) {
+                evictOne();
+            }
+            untrackEntry(candidate);
+            joinMain(candidate);
+        } else {
+            // A one-hit wonder, it never reaches the main space
+            deleteEntry(candidate);
+            CACHE_STAT(m_stats.m_evictions++);
+        }
+    }
+    while (liveCount() > m_maxEntries && evictOne()) {}
+}
+// sketchHash: 64-bit hash of key and ID for the frequency sketch
+unsigned long long Cache::sketchHash(const string& key, int id) const {
+    return mixHash(((unsigned long long)m_hash(key) << 32) ^ (unsigned int)id);
+}
+// mixHash: splitmix64 finalizer, spreads the bits of a 32-bit hash over the whole word
+unsigned long long Cache::mixHash(unsigned long long h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+// trackEntry: Add a newly inserted entry to the bookkeeping of the active modes
+void Cache::trackEntry(Person* p) {
+    if (m_admission == true && m_maxEntries > 0) {
+        // New entries start in the admission window
+        p->m_window = true;
+        linkFront(p, m_windowHead, m_windowTail);
+        m_windowCount++;
+    } else {
+        joinMain(p);
+    }
+}
+// joinMain: Put an entry into the main space of the eviction policy
+void Cache::joinMain(Person* p) {
+    if (m_evictPolicy == LRU) {
+        linkFront(p, m_lruHead, m_lruTail);
+    } else if (m_evictPolicy == CLOCK) {
+        p->m_ref = true;
+    }
+}
+// untrackEntry: Drop a deleted entry from the bookkeeping of the active modes
+void Cache::untrackEntry(Person* p) {
+    if (p->m_window == true) {
+        unlinkFrom(p, m_windowHead, m_windowTail);
+        p->m_window = false;
+        m_windowCount--;
+    } else if (m_evictPolicy == LRU) {
+        unlinkFrom(p, m_lruHead, m_lruTail);
+    }
+}
+// touchEntry: Record an access to a live entry
+void Cache::touchEntry(Person* p) const {
+    if (p->m_window == true) {
+        if (m_windowHead != p) {
+            unlinkFrom(p, m_windowHead, m_windowTail);
+            linkFront(p, m_windowHead, m_windowTail);
+        }
+    } else if (m_evictPolicy == CLOCK) {
+        // A read hit only sets one bit
+        p->m_ref = true;
+    } else if (m_evictPolicy == LRU && m_lruHead != p) {
+        unlinkFrom(p, m_lruHead, m_lruTail);
+        linkFront(p, m_lruHead, m_lruTail);
+    }
+}
+// linkFront: Push the entry at the most recently used end of a list
+void Cache::linkFront(Person* p, Person*& head, Person*& tail) {
+    p->m_prev = nullptr;
+    p->m_next = head;
+    if (head != nullptr) {
+        head->m_prev = p;
+    }
+    head = p;
+    if (tail == nullptr) {
+        tail = p;
+    }
+}
+// unlinkFrom: Take the entry out of a list, does nothing if it is not on it
+void Cache::unlinkFrom(Person* p, Person*& head, Person*& tail) {
+    if (p->m_prev != nullptr) {
+        p->m_prev->m_next = p->m_next;
+    } else if (head == p) {
+        head = p->m_next;
+    }
+    if (p->m_next != nullptr) {
+        p->m_next->m_prev = p->m_prev;
+    } else if (tail == p) {
+        tail = p->m_prev;
+    }
+    p->m_prev = nullptr;
+    p->m_next = nullptr;
+}
+
 void Cache::dump() const {
     cout << "Dump for the current table: " << endl;
     if (m_currentTable != nullptr)
@@ -2,26 +2,63 @@
 #define CACHE_H
 #include <iostream>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
 #include "math.h"
+#include "frequency_sketch.h"
+#include "timing_wheel.h"
+#include "quotient_filter.h"
+#include "id_index.h"
+#include "mutation_log.h"
+#include "cache_stats.h"
+#include "hash_functions.h"
 using namespace std;
 class Tester;   // forward declaration, will be used for testing
 class Person;   // forward declaration
 class Cache;    // forward declaration
+class KeyRange; // forward declaration
 const int MINPRIME = 101;   // Min size for hash table
 const int MAXPRIME = 99991; // Max size for hash table
 const int MINID = 100000;
 const int MAXID = 999999;
+const int EXPIREBUDGET = 8;  // expired entries reclaimed per insert/remove
+const unsigned int SNAPMAGIC = 0x53435448;  // "HTCS" at the start of a snapshot file
+const unsigned int SNAPVERSION = 1;
+#define SNAPHASHPROBE "snapshot-hash-check"
 typedef unsigned int (*hash_fn)(string); // declaration of hash function
 enum prob_t {QUADRATIC, DOUBLEHASH, LINEAR}; // types of collision handling policy
 #define DEFPOLCY QUADRATIC
+enum evict_t {NOEVICT, LRU, CLOCK}; // eviction policy when the number of entries is bounded
+
+// Bookkeeping of the rarely used features, kept out of Person so that entries without a TTL
+// or key groups stay small; an entry gets it the first time one of the two needs it
+struct EntryLinks {
+    // absolute expiry time in milliseconds (steady clock), 0 means the entry never expires
+    long long m_expireAt;
+    // the following pointers chain the live entries that share this key (key groups)
+    Person* m_keyPrev;
+    Person* m_keyNext;
+    EntryLinks() : m_expireAt(0), m_keyPrev(nullptr), m_keyNext(nullptr) {}
+};
 
 class Person {
     public:
     friend class Tester;
     friend class Cache;
+    friend class KeyRange;
     Person(string key="", int id=0, bool used=false){
-        m_key = key; m_id = id; m_used=used;
+        m_key = key; m_id = id; m_used=used; m_ref = false; m_window = false;
+        m_prev = nullptr; m_next = nullptr;
+        m_links = nullptr;
+    }
+    // a copy is a plain value, it never belongs to a cache's bookkeeping lists
+    Person(const Person& rhs){
+        m_key = rhs.m_key; m_id = rhs.m_id; m_used = rhs.m_used; m_ref = false; m_window = false;
+        m_prev = nullptr; m_next = nullptr;
+        m_links = nullptr;
     }
+    ~Person(){ delete m_links; }
     string getKey() const {return m_key;}
     int getID() const {return m_id;}
     void setKey(string key){m_key=key;}
@@ -57,18 +94,75 @@ class Person {
         return *this;
     }
     private:
+    // the TTL and key group bookkeeping, allocated on first use
+    EntryLinks& links(){
+        if (m_links == nullptr) m_links = new EntryLinks();
+        return *m_links;
+    }
+    long long expireAt() const {return m_links != nullptr ? m_links->m_expireAt : 0;}
+    Person* keyNext() const {return m_links != nullptr ? m_links->m_keyNext : nullptr;}
+
     string m_key;   // the search string used as key in the hash table
     int m_id;       // a unique ID number identifying the object
     // the following variable is used for lazy delete scheme in hash table
     // if it is set to false, it means the bucket in the hash table is free for insert
     // if it is set to true, it means the bucket contains live data, and we cannot overwrite it
     bool m_used;
+    // reference bit for CLOCK eviction, set on every access and cleared by the sweeping hand
+    bool m_ref;
+    // true while the entry sits in the admission window instead of the main space
+    bool m_window;
+    // the following pointers thread the recency list of a bounded cache through the entries
+    // (the main LRU list or the admission window, an entry is on at most one of them)
+    // entries move between tables by pointer, so the list stays valid during a rehash
+    Person* m_prev; // more recently used neighbour
+    Person* m_next; // less recently used neighbour
+    // expiry and key group links, nullptr until a TTL or key groups touch the entry
+    EntryLinks* m_links;
+};
+// All live entries under one key, walked in place through the key group chain
+// The range stays valid through the rehash transfer, removing an entry of the group invalidates it
+class KeyRange {
+    public:
+    class iterator {
+        public:
+        iterator(Person* node = nullptr, long long now = 0) : m_node(node), m_now(now) { skipExpired(); }
+        const Person& operator*() const {return *m_node;}
+        const Person* operator->() const {return m_node;}
+        iterator& operator++(){ m_node = m_node->keyNext(); skipExpired(); return *this; }
+        bool operator==(const iterator& rhs) const {return m_node == rhs.m_node;}
+        bool operator!=(const iterator& rhs) const {return m_node != rhs.m_node;}
+        private:
+        // entries past their TTL are not reclaimed yet but no longer visible
+        void skipExpired(){
+            while (m_node != nullptr && m_node->expireAt() != 0 && m_node->expireAt() <= m_now)
+                m_node = m_node->keyNext();
+        }
+        Person* m_node;
+        long long m_now;
+    };
+    KeyRange(Person* head = nullptr, long long now = 0) : m_head(head), m_now(now) {}
+    iterator begin() const {return iterator(m_head, m_now);}
+    iterator end() const {return iterator();}
+    bool empty() const {return begin() == end();}
+    // Number of entries in the range, walks the chain
+    int size() const {
+        int count = 0;
+        for (iterator it = begin(); it != end(); ++it) count++;
+        return count;
+    }
+    private:
+    Person*   m_head;
+    long long m_now;    // time the range was taken, for the TTL check
 };
 class Cache {
     public:
     friend class Grader;
     friend class Tester;
+    friend class CombiningCache;
     Cache(int size, hash_fn hash, prob_t probing);
+    // Same, with one of the built-in hash functions (hash_functions.h)
+    Cache(int size, hashkind_t hash, prob_t probing = DEFPOLCY);
     ~Cache();
     // Returns Load factor of the new table
     float lambda() const;
@@ -76,13 +170,70 @@ class Cache {
     float deletedRatio() const;
     // insert only happens in the new table
     bool insert(Person person);
+    // insert with a time to live in milliseconds, 0 means the entry never expires
+    // expired entries are invisible right away and reclaimed a few per insert/remove
+    bool insert(Person person, int ttl);
     // remove can happen from either table
     bool remove(Person person);
     // find can happen in either table
     const Person getPerson(string key, int id) const;
     // update the information
     bool updateID(Person person, int ID);
+    // find by ID alone, the first entry with this ID or an empty Person
+    const Person getByID(int ID) const;
+    // all entries with lo <= ID <= hi in ID order, uses the ID index if it is on
+    vector<Person> getByIDRange(int lo, int hi) const;
+    // every live entry with this key, without copying them
+    // the first call turns key groups on (one scan), later ones cost O(entries with the key)
+    KeyRange getAllByKey(const string& key);
+    // resumable iteration: start with cursor 0 and pass the returned cursor back in until it is 0
+    // every entry live for the whole scan is visited at least once, even across rehashes
+    // count bounds the slots examined per call, the callback must not modify the cache
+    unsigned long long scan(unsigned long long cursor, int count, std::function<void(const Person&)> callback) const;
     void changeProbPolicy(prob_t policy);
+    // Bounded mode: keep at most maxEntries live entries, evicting by policy on insert
+    // maxEntries of 0 turns bounding off, values above MAXPRIME/2 are clamped
+    void setMaxEntries(int maxEntries, evict_t policy = LRU);
+    // Bounded mode: W-TinyLFU admission, new entries wait in a small LRU window and
+    // only enter the main space if they are accessed more often than its eviction victim
+    void setAdmissionFilter(bool enabled);
+    // Keep a quotient filter per table so lookups of missing entries skip the probe walk
+    void setNegativeFilter(bool enabled);
+    // Keep an ordered index over the IDs so getByID and getByIDRange avoid a full scan
+    void setIDIndex(bool enabled);
+    // Chain the entries of every key together for getAllByKey
+    void setKeyGroups(bool enabled);
+    // Write all live entries to a binary snapshot file, returns false on I/O errors or if the
+    // entries would not fit into one table of MAXPRIME slots on load
+    bool saveSnapshot(const string& path) const;
+    // Replace the contents with a snapshot, built at its final size without rehashing
+    // returns false and keeps the contents if the file is missing or malformed
+    bool loadSnapshot(const string& path);
+    // Write a snapshot from a forked child while this process keeps serving
+    // The child sees both tables exactly as they were at the call, migration included
+    // returns false if a background snapshot is still running or the fork failed
+    bool saveSnapshotAsync(const string& path);
+    // True while the background snapshot is still being written (does not block)
+    bool snapshotPending();
+    // Block until the background snapshot is finished, returns true if it was written
+    bool waitSnapshot();
+    // Append every successful insert/remove/updateID to log (nullptr turns logging off)
+    // With FSYNC_ALWAYS an operation returns only after its record is synced, or once the
+    // log has failed; the change then stands in memory only and log->failed() reports it
+    void setMutationLog(MutationLog* log);
+    // Run one transfer and expiry step without an operation, e.g. while a server is idle
+    // returns true while a migration is still in progress
+    bool advanceMigration();
+    // Counters, probe-length histograms and migration figures (counters are 0 with CACHE_NO_STATS)
+    CacheStats stats() const;
+    // Start all counters over
+    void resetStats();
+    // Heap bytes held by this cache: both tables, live and deleted nodes, key buffers,
+    // the auxiliary structures and the allocator's overhead on all of them
+    // Walks every slot, so it costs as much as a full scan
+    CacheMemory memoryUsage() const;
+    // Returns the number of live entries in both tables
+    int liveCount() const;
     void dump() const;
     private:
     hash_fn    m_hash;          // hash function
@@ -104,6 +255,44 @@ class Cache {
 
     int        m_transferIndex; // this can be used as a temporary place holder
                                 // during incremental transfer to scanning the table
+    unsigned int m_rehashEpoch; // incremented by every rehash, never 0, scan cursors carry it
+    bool       m_deferTransfer; // when true insert/remove skip their transfer step,
+                                // the owner (e.g. a combiner) calls transferPartOfTable itself
+
+    int        m_maxEntries;    // max live entries in bounded mode, 0 means unbounded
+    evict_t    m_evictPolicy;   // eviction policy in bounded mode
+    mutable Person* m_lruHead;  // most recently used entry
+    mutable Person* m_lruTail;  // least recently used entry, the next LRU victim
+    int        m_clockHand;     // CLOCK hand position in the current table
+    int        m_oldHand;       // CLOCK hand position in the old table, never behind m_transferIndex
+    int        m_evictDebt;     // evictions the running transfer step may perform for an insert (CLOCK)
+
+    bool       m_admission;     // TinyLFU admission filter in front of the main space
+    mutable FrequencySketch m_sketch;   // access frequencies seen by the admission filter
+    mutable Person* m_windowHead;       // most recent entry of the admission window
+    mutable Person* m_windowTail;       // oldest entry of the admission window, the next candidate
+    int        m_windowCount;   // entries in the admission window
+    int        m_windowCap;     // max entries in the admission window
+
+    TimingWheel m_timers;       // pending expiries of entries inserted with a TTL
+
+    bool          m_negFilter;    // true if the per-table filters are maintained
+    QuotientFilter m_currFilter;  // key fingerprints of the live entries in the current table
+    QuotientFilter m_oldFilter;   // key fingerprints of the live entries in the old table
+
+    bool       m_useIDIndex;    // true if m_idIndex is maintained
+    IdIndex    m_idIndex;       // live entries of both tables ordered by ID
+
+    bool       m_keyGroups;     // true if the key group chains are maintained
+    unordered_map<string, Person*> m_keyHeads;  // first entry of every key group
+
+    MutationLog* m_log;         // receives every successful mutation, not owned
+
+    mutable CacheStats m_stats; // counters, only touched through CACHE_STAT
+    mutable int m_opProbes;     // slots examined by the running operation
+
+    int        m_snapshotChild; // pid of the background snapshot writer, 0 if none
+    bool       m_snapshotOK;    // result of the last finished background snapshot
 
     //private helper functions
     bool isPrime(int number);
@@ -119,5 +308,32 @@ class Cache {
     void reinsertFromOld(Person* p);
     void startNewRehash();
     void transferPartOfTable();
+    void markDeleted(Person** table, int index);
+    bool deleteEntry(Person* p);
+    void logMutation(logop_t op, const string& key, int id, long long arg);
+    // Add the slots the operation examined to its histogram
+    void recordProbes(statop_t op) const;
+    bool evictOne();
+    bool evictClock();
+    Person* clockVictim();
+    void trackEntry(Person* p);
+    void untrackEntry(Person* p);
+    void touchEntry(Person* p) const;
+    void joinMain(Person* p);
+    void admitFromWindow();
+    void sizeAdmission();
+    unsigned long long sketchHash(const string& key, int id) const;
+    static unsigned long long mixHash(unsigned long long h);
+    void buildFilter(QuotientFilter& filter, Person** table, int capacity);
+    void collectByID(int lo, int hi, vector<Person*>& out) const;
+    void freeTables();
+    void tableMemory(Person** table, int capacity, CacheMemory& usage) const;
+    void linkKeyGroup(Person* p);
+    void unlinkKeyGroup(Person* p);
+    long long nowMs() const;
+    bool isExpired(const Person* p) const;
+    void expireDue();
+    static void linkFront(Person* p, Person*& head, Person*& tail);
+    static void unlinkFrom(Person* p, Person*& head, Person*& tail);
 };
 #endif
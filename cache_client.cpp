@@ -0,0 +1,232 @@
+// Cache Client Implementation
+#include "cache_client.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Constructor
+CacheClient::CacheClient() {
+    m_fd = -1;
+}
+
+// Destructor
+CacheClient::~CacheClient() {
+    disconnect();
+}
+
+// connectTCP: Connect to a server on host:port
+bool CacheClient::connectTCP(const string& host, int port) {
+    disconnect();
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &found) != 0) {
+        return false;
+    }
+    for (addrinfo* a = found; a != nullptr && m_fd < 0; a = a->ai_next) {
+        int fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) {
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            m_fd = fd;
+        } else {
+            close(fd);
+        }
+    }
+    freeaddrinfo(found);
+    return m_fd >= 0;
+}
+
+// connectUnix: Connect to a server's Unix socket
+bool CacheClient::connectUnix(const string& path) {
+    disconnect();
+    sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    m_fd = fd;
+    return true;
+}
+
+// disconnect: Close the connection and drop anything buffered
+void CacheClient::disconnect() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_queued.clear();
+    m_in.clear();
+}
+
+// queue: Encode a command as a RESP array of bulk strings
+void CacheClient::queue(const vector<string>& args) {
+    m_queued += "*" + to_string(args.size()) + "\r\n";
+    for (unsigned int i = 0; i < args.size(); i++) {
+        m_queued += "$" + to_string(args[i].size()) + "\r\n" + args[i] + "\r\n";
+    }
+}
+
+// sendQueued: Send every queued command in one write
+bool CacheClient::sendQueued() {
+    bool ok = writeAll(m_queued);
+    m_queued.clear();
+    return ok;
+}
+
+// writeAll: Write until every byte is out
+bool CacheClient::writeAll(const string& data) {
+    if (m_fd < 0) {
+        return false;
+    }
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = send(m_fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            disconnect();
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// readLine: Take one CRLF terminated line off the receive buffer
+bool CacheClient::readLine(string& line) {
+    size_t end;
+    while ((end = m_in.find("\r\n")) == string::npos) {
+        if (m_fd < 0) {
+            return false;
+        }
+        char buffer[16 * 1024];
+        ssize_t n = recv(m_fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            disconnect();
+            return false;
+        }
+        m_in.append(buffer, n);
+    }
+    line = m_in.substr(0, end);
+    m_in.erase(0, end + 2);
+    return true;
+}
+
+// readReply: Decode the next reply, the server only answers with single line replies
+bool CacheClient::readReply(CacheReply& reply) {
+    string line;
+    if (readLine(line) == false || line.empty()) {
+        return false;
+    }
+    reply.m_integer = 0;
+    reply.m_text.clear();
+    if (line[0] == '+') {
+        reply.m_type = REPLY_STATUS;
+        reply.m_text = line.substr(1);
+    } else if (line[0] == '-') {
+        reply.m_type = REPLY_ERROR;
+        reply.m_text = line.substr(1);
+    } else if (line[0] == ':') {
+        reply.m_type = REPLY_INTEGER;
+        reply.m_integer = strtoll(line.c_str() + 1, nullptr, 10);
+    } else if (line == "$-1") {
+        reply.m_type = REPLY_NIL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// command: One round trip
+bool CacheClient::command(const vector<string>& args, CacheReply& reply) {
+    queue(args);
+    return sendQueued() && readReply(reply);
+}
+
+// insert: Inserts on the server
+bool CacheClient::insert(Person person, int ttl) {
+    vector<string> args;
+    args.push_back("INSERT");
+    args.push_back(person.getKey());
+    args.push_back(to_string(person.getID()));
+    if (ttl > 0) {
+        args.push_back(to_string(ttl));
+    }
+    CacheReply reply;
+    return command(args, reply) && reply.m_type == REPLY_INTEGER && reply.m_integer == 1;
+}
+
+// remove: Removes on the server
+bool CacheClient::remove(Person person) {
+    vector<string> args;
+    args.push_back("REMOVE");
+    args.push_back(person.getKey());
+    args.push_back(to_string(person.getID()));
+    CacheReply reply;
+    return command(args, reply) && reply.m_type == REPLY_INTEGER && reply.m_integer == 1;
+}
+
+// getPerson: Looks up on the server
+const Person CacheClient::getPerson(string key, int ID) {
+    vector<string> args;
+    args.push_back("GET");
+    args.push_back(key);
+    args.push_back(to_string(ID));
+    CacheReply reply;
+    if (command(args, reply) && reply.m_type == REPLY_INTEGER) {
+        return Person(key, (int)reply.m_integer, true);
+    }
+    return Person("", 0, false);
+}
+
+// updateID: Updates on the server
+bool CacheClient::updateID(Person person, int ID) {
+    vector<string> args;
+    args.push_back("UPDATE");
+    args.push_back(person.getKey());
+    args.push_back(to_string(person.getID()));
+    args.push_back(to_string(ID));
+    CacheReply reply;
+    return command(args, reply) && reply.m_type == REPLY_INTEGER && reply.m_integer == 1;
+}
+
+// liveCount: Entries on the server
+int CacheClient::liveCount() {
+    CacheReply reply;
+    if (command(vector<string>(1, "COUNT"), reply) && reply.m_type == REPLY_INTEGER) {
+        return (int)reply.m_integer;
+    }
+    return -1;
+}
+
+// ping: True if the server answers
+bool CacheClient::ping() {
+    CacheReply reply;
+    return command(vector<string>(1, "PING"), reply) && reply.m_type == REPLY_STATUS && reply.m_text == "PONG";
+}
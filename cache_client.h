@@ -0,0 +1,55 @@
+// Cache Client (library for CacheServer)
+// Blocking client with the same core operations as Cache, plus a pipeline: queue any
+// number of commands, send them in one write, then read the replies in order
+#ifndef CACHE_CLIENT_H
+#define CACHE_CLIENT_H
+
+#include "cache.h"
+
+enum reply_t {REPLY_STATUS, REPLY_ERROR, REPLY_INTEGER, REPLY_NIL};
+
+// One decoded server reply
+struct CacheReply {
+    reply_t   m_type;
+    long long m_integer;    // value of REPLY_INTEGER
+    string    m_text;       // text of REPLY_STATUS and REPLY_ERROR
+    CacheReply() : m_type(REPLY_NIL), m_integer(0) {}
+};
+
+class CacheClient {
+public:
+    CacheClient();
+    ~CacheClient();
+
+    bool connectTCP(const string& host, int port);
+    bool connectUnix(const string& path);
+    bool isConnected() const { return m_fd >= 0; }
+    void disconnect();
+
+    // Core operations (same as Cache), false or an empty Person also on connection errors
+    bool insert(Person person, int ttl = 0);
+    bool remove(Person person);
+    const Person getPerson(string key, int ID);
+    bool updateID(Person person, int ID);
+    // Number of live entries on the server, -1 on errors
+    int liveCount();
+    bool ping();
+
+    // Pipelining: queue commands, send them all at once, read one reply per command
+    void queue(const vector<string>& args);
+    bool sendQueued();
+    bool readReply(CacheReply& reply);
+    // Send one command and wait for its reply
+    bool command(const vector<string>& args, CacheReply& reply);
+
+private:
+    bool writeAll(const string& data);
+    // Take one line off the receive buffer, reading more as needed
+    bool readLine(string& line);
+
+    int    m_fd;
+    string m_queued;    // encoded commands not sent yet
+    string m_in;        // received bytes not decoded yet
+};
+
+#endif // CACHE_CLIENT_H
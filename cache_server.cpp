@@ -0,0 +1,395 @@
+// Cache Server Implementation
+#include "cache_server.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// setNonBlocking: Every socket of the loop is non-blocking
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Constructor
+CacheServer::CacheServer(Cache& cache) : m_cache(cache) {
+    m_epoll = epoll_create1(0);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK);
+    m_port = 0;
+    m_running = false;
+    m_idleSteps = 0;
+    if (m_epoll >= 0 && m_wakeFd >= 0) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = m_wakeFd;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev);
+    }
+}
+
+// Destructor
+CacheServer::~CacheServer() {
+    while (m_connections.empty() == false) {
+        closeConnection(m_connections.begin()->first);
+    }
+    for (unsigned int i = 0; i < m_listeners.size(); i++) {
+        close(m_listeners[i]);
+    }
+    if (m_unixPath.empty() == false) {
+        unlink(m_unixPath.c_str());
+    }
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+    }
+    if (m_epoll >= 0) {
+        close(m_epoll);
+    }
+}
+
+// addListener: Register a listening socket with the loop
+bool CacheServer::addListener(int fd) {
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (listen(fd, SOMAXCONN) != 0 || setNonBlocking(fd) == false ||
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close(fd);
+        return false;
+    }
+    m_listeners.push_back(fd);
+    return true;
+}
+
+// listenTCP: Loopback only, the protocol has no authentication
+bool CacheServer::listenTCP(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    socklen_t length = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &length);
+    m_port = ntohs(addr.sin_port);
+    return addListener(fd);
+}
+
+// listenUnix: Listen on a socket file
+bool CacheServer::listenUnix(const string& path) {
+    sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    m_unixPath = path;
+    return addListener(fd);
+}
+
+// stop: Wake the loop through the eventfd
+void CacheServer::stop() {
+    uint64_t one = 1;
+    ssize_t n = write(m_wakeFd, &one, sizeof(one));
+    (void)n;
+}
+
+// run: Serve until stopped
+// While a migration is in progress epoll_wait does not block, and a wait that returns no
+// events means every client is idle, so that time goes to the migration instead
+bool CacheServer::run() {
+    if (m_epoll < 0 || m_wakeFd < 0 || m_listeners.empty()) {
+        return false;
+    }
+    bool migrating = m_cache.advanceMigration();
+    epoll_event events[SERVERMAXEVENTS];
+    m_running = true;
+    while (m_running) {
+        int count = epoll_wait(m_epoll, events, SERVERMAXEVENTS, migrating ? 0 : -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (count == 0) {
+            migrating = m_cache.advanceMigration();
+            m_idleSteps++;
+            continue;
+        }
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == m_wakeFd) {
+                m_running = false;
+                continue;
+            }
+            bool listener = false;
+            for (unsigned int l = 0; l < m_listeners.size(); l++) {
+                if (m_listeners[l] == fd) {
+                    listener = true;
+                }
+            }
+            if (listener) {
+                acceptClients(fd);
+                continue;
+            }
+            map<int, Connection>::iterator it = m_connections.find(fd);
+            if (it == m_connections.end()) {
+                continue;
+            }
+            bool keep = true;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                keep = false;
+            }
+            if (keep && (events[i].events & EPOLLOUT)) {
+                keep = handleWrite(fd, it->second);
+            }
+            if (keep && (events[i].events & EPOLLIN)) {
+                keep = handleRead(fd, it->second);
+            }
+            if (keep == false) {
+                closeConnection(fd);
+            }
+        }
+        // Any operation may have started a rehash
+        migrating = true;
+    }
+    // Reset the eventfd so the server can run again
+    uint64_t value;
+    ssize_t n = read(m_wakeFd, &value, sizeof(value));
+    (void)n;
+    return true;
+}
+
+// acceptClients: Accept every pending connection
+void CacheServer::acceptClients(int listener) {
+    while (true) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        setNonBlocking(fd);
+        int on = 1;
+        // Fails harmlessly on Unix sockets
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        Connection& conn = m_connections[fd];
+        conn.m_outPos = 0;
+        conn.m_writing = false;
+    }
+}
+
+// closeConnection: Drop a client and its buffers
+void CacheServer::closeConnection(int fd) {
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_connections.erase(fd);
+}
+
+// handleRead: Drain the socket, run the complete commands, answer them in one write
+bool CacheServer::handleRead(int fd, Connection& conn) {
+    char buffer[SERVERREADSIZE];
+    bool open = true;
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.m_in.append(buffer, n);
+            if ((size_t)n < sizeof(buffer)) {
+                break;
+            }
+        } else if (n == 0) {
+            open = false;
+            break;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    size_t pos = 0;
+    vector<string> args;
+    while (true) {
+        int parsed = parseCommand(conn.m_in, pos, args);
+        if (parsed == 0) {
+            break;
+        }
+        if (parsed < 0) {
+            // The stream cannot be resynchronized after a framing error
+            conn.m_out += "-ERR protocol error\r\n";
+            conn.m_in.clear();
+            pos = 0;
+            open = false;
+            break;
+        }
+        execute(args, conn.m_out);
+    }
+    conn.m_in.erase(0, pos);
+    if (conn.m_in.size() > SERVERMAXINPUT) {
+        return false;
+    }
+    if (handleWrite(fd, conn) == false) {
+        return false;
+    }
+    // A closed or broken peer still gets the replies that fit into the socket
+    return open;
+}
+
+// handleWrite: Write pending replies, wait for EPOLLOUT if the socket is full
+bool CacheServer::handleWrite(int fd, Connection& conn) {
+    while (conn.m_outPos < conn.m_out.size()) {
+        ssize_t n = send(fd, conn.m_out.data() + conn.m_outPos, conn.m_out.size() - conn.m_outPos, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.m_outPos += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    if (conn.m_outPos == conn.m_out.size()) {
+        conn.m_out.clear();
+        conn.m_outPos = 0;
+    }
+    bool wantWrite = (conn.m_out.empty() == false);
+    if (wantWrite != conn.m_writing) {
+        epoll_event ev;
+        ev.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev);
+        conn.m_writing = wantWrite;
+    }
+    return true;
+}
+
+// parseInt: Strict decimal parse, the whole string must be a number that fits an int
+bool CacheServer::parseInt(const string& text, int& value) {
+    if (text.empty() || text.size() > 11) {
+        return false;
+    }
+    char* end = nullptr;
+    long long parsed = strtoll(text.c_str(), &end, 10);
+    if (end != text.c_str() + text.size() || parsed < INT_MIN || parsed > INT_MAX) {
+        return false;
+    }
+    value = (int)parsed;
+    return true;
+}
+
+// parseCommand: RESP array of bulk strings, e.g. *2\r\n$3\r\nGET\r\n...
+int CacheServer::parseCommand(string& input, size_t& pos, vector<string>& args) {
+    args.clear();
+    size_t cursor = pos;
+    if (cursor >= input.size()) {
+        return 0;
+    }
+    if (input[cursor] != '*') {
+        return -1;
+    }
+    size_t lineEnd = input.find("\r\n", cursor);
+    if (lineEnd == string::npos) {
+        return (input.size() - cursor > 32) ? -1 : 0;
+    }
+    int count = 0;
+    if (parseInt(input.substr(cursor + 1, lineEnd - cursor - 1), count) == false ||
+        count < 1 || count > SERVERMAXARGS) {
+        return -1;
+    }
+    cursor = lineEnd + 2;
+    for (int i = 0; i < count; i++) {
+        if (cursor >= input.size()) {
+            return 0;
+        }
+        if (input[cursor] != '$') {
+            return -1;
+        }
+        lineEnd = input.find("\r\n", cursor);
+        if (lineEnd == string::npos) {
+            return (input.size() - cursor > 32) ? -1 : 0;
+        }
+        int length = 0;
+        if (parseInt(input.substr(cursor + 1, lineEnd - cursor - 1), length) == false ||
+            length < 0 || (size_t)length > SERVERMAXARG) {
+            return -1;
+        }
+        cursor = lineEnd + 2;
+        if (input.size() - cursor < (size_t)length + 2) {
+            return 0;
+        }
+        if (input.compare(cursor + length, 2, "\r\n") != 0) {
+            return -1;
+        }
+        args.push_back(input.substr(cursor, length));
+        cursor += length + 2;
+    }
+    pos = cursor;
+    return 1;
+}
+
+// execute: Run one command against the cache and append its reply
+void CacheServer::execute(const vector<string>& args, string& out) {
+    string name = args[0];
+    for (unsigned int i = 0; i < name.size(); i++) {
+        name[i] = toupper((unsigned char)name[i]);
+    }
+    int id = 0;
+    int arg = 0;
+    if (name == "PING" && args.size() == 1) {
+        out += "+PONG\r\n";
+    } else if (name == "COUNT" && args.size() == 1) {
+        out += ":" + to_string(m_cache.liveCount()) + "\r\n";
+    } else if (name == "INSERT" && (args.size() == 3 || args.size() == 4) && parseInt(args[2], id)) {
+        if (args.size() == 4 && (parseInt(args[3], arg) == false || arg < 0)) {
+            out += "-ERR invalid ttl\r\n";
+            return;
+        }
+        bool done = m_cache.insert(Person(args[1], id, true), arg);
+        out += done ? ":1\r\n" : ":0\r\n";
+    } else if (name == "REMOVE" && args.size() == 3 && parseInt(args[2], id)) {
+        out += m_cache.remove(Person(args[1], id, true)) ? ":1\r\n" : ":0\r\n";
+    } else if (name == "GET" && args.size() == 3 && parseInt(args[2], id)) {
+        Person found = m_cache.getPerson(args[1], id);
+        if (found.getKey() == "") {
+            out += "$-1\r\n";
+        } else {
+            out += ":" + to_string(found.getID()) + "\r\n";
+        }
+    } else if (name == "UPDATE" && args.size() == 4 && parseInt(args[2], id) && parseInt(args[3], arg)) {
+        out += m_cache.updateID(Person(args[1], id, true), arg) ? ":1\r\n" : ":0\r\n";
+    } else {
+        out += "-ERR unknown command or wrong arguments\r\n";
+    }
+}
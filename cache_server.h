@@ -0,0 +1,77 @@
+// Cache Server (network front end)
+// One thread runs an epoll event loop over TCP and Unix socket clients and applies their
+// commands to a single Cache. Requests use the RESP array format, so redis-cli works too.
+// Every complete command in a read is executed and the replies go out in one write
+// (pipelining), and the migration advances whenever the loop has nothing else to do
+#ifndef CACHE_SERVER_H
+#define CACHE_SERVER_H
+
+#include "cache.h"
+#include <map>
+
+const int SERVERMAXEVENTS = 64;             // events taken per epoll_wait
+const size_t SERVERREADSIZE = 64 * 1024;    // bytes read per recv
+const size_t SERVERMAXARG = 1 << 20;        // longest bulk string accepted
+const int SERVERMAXARGS = 16;               // most arguments accepted in one command
+const size_t SERVERMAXINPUT = 16 << 20;     // unparsed input that closes the connection
+
+// Commands (arguments in brackets are optional, ttl in milliseconds):
+//   PING                       +PONG
+//   INSERT key id [ttl]        :1 or :0
+//   REMOVE key id              :1 or :0
+//   GET key id                 :id or nil ($-1)
+//   UPDATE key id newid        :1 or :0
+//   COUNT                      :live entries
+class CacheServer {
+public:
+    // Serve cache, which must not be used by anybody else while the server runs
+    CacheServer(Cache& cache);
+    ~CacheServer();
+
+    // Listen on 127.0.0.1:port, port 0 picks a free one (see getPort)
+    bool listenTCP(int port);
+    // Listen on a Unix socket, an old socket file at path is replaced
+    bool listenUnix(const string& path);
+    // Run the event loop until stop is called, returns false if it could not start
+    bool run();
+    // Make run return, safe to call from any thread
+    void stop();
+
+    int getPort() const { return m_port; }
+    // Expose for testing
+    int getIdleSteps() const { return m_idleSteps; }
+
+private:
+    // Buffers of one client connection
+    struct Connection {
+        string m_in;            // received bytes not parsed yet
+        string m_out;           // replies not written yet
+        size_t m_outPos;        // bytes of m_out already written
+        bool   m_writing;       // registered for EPOLLOUT because a write was short
+    };
+
+    bool addListener(int fd);
+    void acceptClients(int listener);
+    // Read what is available, execute every complete command, then write the replies
+    // returns false if the connection is to be closed
+    bool handleRead(int fd, Connection& conn);
+    bool handleWrite(int fd, Connection& conn);
+    void closeConnection(int fd);
+    // Parse one command from the front of input, returns 1 if a command was taken,
+    // 0 if more bytes are needed and -1 on a protocol error
+    int parseCommand(string& input, size_t& pos, vector<string>& args);
+    void execute(const vector<string>& args, string& out);
+    static bool parseInt(const string& text, int& value);
+
+    Cache&   m_cache;
+    int      m_epoll;
+    int      m_wakeFd;          // eventfd written by stop
+    vector<int> m_listeners;
+    map<int, Connection> m_connections;
+    int      m_port;
+    string   m_unixPath;
+    bool     m_running;
+    int      m_idleSteps;       // migration steps taken while no client had work
+};
+
+#endif // CACHE_SERVER_H
@@ -0,0 +1,167 @@
+// Cache Statistics Implementation
+#include "cache_stats.h"
+#include <cstring>
+#include <sstream>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Label values of statop_t
+static const char* opNames[STATOPS] = {"get", "insert", "remove", "update"};
+
+// Constructor: everything starts at zero
+CacheStats::CacheStats() {
+    memset(this, 0, sizeof(CacheStats));
+}
+
+// migrationProgress: Transfer index over the old capacity
+float CacheStats::migrationProgress() const {
+    if (m_migrating == false || m_oldCap == 0) {
+        return 1.0;
+    }
+    float progress = float(m_transferIndex) / m_oldCap;
+    return progress > 1.0 ? 1.0 : progress;
+}
+
+// toPrometheus: One HELP and TYPE line per metric family, then its samples
+std::string CacheStats::toPrometheus(const std::string& prefix) const {
+    std::ostringstream out;
+    out << "# HELP " << prefix << "_ops_total Cache operations by type and result.\n";
+    out << "# TYPE " << prefix << "_ops_total counter\n";
+    out << prefix << "_ops_total{op=\"get\",result=\"hit\"} " << m_hits << "\n";
+    out << prefix << "_ops_total{op=\"get\",result=\"miss\"} " << m_misses << "\n";
+    out << prefix << "_ops_total{op=\"insert\",result=\"ok\"} " << m_inserts << "\n";
+    out << prefix << "_ops_total{op=\"insert\",result=\"failed\"} " << m_failedInserts << "\n";
+    out << prefix << "_ops_total{op=\"remove\",result=\"ok\"} " << m_removes << "\n";
+    out << prefix << "_ops_total{op=\"remove\",result=\"failed\"} " << m_failedRemoves << "\n";
+    out << prefix << "_ops_total{op=\"update\",result=\"ok\"} " << m_updates << "\n";
+    out << prefix << "_ops_total{op=\"update\",result=\"failed\"} " << m_failedUpdates << "\n";
+    out << "# HELP " << prefix << "_evictions_total Entries evicted in bounded mode.\n";
+    out << "# TYPE " << prefix << "_evictions_total counter\n";
+    out << prefix << "_evictions_total " << m_evictions << "\n";
+    out << "# HELP " << prefix << "_expirations_total Entries reclaimed after their TTL.\n";
+    out << "# TYPE " << prefix << "_expirations_total counter\n";
+    out << prefix << "_expirations_total " << m_expirations << "\n";
+
+    out << "# HELP " << prefix << "_probe_length Slots examined per operation.\n";
+    out << "# TYPE " << prefix << "_probe_length histogram\n";
+    for (int op = 0; op < STATOPS; op++) {
+        unsigned long long cumulative = 0;
+        for (int b = 0; b < PROBEBUCKETS - 1; b++) {
+            cumulative += m_probes[op][b];
+            out << prefix << "_probe_length_bucket{op=\"" << opNames[op] << "\",le=\"" << b << "\"} " << cumulative << "\n";
+        }
+        cumulative += m_probes[op][PROBEBUCKETS - 1];
+        out << prefix << "_probe_length_bucket{op=\"" << opNames[op] << "\",le=\"+Inf\"} " << cumulative << "\n";
+        out << prefix << "_probe_length_sum{op=\"" << opNames[op] << "\"} " << m_probeSum[op] << "\n";
+        out << prefix << "_probe_length_count{op=\"" << opNames[op] << "\"} " << cumulative << "\n";
+    }
+
+    out << "# HELP " << prefix << "_rehashes_total Rehashes started.\n";
+    out << "# TYPE " << prefix << "_rehashes_total counter\n";
+    out << prefix << "_rehashes_total " << m_rehashes << "\n";
+    out << "# HELP " << prefix << "_transfer_steps_total Incremental transfer steps.\n";
+    out << "# TYPE " << prefix << "_transfer_steps_total counter\n";
+    out << prefix << "_transfer_steps_total " << m_transferSteps << "\n";
+    out << "# HELP " << prefix << "_transfer_seconds_total Time spent moving entries to the new table.\n";
+    out << "# TYPE " << prefix << "_transfer_seconds_total counter\n";
+    out << prefix << "_transfer_seconds_total " << m_transferNs / 1e9 << "\n";
+    out << "# HELP " << prefix << "_migration_progress Share of the running migration done, 1 if none.\n";
+    out << "# TYPE " << prefix << "_migration_progress gauge\n";
+    out << prefix << "_migration_progress " << migrationProgress() << "\n";
+
+    out << "# HELP " << prefix << "_entries Live entries in both tables.\n";
+    out << "# TYPE " << prefix << "_entries gauge\n";
+    out << prefix << "_entries " << m_liveEntries << "\n";
+    out << "# HELP " << prefix << "_capacity Slots in the current table.\n";
+    out << "# TYPE " << prefix << "_capacity gauge\n";
+    out << prefix << "_capacity " << m_capacity << "\n";
+    out << "# HELP " << prefix << "_load_factor Occupied share of the current table, deleted slots included.\n";
+    out << "# TYPE " << prefix << "_load_factor gauge\n";
+    out << prefix << "_load_factor " << m_lambda << "\n";
+    out << "# HELP " << prefix << "_deleted_ratio Deleted share of the occupied slots.\n";
+    out << "# TYPE " << prefix << "_deleted_ratio gauge\n";
+    out << prefix << "_deleted_ratio " << m_deletedRatio << "\n";
+    return out.str();
+}
+
+// heapFootprint: The block's usable size plus its size field, or glibc's chunk rounding
+// (the request plus one size_t, in 16-byte steps, at least 32 bytes) when there is no block
+size_t heapFootprint(const void* block, size_t requested) {
+#if defined(__GLIBC__)
+    if (block != nullptr) {
+        return malloc_usable_size(const_cast<void*>(block)) + sizeof(size_t);
+    }
+#endif
+    const size_t align = 2 * sizeof(size_t);
+    size_t chunk = (requested + sizeof(size_t) + align - 1) & ~(align - 1);
+    return chunk < 2 * align ? 2 * align : chunk;
+}
+
+// addBlock: Count the request, the rest of the footprint is overhead
+void HeapBytes::addBlock(const void* block, size_t requested) {
+    size_t footprint = heapFootprint(block, requested);
+    m_blocks++;
+    m_requested += requested;
+    m_overhead += footprint > requested ? footprint - requested : 0;
+}
+
+// addString: A buffer that lies inside the string object is the short string buffer
+void HeapBytes::addString(const std::string& s) {
+    const char* data = s.data();
+    const char* object = reinterpret_cast<const char*>(&s);
+    if (s.capacity() == 0 || (data >= object && data < object + sizeof(std::string))) {
+        return;
+    }
+#if defined(_GLIBCXX_USE_CXX11_ABI) && _GLIBCXX_USE_CXX11_ABI
+    addBlock(data, s.capacity() + 1);
+#else
+    // A copy-on-write buffer starts before data(), only its size is known
+    addBlock(nullptr, s.capacity() + 1);
+#endif
+}
+
+void HeapBytes::add(const HeapBytes& other) {
+    m_blocks += other.m_blocks;
+    m_requested += other.m_requested;
+    m_overhead += other.m_overhead;
+}
+
+// Constructor
+CacheMemory::CacheMemory() {
+    m_object = 0;
+    m_liveEntries = 0;
+    m_tombstoneCount = 0;
+}
+
+// heap: Every part except m_oldTable, which m_tables already holds
+unsigned long long CacheMemory::heap() const {
+    return m_tables.total() + m_nodes.total() + m_keys.total() + m_tombstones.total() + m_aux.total();
+}
+
+unsigned long long CacheMemory::overhead() const {
+    return m_tables.m_overhead + m_nodes.m_overhead + m_keys.m_overhead +
+           m_tombstones.m_overhead + m_aux.m_overhead;
+}
+
+double CacheMemory::bytesPerEntry() const {
+    return m_liveEntries > 0 ? double(total()) / m_liveEntries : 0;
+}
+
+// toString: Requested bytes per part, then the allocator overhead of all of them
+std::string CacheMemory::toString() const {
+    std::ostringstream out;
+    out << "tables      " << m_tables.m_requested << " B";
+    if (m_oldTable.m_blocks > 0) {
+        out << " (old table " << m_oldTable.m_requested << " B)";
+    }
+    out << "\n";
+    out << "nodes       " << m_nodes.m_requested << " B, " << m_liveEntries << " entries\n";
+    out << "keys        " << m_keys.m_requested << " B in " << m_keys.m_blocks << " heap buffers\n";
+    out << "tombstones  " << m_tombstones.m_requested << " B, " << m_tombstoneCount << " entries\n";
+    out << "auxiliary   " << m_aux.m_requested << " B\n";
+    out << "overhead    " << overhead() << " B\n";
+    out << "object      " << m_object << " B\n";
+    out << "total       " << total() << " B, " << bytesPerEntry() << " B per entry\n";
+    return out.str();
+}
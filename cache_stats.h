@@ -0,0 +1,105 @@
+// Cache Statistics
+// Operation counters, probe-length histograms and migration figures of one Cache,
+// returned by Cache::stats() and printable in the Prometheus text format
+// Compiling with -DCACHE_NO_STATS removes the counting from the hot paths, stats() then
+// still reports the table figures but every counter stays 0
+// CacheMemory is the heap footprint of one Cache, returned by Cache::memoryUsage()
+#ifndef CACHE_STATS_H
+#define CACHE_STATS_H
+
+#include <string>
+#include <stddef.h>
+
+const int PROBEBUCKETS = 16;    // probe lengths 0..14 each get a bucket, the last one holds 15+
+
+enum statop_t {STAT_GET, STAT_INSERT, STAT_REMOVE, STAT_UPDATE, STATOPS};  // histogram per operation
+
+#ifdef CACHE_NO_STATS
+#define CACHE_STAT(statement)
+#else
+#define CACHE_STAT(statement) statement
+#endif
+
+struct CacheStats {
+    // Operation counters
+    unsigned long long m_hits;
+    unsigned long long m_misses;
+    unsigned long long m_inserts;
+    unsigned long long m_failedInserts;     // invalid ID, duplicate or no free slot
+    unsigned long long m_removes;
+    unsigned long long m_failedRemoves;     // nothing to remove
+    unsigned long long m_updates;
+    unsigned long long m_failedUpdates;
+    unsigned long long m_evictions;         // bounded mode
+    unsigned long long m_expirations;       // reclaimed by the timing wheel
+
+    // Slots examined per operation, bucket 0 holds operations answered without probing
+    // (a miss ruled out by the negative filter, an invalid ID)
+    unsigned long long m_probes[STATOPS][PROBEBUCKETS];
+    unsigned long long m_probeSum[STATOPS];
+
+    // Rehashing
+    unsigned long long m_rehashes;          // rehashes started
+    unsigned long long m_transferSteps;     // transferPartOfTable calls that moved entries
+    unsigned long long m_transferNs;        // time spent in those calls
+    bool m_migrating;
+    int  m_transferIndex;                   // progress of the running migration ...
+    int  m_oldCap;                          // ... through the old table of this size
+
+    // Table figures, filled in by stats() whether counting is compiled in or not
+    int   m_liveEntries;
+    int   m_capacity;
+    float m_lambda;
+    float m_deletedRatio;
+
+    CacheStats();
+    // Share of the running migration that is done, 1 when none is running
+    float migrationProgress() const;
+    // Prometheus text exposition format, every metric name starts with prefix
+    std::string toPrometheus(const std::string& prefix = "hashcache") const;
+};
+
+// Heap bytes of a group of allocations: what was asked for, and what the allocator adds
+// on top (chunk headers, rounding). With glibc the overhead is read off every block with
+// malloc_usable_size, elsewhere it is estimated from glibc's chunk layout
+struct HeapBytes {
+    unsigned long long m_blocks;
+    unsigned long long m_requested;
+    unsigned long long m_overhead;
+
+    HeapBytes() : m_blocks(0), m_requested(0), m_overhead(0) {}
+    // Add one block of requested bytes, block may be nullptr when only the size is known
+    void addBlock(const void* block, size_t requested);
+    // Add the heap buffer of a string, nothing for short strings stored inside the object
+    void addString(const std::string& s);
+    void add(const HeapBytes& other);
+    unsigned long long total() const { return m_requested + m_overhead; }
+};
+
+// Bytes the allocator really holds for a block of requested bytes, the counting
+// allocator of the memory benchmark uses the same rule
+size_t heapFootprint(const void* block, size_t requested);
+
+struct CacheMemory {
+    HeapBytes m_tables;         // Person* arrays of both generations
+    HeapBytes m_oldTable;       // the old generation's array alone, also counted in m_tables
+    HeapBytes m_nodes;          // live Person nodes
+    HeapBytes m_keys;           // heap buffers of live keys
+    HeapBytes m_tombstones;     // deleted nodes still in a table, with their key buffers
+    HeapBytes m_aux;            // filters, sketch, ID index, timing wheel, key groups
+    size_t    m_object;         // sizeof(Cache), wherever the Cache itself lives
+    int       m_liveEntries;
+    int       m_tombstoneCount;
+
+    CacheMemory();
+    // Heap bytes, everything but the Cache object
+    unsigned long long heap() const;
+    unsigned long long overhead() const;
+    unsigned long long total() const { return heap() + m_object; }
+    // total() over the live entries, 0 for an empty cache
+    double bytesPerEntry() const;
+    // One line per part, for reports
+    std::string toString() const;
+};
+
+#endif // CACHE_STATS_H
@@ -0,0 +1,244 @@
+// Flat-Combining Cache Implementation
+#include "combining_cache.h"
+#include <thread>
+#include <vector>
+
+// Names every CombiningCache, an ID is never handed out twice
+static std::atomic<unsigned long long> nextInstanceID(1);
+
+// A slot the calling thread holds in one CombiningCache
+struct HeldSlot {
+    unsigned long long          m_instanceID;
+    int                         m_index;
+    std::weak_ptr<SlotRegistry> m_registry;
+};
+
+// The slots of one thread, handed back when the thread exits
+struct ThreadSlots {
+    std::vector<HeldSlot> m_held;
+    ~ThreadSlots() {
+        for (unsigned int i = 0; i < m_held.size(); i++) {
+            std::shared_ptr<SlotRegistry> registry = m_held[i].m_registry.lock();
+            if (registry) {
+                registry->release(m_held[i].m_index);
+            }
+        }
+    }
+};
+static thread_local ThreadSlots threadSlots;
+
+// acquire: Claim the lowest free slot and raise the high-water mark the combiner scans to
+int SlotRegistry::acquire() {
+    for (int i = 0; i < MAXCOMBTHREADS; i++) {
+        bool expected = false;
+        if (m_taken[i].load(std::memory_order_relaxed) == false &&
+            m_taken[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            int high = m_highWater.load(std::memory_order_relaxed);
+            while (high < i + 1 && m_highWater.compare_exchange_weak(high, i + 1) == false) {
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Constructor
+CombiningCache::CombiningCache(int size, hash_fn hash, prob_t probing)
+    : m_cache(size, hash, probing), m_registry(new SlotRegistry()) {
+    // The combiner runs the transfer step once per round instead of once per operation
+    m_cache.m_deferTransfer = true;
+    m_instanceID = nextInstanceID.fetch_add(1);
+    m_rounds = 0;
+    m_combinedOps = 0;
+    m_directOps = 0;
+    m_log = nullptr;
+}
+
+// setMutationLog: Hand the log to the table
+void CombiningCache::setMutationLog(MutationLog* log) {
+    std::lock_guard<std::mutex> guard(m_combinerLock);
+    m_log = log;
+    m_cache.setMutationLog(log);
+}
+
+// waitForLog: The table does not wait for the sync itself while combining
+void CombiningCache::waitForLog() {
+    if (m_log != nullptr && m_log->getPolicy() == FSYNC_ALWAYS) {
+        m_log->waitDurable(m_log->lastLSN());
+    }
+}
+
+// threadSlot: Get the slot index of the calling thread, claiming one on its first request
+int CombiningCache::threadSlot() {
+    std::vector<HeldSlot>& held = threadSlots.m_held;
+    for (unsigned int i = 0; i < held.size(); i++) {
+        if (held[i].m_instanceID == m_instanceID) {
+            return held[i].m_index;
+        }
+    }
+    // Forget the caches this thread used that no longer exist
+    for (unsigned int i = 0; i < held.size(); ) {
+        if (held[i].m_registry.expired()) {
+            held[i] = held.back();
+            held.pop_back();
+        } else {
+            i++;
+        }
+    }
+    // All slots taken: try again on the next request, a thread may have exited by then
+    int index = m_registry->acquire();
+    if (index >= 0) {
+        HeldSlot slot;
+        slot.m_instanceID = m_instanceID;
+        slot.m_index = index;
+        slot.m_registry = m_registry;
+        held.push_back(slot);
+    }
+    return index;
+}
+
+// apply: Run one published request against the table
+void CombiningCache::apply(PublicationSlot& slot) {
+    // Catch up on the migration if the new table fills before the old one is drained
+    if (m_cache.m_oldTable != nullptr && m_cache.lambda() > 0.5) {
+        m_cache.transferPartOfTable();
+    }
+    if (slot.m_op == COMB_INSERT) {
+        slot.m_result = m_cache.insert(slot.m_person);
+    } else if (slot.m_op == COMB_REMOVE) {
+        slot.m_result = m_cache.remove(slot.m_person);
+    } else if (slot.m_op == COMB_UPDATE) {
+        slot.m_result = m_cache.updateID(slot.m_person, slot.m_newID);
+    } else if (slot.m_op == COMB_GET) {
+        slot.m_found = m_cache.getPerson(slot.m_person.getKey(), slot.m_person.getID());
+    }
+}
+
+// combine: Apply all pending requests in a few passes over the slots
+// Must be called with the combiner lock held
+void CombiningCache::combine() {
+    int numSlots = m_registry->m_highWater.load(std::memory_order_acquire);
+    bool wrote = false;
+    // With a synced log the results are held back until the round's records are on disk,
+    // the slots stay pending meanwhile so this marks the ones already applied
+    bool holdResults = (m_log != nullptr && m_log->getPolicy() == FSYNC_ALWAYS);
+    bool done[MAXCOMBTHREADS] = {false};
+    for (int pass = 0; pass < COMBPASSES; pass++) {
+        int applied = 0;
+        for (int i = 0; i < numSlots; i++) {
+            if (done[i] == false && m_slots[i].m_state.load(std::memory_order_acquire) == SLOT_PENDING) {
+                apply(m_slots[i]);
+                if (m_slots[i].m_op != COMB_GET) {
+                    wrote = true;
+                }
+                done[i] = true;
+                // Hand the result back to the owner
+                if (holdResults == false) {
+                    m_slots[i].m_state.store(SLOT_DONE, std::memory_order_release);
+                }
+                applied++;
+            }
+        }
+        m_combinedOps += applied;
+        // Nothing new was published, no point in another pass
+        if (applied == 0) {
+            break;
+        }
+    }
+    // One amortized transfer and expiry step for the whole batch
+    if (wrote) {
+        finishWrites();
+    }
+    if (holdResults == true) {
+        // One sync for the whole round (group commit)
+        if (wrote) {
+            waitForLog();
+        }
+        for (int i = 0; i < numSlots; i++) {
+            if (done[i] == true) {
+                m_slots[i].m_state.store(SLOT_DONE, std::memory_order_release);
+            }
+        }
+    }
+    m_rounds++;
+}
+
+// finishWrites: The transfer and expiry steps the table defers to the combiner
+void CombiningCache::finishWrites() {
+    m_cache.transferPartOfTable();
+    m_cache.expireDue();
+}
+
+// submit: Publish the slot and wait for its result
+void CombiningCache::submit(PublicationSlot& slot) {
+    slot.m_state.store(SLOT_PENDING, std::memory_order_release);
+    while (slot.m_state.load(std::memory_order_acquire) != SLOT_DONE) {
+        // Become the combiner if nobody else is
+        if (m_combinerLock.try_lock()) {
+            combine();
+            m_combinerLock.unlock();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    slot.m_state.store(SLOT_EMPTY, std::memory_order_relaxed);
+}
+
+// requestSlot: The calling thread's own slot, a thread-local spare if every slot is taken
+PublicationSlot& CombiningCache::requestSlot() {
+    static thread_local PublicationSlot spare;
+    int index = threadSlot();
+    return index < 0 ? spare : m_slots[index];
+}
+
+// run: Threads without a slot take the lock and apply their request as a batch of one
+void CombiningCache::run(PublicationSlot& slot) {
+    if (&slot >= m_slots && &slot < m_slots + MAXCOMBTHREADS) {
+        submit(slot);
+        return;
+    }
+    std::lock_guard<std::mutex> guard(m_combinerLock);
+    apply(slot);
+    m_directOps++;
+    if (slot.m_op != COMB_GET) {
+        finishWrites();
+        waitForLog();
+    }
+}
+
+// insert: Inserts through the combiner
+bool CombiningCache::insert(Person person) {
+    PublicationSlot& slot = requestSlot();
+    slot.m_op = COMB_INSERT;
+    slot.m_person = person;
+    run(slot);
+    return slot.m_result;
+}
+
+// remove: Removes through the combiner
+bool CombiningCache::remove(Person person) {
+    PublicationSlot& slot = requestSlot();
+    slot.m_op = COMB_REMOVE;
+    slot.m_person = person;
+    run(slot);
+    return slot.m_result;
+}
+
+// updateID: Updates through the combiner
+bool CombiningCache::updateID(Person person, int ID) {
+    PublicationSlot& slot = requestSlot();
+    slot.m_op = COMB_UPDATE;
+    slot.m_person = person;
+    slot.m_newID = ID;
+    run(slot);
+    return slot.m_result;
+}
+
+// getPerson: Looks up through the combiner
+const Person CombiningCache::getPerson(string key, int ID) {
+    PublicationSlot& slot = requestSlot();
+    slot.m_op = COMB_GET;
+    slot.m_person = Person(key, ID, true);
+    run(slot);
+    return slot.m_found;
+}
\ No newline at end of file
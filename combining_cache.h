@@ -0,0 +1,94 @@
+// Flat-Combining Cache (shared single-shard front end)
+// Threads publish their request in a per-thread slot and whichever thread
+// holds the combiner lock applies every pending request against one Cache
+#ifndef COMBINING_CACHE_H
+#define COMBINING_CACHE_H
+
+#include "cache.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+const int MAXCOMBTHREADS = 64;  // number of publication slots
+const int COMBPASSES = 3;       // passes over the slots per combining round
+
+enum comb_op_t {COMB_INSERT, COMB_REMOVE, COMB_UPDATE, COMB_GET}; // request types
+enum comb_state_t {SLOT_EMPTY, SLOT_PENDING, SLOT_DONE};           // publication slot states
+
+// One publication slot, owned by a single thread
+// aligned to a cache line so two threads never write the same line
+struct alignas(64) PublicationSlot {
+    std::atomic<int> m_state;   // comb_state_t, handshake between owner and combiner
+    comb_op_t  m_op;            // requested operation
+    Person     m_person;        // operand (key and ID)
+    int        m_newID;         // new ID for COMB_UPDATE
+    bool       m_result;        // result of insert/remove/update
+    Person     m_found;         // result of get
+    PublicationSlot() : m_state(SLOT_EMPTY), m_op(COMB_GET), m_newID(0), m_result(false) {}
+};
+
+// Which publication slots of one CombiningCache are owned by a thread
+// Shared with the threads' slot handles so a thread that exits after the cache can still
+// find out that there is nothing left to give back
+struct SlotRegistry {
+    std::atomic<bool> m_taken[MAXCOMBTHREADS];
+    std::atomic<int>  m_highWater;      // one past the highest slot ever taken
+    SlotRegistry() : m_highWater(0) {
+        for (int i = 0; i < MAXCOMBTHREADS; i++) {
+            m_taken[i].store(false, std::memory_order_relaxed);
+        }
+    }
+    // Take the lowest free slot, -1 if all are taken
+    int acquire();
+    void release(int index) { m_taken[index].store(false, std::memory_order_release); }
+};
+
+// Same interface as Cache, safe to call from many threads
+// Each thread holds a slot of each instance it uses and hands it back when it exits,
+// so only MAXCOMBTHREADS threads at the same time are needed for the combining path
+class CombiningCache {
+public:
+    CombiningCache(int size, hash_fn hash, prob_t probing = DEFPOLCY);
+
+    bool insert(Person person);
+    bool remove(Person person);
+    bool updateID(Person person, int ID);
+    const Person getPerson(string key, int ID);
+    // Log the mutations, with FSYNC_ALWAYS the whole combining round shares one sync
+    void setMutationLog(MutationLog* log);
+
+    // Expose for benchmarking
+    int getCombineRounds() const { return m_rounds; }
+    int getCombinedOps() const { return m_combinedOps; }
+    // Requests of threads that found no free slot and took the lock directly
+    int getDirectOps() const { return m_directOps; }
+
+private:
+    // The calling thread's publication slot, or a spare outside m_slots if it has none
+    PublicationSlot& requestSlot();
+    // Apply the request through the combiner, or directly under the lock for a spare slot
+    void run(PublicationSlot& slot);
+    // Publish a request and wait until a combiner (possibly us) has applied it
+    void submit(PublicationSlot& slot);
+    // Apply every pending request, then do one amortized transfer step
+    void combine();
+    void apply(PublicationSlot& slot);
+    // Transfer and expiry work owed by a batch that changed the table
+    void finishWrites();
+    // With FSYNC_ALWAYS wait until everything applied so far is synced
+    void waitForLog();
+    // Index of the calling thread's slot in this instance, -1 if all slots are taken
+    int threadSlot();
+
+    Cache            m_cache;           // the shared table, touched only by the combiner
+    unsigned long long m_instanceID;    // never reused, names the instance in the thread handles
+    std::shared_ptr<SlotRegistry> m_registry;
+    MutationLog*     m_log;             // same log as m_cache, nullptr if none
+    std::mutex       m_combinerLock;    // held by the thread currently combining
+    PublicationSlot  m_slots[MAXCOMBTHREADS];
+    int              m_rounds;          // number of combining rounds (under the lock)
+    int              m_combinedOps;     // number of requests applied (under the lock)
+    int              m_directOps;       // requests applied without a slot (under the lock)
+};
+
+#endif // COMBINING_CACHE_H
@@ -0,0 +1,87 @@
+// Frequency Sketch Implementation
+#include "frequency_sketch.h"
+#include "cache_stats.h"
+
+// Odd 64-bit constants, one per row, to derive independent counter positions
+static const unsigned long long ROWSEEDS[SKETCHDEPTH] = {
+    0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+};
+
+// Constructor
+FrequencySketch::FrequencySketch() {
+    m_counterMask = 0;
+    m_additions = 0;
+    m_sampleSize = 0;
+    resize(1);
+}
+
+// resize: One 64-bit word (16 counters) per entry, rounded up to a power of two
+// A sample period sees about SKETCHAGEFACTOR keys per entry, so a smaller table
+// would saturate the counters of one-hit keys
+void FrequencySketch::resize(int maxEntries) {
+    if (maxEntries < 1) {
+        maxEntries = 1;
+    }
+    int words = 1;
+    while (words < maxEntries) {
+        words *= 2;
+    }
+    int counters = words * 16;
+    m_table.assign(words, 0);
+    m_counterMask = counters - 1;
+    m_additions = 0;
+    m_sampleSize = SKETCHAGEFACTOR * maxEntries;
+}
+
+// counterIndex: Multiply-shift hashing per row
+int FrequencySketch::counterIndex(unsigned long long hash, int row) const {
+    unsigned long long h = (hash + ROWSEEDS[row]) * ROWSEEDS[row];
+    h ^= h >> 32;
+    return (int)(h & m_counterMask);
+}
+
+// getCounter: Read one 4-bit counter
+int FrequencySketch::getCounter(int index) const {
+    return (int)((m_table[index >> 4] >> ((index & 15) << 2)) & 0xF);
+}
+
+// increment: Bump the key's counter in every row, saturating at SKETCHMAXCOUNT
+void FrequencySketch::increment(unsigned long long hash) {
+    for (int row = 0; row < SKETCHDEPTH; row++) {
+        int index = counterIndex(hash, row);
+        if (getCounter(index) < SKETCHMAXCOUNT) {
+            m_table[index >> 4] += 1ULL << ((index & 15) << 2);
+        }
+    }
+    m_additions++;
+    if (m_additions >= m_sampleSize) {
+        age();
+    }
+}
+
+// frequency: The smallest counter over all rows is the least overestimated one
+int FrequencySketch::frequency(unsigned long long hash) const {
+    int result = SKETCHMAXCOUNT;
+    for (int row = 0; row < SKETCHDEPTH; row++) {
+        int count = getCounter(counterIndex(hash, row));
+        if (count < result) {
+            result = count;
+        }
+    }
+    return result;
+}
+
+// age: Shift every counter right by one, the mask drops the bit shifted in from the neighbour
+void FrequencySketch::age() {
+    for (unsigned int i = 0; i < m_table.size(); i++) {
+        m_table[i] = (m_table[i] >> 1) & 0x7777777777777777ULL;
+    }
+    m_additions /= 2;
+}
+
+// memoryUsage: One block, the vector's capacity
+void FrequencySketch::memoryUsage(HeapBytes& bytes) const {
+    if (m_table.capacity() > 0) {
+        bytes.addBlock(m_table.data(), m_table.capacity() * sizeof(unsigned long long));
+    }
+}
@@ -0,0 +1,41 @@
+// Frequency Sketch for the TinyLFU admission filter
+// A count-min sketch of 4-bit counters packed 16 per 64-bit word, with periodic aging
+#ifndef FREQUENCY_SKETCH_H
+#define FREQUENCY_SKETCH_H
+
+#include <vector>
+
+struct HeapBytes;   // cache_stats.h
+
+const int SKETCHDEPTH = 4;      // counters updated per key (one per row)
+const int SKETCHMAXCOUNT = 15;  // a 4-bit counter saturates here
+const int SKETCHAGEFACTOR = 10; // counters are halved after this many additions per tracked entry
+
+class FrequencySketch {
+public:
+    FrequencySketch();
+    // Size the sketch for a cache holding up to maxEntries entries, clears all counters
+    void resize(int maxEntries);
+    // Record one access to the key with this hash
+    void increment(unsigned long long hash);
+    // Estimated access count of the key, between 0 and SKETCHMAXCOUNT
+    int frequency(unsigned long long hash) const;
+    // Halve every counter so old popularity fades out
+    void age();
+    // Number of additions since the last aging
+    int additions() const { return m_additions; }
+    // Add the counter table to bytes
+    void memoryUsage(HeapBytes& bytes) const;
+
+private:
+    // Counter position of the key in one row
+    int counterIndex(unsigned long long hash, int row) const;
+    int getCounter(int index) const;
+
+    std::vector<unsigned long long> m_table;    // packed 4-bit counters
+    int m_counterMask;                          // number of counters - 1 (a power of two)
+    int m_additions;                            // additions since the last aging
+    int m_sampleSize;                           // additions that trigger aging
+};
+
+#endif // FREQUENCY_SKETCH_H
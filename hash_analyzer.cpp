@@ -0,0 +1,201 @@
+// Hash function quality analyzer
+// Usage: ./hash_analyzer [corpus-file]
+// Reads one key per line (default: generated short keys like the tests use) and reports,
+// for every built-in hash function, avalanche behavior, the bucket distribution in a table
+// at the rehash load factor, the probes a real Cache needs, and hashing speed
+#include "cache.h"
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ANALYZER_TSC 1
+#endif
+
+const int MAXKEYS = 40000;          // a Cache of MAXPRIME slots stays under the rehash load factor
+const int AVALANCHE_KEYS = 2000;
+const int AVALANCHE_BITS = 128;     // input bits followed, longer keys are cut off here
+const int SPEED_ROUNDS = 20;
+
+const hashkind_t KINDS[] = {HASH_LEGACY, HASH_WY, HASH_CRC32C, HASH_SIP};
+
+// generatedCorpus: Short, similar keys, the case the multiply-by-33 hash handles worst
+vector<string> generatedCorpus() {
+    const string names[] = {"alice", "bob", "carol", "dave", "user", "key", "id", "x"};
+    vector<string> keys;
+    for (int i = 0; (int)keys.size() < MAXKEYS; i++) {
+        keys.push_back(names[i % 8] + to_string(i / 8));
+    }
+    return keys;
+}
+
+// loadCorpus: Distinct non-empty lines of the file
+bool loadCorpus(const char* path, vector<string>& keys) {
+    ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    unordered_map<string, bool> seen;
+    string line;
+    while ((int)keys.size() < MAXKEYS && getline(file, line)) {
+        if (line.empty() == false && seen.count(line) == 0) {
+            seen[line] = true;
+            keys.push_back(line);
+        }
+    }
+    return keys.empty() == false;
+}
+
+bool isPrime(int number) {
+    for (int d = 2; d * d <= number; d++) {
+        if (number % d == 0) {
+            return false;
+        }
+    }
+    return number > 1;
+}
+
+// avalanche: Flip every input bit and count how often each output bit follows
+// Ideal is a flip probability of 0.5 everywhere, worst bias is the largest distance from it
+void avalanche(hash_fn hash, const vector<string>& keys, double& mean, double& worst) {
+    vector<long long> flips(AVALANCHE_BITS * 32, 0);
+    vector<long long> trials(AVALANCHE_BITS, 0);
+    int count = (int)keys.size() < AVALANCHE_KEYS ? (int)keys.size() : AVALANCHE_KEYS;
+    long long totalFlips = 0;
+    long long totalTrials = 0;
+    for (int k = 0; k < count; k++) {
+        string key = keys[k];
+        unsigned int base = hash(key);
+        int bits = (int)key.size() * 8 < AVALANCHE_BITS ? (int)key.size() * 8 : AVALANCHE_BITS;
+        for (int bit = 0; bit < bits; bit++) {
+            key[bit / 8] ^= (char)(1 << (bit % 8));
+            unsigned int changed = base ^ hash(key);
+            key[bit / 8] ^= (char)(1 << (bit % 8));
+            trials[bit]++;
+            for (int out = 0; out < 32; out++) {
+                if (changed & (1u << out)) {
+                    flips[bit * 32 + out]++;
+                    totalFlips++;
+                }
+            }
+            totalTrials += 32;
+        }
+    }
+    mean = totalTrials > 0 ? double(totalFlips) / totalTrials : 0;
+    worst = 0;
+    for (int bit = 0; bit < AVALANCHE_BITS; bit++) {
+        // Too few keys reach this bit to tell bias from noise
+        if (trials[bit] < 1000) {
+            continue;
+        }
+        for (int out = 0; out < 32; out++) {
+            double bias = double(flips[bit * 32 + out]) / trials[bit] - 0.5;
+            bias = bias < 0 ? -bias : bias;
+            worst = bias > worst ? bias : worst;
+        }
+    }
+}
+
+// distribution: Chi-square over the home slots of a table filled to the rehash load factor,
+// divided by its degrees of freedom so a uniform hash scores about 1
+void distribution(hash_fn hash, const vector<string>& keys, double& chiRatio, int& maxBucket) {
+    int capacity = (int)keys.size() * 2;
+    while (!isPrime(capacity)) {
+        capacity++;
+    }
+    vector<int> buckets(capacity, 0);
+    for (int i = 0; i < (int)keys.size(); i++) {
+        buckets[hash(keys[i]) % capacity]++;
+    }
+    double expected = double(keys.size()) / capacity;
+    double chi = 0;
+    maxBucket = 0;
+    for (int b = 0; b < capacity; b++) {
+        chi += (buckets[b] - expected) * (buckets[b] - expected) / expected;
+        maxBucket = buckets[b] > maxBucket ? buckets[b] : maxBucket;
+    }
+    chiRatio = chi / (capacity - 1);
+}
+
+// cacheProbes: Average probes per successful lookup in a real Cache with double hashing
+double cacheProbes(hashkind_t kind, const vector<string>& keys) {
+    Cache cache(MAXPRIME, kind, DOUBLEHASH);
+    for (int i = 0; i < (int)keys.size(); i++) {
+        cache.insert(Person(keys[i], MINID + i % (MAXID - MINID), true));
+    }
+    cache.resetStats();
+    for (int i = 0; i < (int)keys.size(); i++) {
+        cache.getPerson(keys[i], MINID + i % (MAXID - MINID));
+    }
+    CacheStats stats = cache.stats();
+    return stats.m_hits > 0 ? double(stats.m_probeSum[STAT_GET]) / stats.m_hits : 0;
+}
+
+// speed: Bytes hashed per cycle (per ns without a time stamp counter)
+double speed(hash_fn hash, const vector<string>& keys) {
+    long long bytes = 0;
+    for (int i = 0; i < (int)keys.size(); i++) {
+        bytes += keys[i].size();
+    }
+    volatile unsigned int sink = 0;
+#ifdef ANALYZER_TSC
+    unsigned long long start = __rdtsc();
+#else
+    auto start = chrono::steady_clock::now();
+#endif
+    for (int round = 0; round < SPEED_ROUNDS; round++) {
+        unsigned int acc = 0;
+        for (int i = 0; i < (int)keys.size(); i++) {
+            acc ^= hash(keys[i]);
+        }
+        sink = sink ^ acc;
+    }
+#ifdef ANALYZER_TSC
+    double elapsed = double(__rdtsc() - start);
+#else
+    double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+#endif
+    return elapsed > 0 ? bytes * double(SPEED_ROUNDS) / elapsed : 0;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> keys;
+    if (argc > 1) {
+        if (!loadCorpus(argv[1], keys)) {
+            cerr << "Cannot read keys from " << argv[1] << endl;
+            return 1;
+        }
+    } else {
+        keys = generatedCorpus();
+    }
+    // A fixed key keeps the SipHash figures comparable between runs
+    setSipHashKey(0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull);
+
+    cout << keys.size() << " keys" << (argc > 1 ? string(" from ") + argv[1] : string(" (generated)"));
+    cout << ", CRC32C " << (crc32cHardware() ? "SSE4.2" : "table") << endl;
+    cout << left << setw(10) << "hash" << right
+         << setw(12) << "avalanche" << setw(12) << "worst bias"
+         << setw(12) << "chi2/df" << setw(12) << "max bucket"
+         << setw(14) << "cache probes"
+#ifdef ANALYZER_TSC
+         << setw(14) << "bytes/cycle" << endl;
+#else
+         << setw(14) << "bytes/ns" << endl;
+#endif
+    cout << fixed;
+    for (hashkind_t kind : KINDS) {
+        hash_fn hash = builtinHash(kind);
+        double mean;
+        double worst;
+        double chiRatio;
+        int maxBucket;
+        avalanche(hash, keys, mean, worst);
+        distribution(hash, keys, chiRatio, maxBucket);
+        cout << left << setw(10) << hashName(kind) << right
+             << setprecision(3) << setw(12) << mean << setw(12) << worst
+             << setprecision(2) << setw(12) << chiRatio << setw(12) << maxBucket
+             << setw(14) << cacheProbes(kind, keys)
+             << setprecision(3) << setw(14) << speed(hash, keys) << endl;
+    }
+    return 0;
+}
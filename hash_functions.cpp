@@ -0,0 +1,274 @@
+// Built-in Hash Functions Implementation
+#include "hash_functions.h"
+#include <cstring>
+#include <random>
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define HASH_X86 1
+#endif
+
+// Little-endian loads, memcpy keeps them legal at any alignment
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+static inline uint64_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// fold: 64-bit hash to a hash_fn value
+static inline unsigned int fold(uint64_t h) {
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+/******************************************
+* wyhash-style hash
+******************************************/
+static const uint64_t WYSECRET[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                     0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+// wyMix: 64x64 -> 128 bit multiply, folded
+static inline uint64_t wyMix(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+// wyHash64: Short keys (the common case here) take one multiply after two overlapping loads
+uint64_t wyHash64(const void* data, size_t length, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    seed ^= wyMix(seed ^ WYSECRET[0], WYSECRET[1]);
+    uint64_t a;
+    uint64_t b;
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (read32(p) << 32) | read32(p + ((length >> 3) << 2));
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        } else {
+            a = 0;
+            b = 0;
+        }
+    } else {
+        size_t i = length;
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = wyMix(read64(p) ^ WYSECRET[1], read64(p + 8) ^ seed);
+                see1 = wyMix(read64(p + 16) ^ WYSECRET[2], read64(p + 24) ^ see1);
+                see2 = wyMix(read64(p + 32) ^ WYSECRET[3], read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wyMix(read64(p) ^ WYSECRET[1], read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+    a ^= WYSECRET[1];
+    b ^= seed;
+    __uint128_t r = (__uint128_t)a * b;
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+    return wyMix(a ^ WYSECRET[0] ^ length, b ^ WYSECRET[1]);
+}
+
+/******************************************
+* CRC32C (Castagnoli)
+******************************************/
+// crcTable: Byte-at-a-time table of the reflected polynomial, built on first use
+static const uint32_t* crcTable() {
+    static uint32_t table[256];
+    static bool built = false;
+    if (built == false) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            }
+            table[n] = c;
+        }
+        built = true;
+    }
+    return table;
+}
+
+static uint32_t crc32cSoftware(const uint8_t* p, size_t length, uint32_t crc) {
+    const uint32_t* table = crcTable();
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef HASH_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSSE42(const uint8_t* p, size_t length, uint32_t crc) {
+#if defined(__x86_64__)
+    uint64_t c = crc;
+    while (length >= 8) {
+        c = _mm_crc32_u64(c, read64(p));
+        p += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)c;
+#endif
+    while (length >= 4) {
+        crc = _mm_crc32_u32(crc, (uint32_t)read32(p));
+        p += 4;
+        length -= 4;
+    }
+    while (length > 0) {
+        crc = _mm_crc32_u8(crc, *p);
+        p++;
+        length--;
+    }
+    return crc;
+}
+#endif
+
+// crc32cHardware: Checked once, the answer does not change while the process runs
+bool crc32cHardware() {
+#ifdef HASH_X86
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+// crc32c: Standard CRC32C, crc continues an earlier call (0 to start)
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+#ifdef HASH_X86
+    if (crc32cHardware()) {
+        return ~crc32cSSE42(p, length, crc);
+    }
+#endif
+    return ~crc32cSoftware(p, length, crc);
+}
+
+/******************************************
+* SipHash-2-4
+******************************************/
+static inline uint64_t rotl(uint64_t x, int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+#define SIPROUND                                                     \
+    do {                                                             \
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);     \
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;                       \
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;                       \
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);     \
+    } while (0)
+
+// sipHash24: Two compression rounds per 8-byte word, four finalization rounds
+uint64_t sipHash24(const void* data, size_t length, uint64_t k0, uint64_t k1) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t v0 = 0x736f6d6570736575ull ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dull ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ull ^ k0;
+    uint64_t v3 = 0x7465646279746573ull ^ k1;
+    size_t words = length / 8;
+    for (size_t i = 0; i < words; i++) {
+        uint64_t m = read64(p + i * 8);
+        v3 ^= m;
+        SIPROUND;
+        SIPROUND;
+        v0 ^= m;
+    }
+    // Last block: the remaining bytes and the length in the top byte
+    uint64_t last = (uint64_t)length << 56;
+    const uint8_t* tail = p + words * 8;
+    for (size_t i = 0; i < length % 8; i++) {
+        last |= (uint64_t)tail[i] << (8 * i);
+    }
+    v3 ^= last;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= last;
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// sipKey: Process-wide key, random until setSipHashKey is called
+static uint64_t* sipKey() {
+    static uint64_t key[2] = {0, 0};
+    static bool seeded = false;
+    if (seeded == false) {
+        std::random_device device;
+        key[0] = ((uint64_t)device() << 32) | device();
+        key[1] = ((uint64_t)device() << 32) | device();
+        seeded = true;
+    }
+    return key;
+}
+
+void setSipHashKey(uint64_t k0, uint64_t k1) {
+    uint64_t* key = sipKey();
+    key[0] = k0;
+    key[1] = k1;
+}
+
+/******************************************
+* hash_fn adapters
+******************************************/
+unsigned int legacyHashCode(std::string key) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(key.length()); i++)
+        val = val * thirtyThree + key[i];
+    return val;
+}
+
+unsigned int wyHashCode(std::string key) {
+    return fold(wyHash64(key.data(), key.size()));
+}
+
+unsigned int crc32cHashCode(std::string key) {
+    return crc32c(key.data(), key.size());
+}
+
+unsigned int sipHashCode(std::string key) {
+    const uint64_t* k = sipKey();
+    return fold(sipHash24(key.data(), key.size(), k[0], k[1]));
+}
+
+// builtinHash: Map the kind to its adapter
+hash_fn builtinHash(hashkind_t kind) {
+    if (kind == HASH_WY) {
+        return wyHashCode;
+    } else if (kind == HASH_CRC32C) {
+        return crc32cHashCode;
+    } else if (kind == HASH_SIP) {
+        return sipHashCode;
+    }
+    return legacyHashCode;
+}
+
+const char* hashName(hashkind_t kind) {
+    if (kind == HASH_WY) {
+        return "wyhash";
+    } else if (kind == HASH_CRC32C) {
+        return "crc32c";
+    } else if (kind == HASH_SIP) {
+        return "siphash";
+    }
+    return "legacy";
+}
@@ -0,0 +1,38 @@
+// Built-in Hash Functions
+// Ready-made replacements for the multiply-by-33 hashCode every program used to bring along:
+// a wyhash-style 64-bit hash, CRC32C (SSE4.2 when the CPU has it) and keyed SipHash-2-4 for
+// keys an attacker may choose. Each one is also available as a hash_fn for Cache
+#ifndef HASH_FUNCTIONS_H
+#define HASH_FUNCTIONS_H
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef unsigned int (*hash_fn)(std::string);   // same as cache.h
+
+enum hashkind_t {HASH_LEGACY, HASH_WY, HASH_CRC32C, HASH_SIP};  // built-in hash functions
+
+// Raw functions over bytes
+uint64_t wyHash64(const void* data, size_t length, uint64_t seed = 0);
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+uint64_t sipHash24(const void* data, size_t length, uint64_t k0, uint64_t k1);
+// True if crc32c runs on the SSE4.2 instruction instead of the table
+bool crc32cHardware();
+
+// SipHash key used by sipHashCode, random per process until set
+// Persistent tables (snapshots, mapped files) need the same key in every process
+void setSipHashKey(uint64_t k0, uint64_t k1);
+
+// hash_fn adapters, 64-bit results are folded to 32 bits
+unsigned int legacyHashCode(std::string key);   // the old multiply-by-33 hash
+unsigned int wyHashCode(std::string key);
+unsigned int crc32cHashCode(std::string key);
+unsigned int sipHashCode(std::string key);
+
+// The hash_fn of a built-in hash function
+hash_fn builtinHash(hashkind_t kind);
+// Its name, e.g. for reports
+const char* hashName(hashkind_t kind);
+
+#endif // HASH_FUNCTIONS_H
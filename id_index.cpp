@@ -0,0 +1,126 @@
+// Ordered ID Index Implementation
+#include "id_index.h"
+#include "cache_stats.h"
+#include <algorithm>
+
+// Compare an entry with an ID, for the binary searches inside a leaf
+static bool entryBefore(const IdIndexEntry& entry, int id) {
+    return entry.m_id < id;
+}
+static bool idBefore(int id, const IdIndexEntry& entry) {
+    return id < entry.m_id;
+}
+
+// Constructor
+IdIndex::IdIndex() {
+    m_size = 0;
+}
+
+// clear: Drop every entry
+void IdIndex::clear() {
+    m_leaves.clear();
+    m_fences.clear();
+    m_size = 0;
+}
+
+// firstLeaf: Entries with the same ID can spread over several leaves, the first one
+// is the last leaf whose fence is below id
+int IdIndex::firstLeaf(int id) const {
+    int leaf = (int)(std::lower_bound(m_fences.begin(), m_fences.end(), id) - m_fences.begin());
+    if (leaf > 0) {
+        leaf--;
+    }
+    return leaf;
+}
+
+// insert: Put the entry after all entries with a smaller or equal ID
+void IdIndex::insert(int id, Person* person) {
+    if (m_leaves.empty()) {
+        m_leaves.push_back(std::vector<IdIndexEntry>());
+        m_fences.push_back(id);
+    }
+    // Last leaf whose fence is not above id
+    int leaf = (int)(std::upper_bound(m_fences.begin(), m_fences.end(), id) - m_fences.begin());
+    if (leaf > 0) {
+        leaf--;
+    }
+    std::vector<IdIndexEntry>& entries = m_leaves[leaf];
+    entries.insert(std::upper_bound(entries.begin(), entries.end(), id, idBefore), IdIndexEntry(id, person));
+    m_fences[leaf] = entries.front().m_id;
+    m_size++;
+    if ((int)entries.size() > IDLEAFSIZE) {
+        splitLeaf(leaf);
+    }
+}
+
+// remove: Find the object among the entries with this ID and take it out
+bool IdIndex::remove(int id, Person* person) {
+    for (int leaf = firstLeaf(id); leaf < (int)m_leaves.size() && m_fences[leaf] <= id; leaf++) {
+        std::vector<IdIndexEntry>& entries = m_leaves[leaf];
+        std::vector<IdIndexEntry>::iterator it = std::lower_bound(entries.begin(), entries.end(), id, entryBefore);
+        for (; it != entries.end() && it->m_id == id; it++) {
+            if (it->m_person == person) {
+                entries.erase(it);
+                m_size--;
+                mergeLeaf(leaf);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// range: Binary search for the first leaf, then walk the leaves in order
+void IdIndex::range(int lo, int hi, std::vector<Person*>& out) const {
+    for (int leaf = firstLeaf(lo); leaf < (int)m_leaves.size() && m_fences[leaf] <= hi; leaf++) {
+        const std::vector<IdIndexEntry>& entries = m_leaves[leaf];
+        std::vector<IdIndexEntry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), lo, entryBefore);
+        for (; it != entries.end() && it->m_id <= hi; it++) {
+            out.push_back(it->m_person);
+        }
+    }
+}
+
+// splitLeaf: Move the upper half of a full leaf into a new leaf right after it
+void IdIndex::splitLeaf(int leaf) {
+    std::vector<IdIndexEntry>& entries = m_leaves[leaf];
+    int half = (int)entries.size() / 2;
+    std::vector<IdIndexEntry> upper(entries.begin() + half, entries.end());
+    entries.resize(half);
+    m_fences.insert(m_fences.begin() + leaf + 1, upper.front().m_id);
+    m_leaves.insert(m_leaves.begin() + leaf + 1, std::vector<IdIndexEntry>());
+    m_leaves[leaf + 1].swap(upper);
+}
+
+// mergeLeaf: Drop an empty leaf, or fold a small one into its right neighbour if both fit in one
+void IdIndex::mergeLeaf(int leaf) {
+    std::vector<IdIndexEntry>& entries = m_leaves[leaf];
+    if (entries.empty()) {
+        m_leaves.erase(m_leaves.begin() + leaf);
+        m_fences.erase(m_fences.begin() + leaf);
+        return;
+    }
+    m_fences[leaf] = entries.front().m_id;
+    int right = leaf + 1;
+    if ((int)entries.size() < IDLEAFMERGE && right < (int)m_leaves.size() &&
+        (int)(entries.size() + m_leaves[right].size()) <= IDLEAFSIZE) {
+        entries.insert(entries.end(), m_leaves[right].begin(), m_leaves[right].end());
+        m_leaves.erase(m_leaves.begin() + right);
+        m_fences.erase(m_fences.begin() + right);
+    }
+}
+
+// memoryUsage: The leaf array, the fences, then one block per leaf
+void IdIndex::memoryUsage(HeapBytes& bytes) const {
+    if (m_leaves.capacity() > 0) {
+        bytes.addBlock(m_leaves.data(), m_leaves.capacity() * sizeof(std::vector<IdIndexEntry>));
+    }
+    if (m_fences.capacity() > 0) {
+        bytes.addBlock(m_fences.data(), m_fences.capacity() * sizeof(int));
+    }
+    for (size_t i = 0; i < m_leaves.size(); i++) {
+        if (m_leaves[i].capacity() > 0) {
+            bytes.addBlock(m_leaves[i].data(), m_leaves[i].capacity() * sizeof(IdIndexEntry));
+        }
+    }
+}
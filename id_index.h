@@ -0,0 +1,46 @@
+// Ordered ID Index for range scans
+// A two-level B+tree: sorted leaf blocks of (ID, entry) pairs under a sorted array of
+// fence keys, so a lookup is one binary search over the fences and one inside a leaf
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <vector>
+
+struct HeapBytes;   // cache_stats.h
+class Person;   // entries are owned by the Cache tables, the index only points to them
+
+const int IDLEAFSIZE = 64;          // max entries per leaf, a full leaf splits in two
+const int IDLEAFMERGE = 16;         // a leaf this small merges with its right neighbour
+
+struct IdIndexEntry {
+    int     m_id;
+    Person* m_person;
+    IdIndexEntry(int id = 0, Person* person = nullptr) : m_id(id), m_person(person) {}
+};
+
+class IdIndex {
+public:
+    IdIndex();
+    void clear();
+    // Add an entry, entries with the same ID keep their insertion order
+    void insert(int id, Person* person);
+    // Remove the entry of this object, returns false if it is not indexed under id
+    bool remove(int id, Person* person);
+    // Append every entry with lo <= ID <= hi in ID order
+    void range(int lo, int hi, std::vector<Person*>& out) const;
+    int size() const { return m_size; }
+    // Add the fence array and every leaf to bytes
+    void memoryUsage(HeapBytes& bytes) const;
+
+private:
+    // First leaf that can hold entries with this ID
+    int firstLeaf(int id) const;
+    void splitLeaf(int leaf);
+    void mergeLeaf(int leaf);
+
+    std::vector<std::vector<IdIndexEntry> > m_leaves;
+    std::vector<int> m_fences;      // smallest ID of every leaf
+    int m_size;                     // entries in all leaves
+};
+
+#endif // ID_INDEX_H
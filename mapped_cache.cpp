@@ -0,0 +1,647 @@
+// Memory-Mapped Cache Implementation
+#include "mapped_cache.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Both slot regions can hold a table of MAXPRIME slots, and every slot of both regions
+// can refer to its own record, so the file never has to grow
+static size_t headerBytes() {
+    return (sizeof(MappedHeader) + 63) & ~(size_t)63;
+}
+static size_t arenaOffset() {
+    return (headerBytes() + (size_t)MAPREGIONS * MAXPRIME * sizeof(uint32_t) + 63) & ~(size_t)63;
+}
+static size_t fileBytes() {
+    return arenaOffset() + (size_t)MAPREGIONS * MAXPRIME * sizeof(MappedEntry);
+}
+
+// Constructor
+MappedCache::MappedCache(const string& path, int size, hash_fn hash, prob_t probing, backing_t backing) {
+    m_base = nullptr;
+    m_length = fileBytes();
+    m_reopened = false;
+    m_readOnly = (backing == BACK_SHM_READER);
+    m_hash = hash;
+    if (backing == BACK_FILE) {
+        m_fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    } else if (backing == BACK_SHM_WRITER) {
+        m_fd = shm_open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    } else {
+        m_fd = shm_open(path.c_str(), O_RDONLY, 0);
+    }
+    if (m_fd < 0) {
+        return;
+    }
+    // One writer per table: a second one would change it under the first, and the readers'
+    // seqlock cannot tell two writers apart. The kernel drops the lock if the owner dies
+    if (m_readOnly == false && flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    struct stat info;
+    if (fstat(m_fd, &info) != 0) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    bool sized = ((size_t)info.st_size == m_length);
+    if (m_readOnly == true) {
+        if (sized == true) {
+            attachReader();
+        }
+        return;
+    }
+    // A file of another layout is cleared, ftruncate fills it with zeros
+    if (sized == false && (ftruncate(m_fd, 0) != 0 || ftruncate(m_fd, m_length) != 0)) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    void* mapping = mmap(nullptr, m_length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_base = (char*)mapping;
+    MappedHeader* h = header();
+    if (sized == true && h->m_magic == MAPMAGIC && h->m_version == MAPVERSION &&
+        h->m_hashCheck == m_hash(SNAPHASHPROBE)) {
+        m_reopened = true;
+        // The previous owner stopped in the middle of an operation, only the records are trusted
+        if (h->m_seq % 2 == 1) {
+            rebuild();
+        }
+        return;
+    }
+    if (size < MINPRIME) {
+        size = MINPRIME;
+    } else if (size > MAXPRIME) {
+        size = MAXPRIME;
+    }
+    format(size, probing);
+}
+
+// attachReader: Map a shared table read-only, it must have been formatted with this layout
+// and hash function, since a reader cannot format it
+void MappedCache::attachReader() {
+    void* mapping = mmap(nullptr, m_length, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        return;
+    }
+    const MappedHeader* h = (const MappedHeader*)mapping;
+    bool valid = h->m_magic == MAPMAGIC && h->m_version == MAPVERSION &&
+                 h->m_hashCheck == m_hash(SNAPHASHPROBE) && h->m_arenaOffset == arenaOffset() &&
+                 h->m_arenaCap == MAPREGIONS * MAXPRIME;
+    for (int r = 0; r < MAPREGIONS && valid; r++) {
+        valid = (h->m_regions[r].m_offset == headerBytes() + (size_t)r * MAXPRIME * sizeof(uint32_t));
+    }
+    if (valid == false) {
+        munmap(mapping, m_length);
+        return;
+    }
+    m_base = (char*)mapping;
+    m_reopened = true;
+}
+
+// unlinkShared: Remove the name of a shared-memory object
+bool MappedCache::unlinkShared(const string& name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+// Destructor
+MappedCache::~MappedCache() {
+    if (m_base != nullptr) {
+        if (m_readOnly == false) {
+            msync(m_base, m_length, MS_SYNC);
+        }
+        munmap(m_base, m_length);
+        m_base = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+// format: Lay out the header, both regions and the arena, and start an empty current table
+void MappedCache::format(int size, prob_t probing) {
+    memset(m_base, 0, headerBytes());
+    MappedHeader* h = header();
+    h->m_hashCheck = m_hash(SNAPHASHPROBE);
+    h->m_current = 0;
+    h->m_migrating = 0;
+    h->m_transferIndex = 0;
+    h->m_newPolicy = probing;
+    for (int r = 0; r < MAPREGIONS; r++) {
+        h->m_regions[r].m_offset = (uint32_t)(headerBytes() + (size_t)r * MAXPRIME * sizeof(uint32_t));
+        h->m_regions[r].m_probing = probing;
+    }
+    h->m_regions[0].m_capacity = isPrime(size) ? size : findNextPrime(size);
+    memset(slots(0), 0, (size_t)h->m_regions[0].m_capacity * sizeof(uint32_t));
+    h->m_arenaOffset = (uint32_t)arenaOffset();
+    h->m_arenaCap = MAPREGIONS * MAXPRIME;
+    h->m_arenaUsed = 0;
+    h->m_freeHead = 0;
+    h->m_seq = 0;
+    // The magic goes in last, a file formatted halfway is never taken for a table
+    h->m_version = MAPVERSION;
+    h->m_magic = MAPMAGIC;
+}
+
+// rebuild: Recreate the table from the records in the arena
+// A crash can leave a moved entry in neither region (between clearing its old slot and
+// reinsertFromOld), or the free list cut or looping (inside allocEntry/freeEntry). The live
+// flag of each record is the one thing every operation leaves right, so the slot regions,
+// the migration and the free list are all thrown away and built again from the records.
+// Keys are hashed again, a record filled halfway may carry a stale stored hash
+void MappedCache::rebuild() {
+    MappedHeader* h = header();
+    int used = h->m_arenaUsed;
+    if (used < 0 || used > h->m_arenaCap) {
+        used = h->m_arenaCap;
+        h->m_arenaUsed = used;
+    }
+    int live = 0;
+    for (uint32_t ref = 1; ref <= (uint32_t)used; ref++) {
+        MappedEntry* e = entry(ref);
+        if (e->m_used != 0 && (e->m_keyLength > MAPKEYMAX || e->m_id < MINID || e->m_id > MAXID)) {
+            e->m_used = 0;
+        }
+        if (e->m_used != 0) {
+            live++;
+        }
+    }
+    // One table with room for the live records, no migration
+    prob_t policy = (prob_t)h->m_newPolicy;
+    if (policy != LINEAR && policy != QUADRATIC && policy != DOUBLEHASH) {
+        policy = DEFPOLCY;
+        h->m_newPolicy = policy;
+    }
+    h->m_current = 0;
+    h->m_migrating = 0;
+    h->m_transferIndex = 0;
+    for (int r = 0; r < MAPREGIONS; r++) {
+        MappedRegion& region = h->m_regions[r];
+        region.m_capacity = 0;
+        region.m_size = 0;
+        region.m_numDeleted = 0;
+        region.m_probing = policy;
+    }
+    MappedRegion& region = h->m_regions[0];
+    region.m_capacity = findNextPrime(live * 4);
+    uint32_t* table = slots(0);
+    memset(table, 0, (size_t)region.m_capacity * sizeof(uint32_t));
+    // Free list in ascending order, so allocation fills the arena from the front again
+    h->m_freeHead = 0;
+    for (uint32_t ref = (uint32_t)used; ref >= 1; ref--) {
+        MappedEntry* e = entry(ref);
+        if (e->m_used == 0) {
+            e->m_nextFree = h->m_freeHead;
+            h->m_freeHead = ref;
+            continue;
+        }
+        e->m_hash = m_hash(string(e->m_key, e->m_keyLength));
+        int index = locateInsertionSlot(e->m_hash, 0);
+        if (index < 0) {
+            freeEntry(ref);
+            continue;
+        }
+        table[index] = ref;
+        region.m_size++;
+    }
+    // Even again, readers waiting on the dead owner's odd number go on
+    __atomic_store_n(&h->m_seq, h->m_seq + 1, __ATOMIC_RELEASE);
+}
+
+// beginWrite/endWrite: The sequence number is odd while the table is being changed
+// The fences order the table writes after the odd and before the even number for readers
+void MappedCache::beginWrite() {
+    uint64_t* seq = &header()->m_seq;
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+void MappedCache::endWrite() {
+    uint64_t* seq = &header()->m_seq;
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+// readBegin: Sequence number of a moment the writer was between operations
+uint64_t MappedCache::readBegin() const {
+    int spins = 0;
+    while (true) {
+        uint64_t seq = __atomic_load_n(&header()->m_seq, __ATOMIC_ACQUIRE);
+        if (seq % 2 == 0) {
+            return seq;
+        }
+        if (++spins >= MAPREADSPINS) {
+            spins = 0;
+            sched_yield();
+        }
+    }
+}
+
+// readRetry: True if the writer changed the table since readBegin returned seq
+bool MappedCache::readRetry(uint64_t seq) const {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&header()->m_seq, __ATOMIC_RELAXED) != seq;
+}
+
+// allocEntry: Take a record from the free list or the end of the arena, 0 if the arena is full
+uint32_t MappedCache::allocEntry() {
+    MappedHeader* h = header();
+    if (h->m_freeHead != 0) {
+        uint32_t ref = h->m_freeHead;
+        h->m_freeHead = entry(ref)->m_nextFree;
+        return ref;
+    }
+    if (h->m_arenaUsed >= h->m_arenaCap) {
+        return 0;
+    }
+    h->m_arenaUsed++;
+    return (uint32_t)h->m_arenaUsed;
+}
+
+// freeEntry: Put a record back on the free list
+void MappedCache::freeEntry(uint32_t ref) {
+    MappedEntry* e = entry(ref);
+    e->m_used = 0;
+    e->m_nextFree = header()->m_freeHead;
+    header()->m_freeHead = ref;
+}
+
+// probeIndex: Get the right index
+int MappedCache::probeIndex(int hashedKey, int i, int capacity, prob_t policy) const {
+    unsigned long long key = (unsigned int)hashedKey;
+    unsigned long long step = i;
+    unsigned long long value = 0;
+    if (policy == LINEAR) {
+        value = (key + step) % capacity;
+    } else if (policy == QUADRATIC) {
+        value = (key + step * step) % capacity;
+    } else if (policy == DOUBLEHASH) {
+        unsigned long long dbValue = 11 - (key % 11);
+        if (dbValue == 0) {
+            dbValue = 1;
+        }
+        value = (key + step * dbValue) % capacity;
+    }
+    return (int)value;
+}
+
+// keyEquals: Compare a stored key with a string
+bool MappedCache::keyEquals(const MappedEntry* e, const string& key) const {
+    return e->m_keyLength == key.size() && memcmp(e->m_key, key.data(), key.size()) == 0;
+}
+
+// locateInsertionSlot: First empty or deleted slot of the probe sequence
+int MappedCache::locateInsertionSlot(unsigned int hashedKey, int region) const {
+    const MappedRegion& r = header()->m_regions[region];
+    uint32_t* table = slots(region);
+    for (int i = 0; i < r.m_capacity; i++) {
+        int index = probeIndex((int)hashedKey, i, r.m_capacity, (prob_t)r.m_probing);
+        if (table[index] == 0 || entry(table[index])->m_used == 0) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+// findPersonIndex: Get the exact index where the entry lives, -1 if it is not in the region
+int MappedCache::findPersonIndex(const string& key, int id, int region) const {
+    const MappedRegion& r = header()->m_regions[region];
+    uint32_t* table = slots(region);
+    int hashedKey = m_hash(key);
+    for (int i = 0; i < r.m_capacity; i++) {
+        int index = probeIndex(hashedKey, i, r.m_capacity, (prob_t)r.m_probing);
+        if (table[index] == 0) {
+            return -1;
+        }
+        const MappedEntry* e = entry(table[index]);
+        if (e->m_used != 0 && e->m_id == id && keyEquals(e, key)) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+// findUnderWriter: Bounds-checked findPersonIndex for readers
+bool MappedCache::findUnderWriter(const string& key, int id, int region) const {
+    const MappedHeader* h = header();
+    int capacity = h->m_regions[region].m_capacity;
+    prob_t policy = (prob_t)h->m_regions[region].m_probing;
+    if (capacity <= 0 || capacity > MAXPRIME) {
+        return false;
+    }
+    const uint32_t* table = slots(region);
+    int hashedKey = m_hash(key);
+    for (int i = 0; i < capacity; i++) {
+        int index = probeIndex(hashedKey, i, capacity, policy);
+        uint32_t ref = table[index];
+        if (ref == 0) {
+            return false;
+        }
+        if (ref > (uint32_t)(MAPREGIONS * MAXPRIME)) {
+            continue;
+        }
+        const MappedEntry* e = entry(ref);
+        if (e->m_used != 0 && e->m_id == id && keyEquals(e, key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// startNewRehash: The current region becomes the old table, the other region the new one
+void MappedCache::startNewRehash() {
+    MappedHeader* h = header();
+    MappedRegion& old = h->m_regions[currentRegion()];
+    int next = oldRegion();
+    MappedRegion& fresh = h->m_regions[next];
+    int liveCount = old.m_size - old.m_numDeleted;
+    fresh.m_capacity = findNextPrime(liveCount * 4);
+    fresh.m_size = 0;
+    fresh.m_numDeleted = 0;
+    fresh.m_probing = h->m_newPolicy;
+    memset(slots(next), 0, (size_t)fresh.m_capacity * sizeof(uint32_t));
+    h->m_transferIndex = 0;
+    h->m_current = next;
+    h->m_migrating = 1;
+}
+
+// reinsertFromOld: Place a live record into the current region using its stored hash
+void MappedCache::reinsertFromOld(uint32_t ref) {
+    int region = currentRegion();
+    int index = locateInsertionSlot(entry(ref)->m_hash, region);
+    if (index < 0) {
+        freeEntry(ref);
+        return;
+    }
+    MappedRegion& r = header()->m_regions[region];
+    uint32_t* table = slots(region);
+    if (table[index] != 0) {
+        // Reuse the deleted slot, it is already counted in m_size
+        freeEntry(table[index]);
+        r.m_numDeleted--;
+    } else {
+        r.m_size++;
+    }
+    table[index] = ref;
+}
+
+// transferPartOfTable: Moves 25% of the old region into the current one
+void MappedCache::transferPartOfTable() {
+    MappedHeader* h = header();
+    if (h->m_migrating == 0) {
+        return;
+    }
+    int region = oldRegion();
+    MappedRegion& old = h->m_regions[region];
+    uint32_t* table = slots(region);
+    int partToTransfer = old.m_capacity / 4;
+    int end = h->m_transferIndex + partToTransfer;
+    for (int i = h->m_transferIndex; i < end && i < old.m_capacity; i++) {
+        uint32_t ref = table[i];
+        if (ref == 0) {
+            continue;
+        }
+        table[i] = 0;
+        old.m_size--;
+        if (entry(ref)->m_used != 0) {
+            reinsertFromOld(ref);
+        } else {
+            freeEntry(ref);
+            old.m_numDeleted--;
+        }
+    }
+    h->m_transferIndex = end;
+    if (h->m_transferIndex >= old.m_capacity) {
+        // Anything left behind the last step is a deleted record
+        for (int i = 0; i < old.m_capacity; i++) {
+            if (table[i] != 0) {
+                freeEntry(table[i]);
+                table[i] = 0;
+            }
+        }
+        old.m_capacity = 0;
+        old.m_size = 0;
+        old.m_numDeleted = 0;
+        h->m_migrating = 0;
+    }
+}
+
+// insert: Inserts an entry into the current region
+bool MappedCache::insert(Person person) {
+    string key = person.getKey();
+    int id = person.getID();
+    if (m_base == nullptr || m_readOnly == true || id < MINID || id > MAXID || key.size() > (size_t)MAPKEYMAX) {
+        return false;
+    }
+    MappedHeader* h = header();
+    beginWrite();
+    transferPartOfTable();
+    bool exists = findPersonIndex(key, id, currentRegion()) >= 0 ||
+                  (h->m_migrating != 0 && findPersonIndex(key, id, oldRegion()) >= 0);
+    unsigned int hashedKey = m_hash(key);
+    int region = currentRegion();
+    int index = exists ? -1 : locateInsertionSlot(hashedKey, region);
+    uint32_t ref = (index >= 0) ? allocEntry() : 0;
+    if (ref == 0) {
+        endWrite();
+        return false;
+    }
+    // Fill the record before the slot points to it
+    MappedEntry* e = entry(ref);
+    e->m_hash = hashedKey;
+    e->m_id = id;
+    e->m_nextFree = 0;
+    e->m_keyLength = (uint8_t)key.size();
+    memcpy(e->m_key, key.data(), key.size());
+    e->m_used = 1;
+    MappedRegion& r = h->m_regions[region];
+    uint32_t* table = slots(region);
+    if (table[index] != 0) {
+        // The deleted record in this slot is no longer referenced
+        freeEntry(table[index]);
+        r.m_numDeleted--;
+    } else {
+        r.m_size++;
+    }
+    table[index] = ref;
+    if (h->m_migrating == 0 && (lambda() > 0.5 || deletedRatio() > 0.8)) {
+        startNewRehash();
+    }
+    endWrite();
+    return true;
+}
+
+// remove: Lazily deletes an entry from whichever region holds it
+bool MappedCache::remove(Person person) {
+    if (m_base == nullptr || m_readOnly == true) {
+        return false;
+    }
+    MappedHeader* h = header();
+    beginWrite();
+    transferPartOfTable();
+    bool removed = false;
+    int index = findPersonIndex(person.getKey(), person.getID(), currentRegion());
+    if (index >= 0) {
+        entry(slots(currentRegion())[index])->m_used = 0;
+        h->m_regions[currentRegion()].m_numDeleted++;
+        removed = true;
+        if (h->m_migrating == 0 && (lambda() > 0.5 || deletedRatio() > 0.8)) {
+            startNewRehash();
+        }
+    } else if (h->m_migrating != 0) {
+        index = findPersonIndex(person.getKey(), person.getID(), oldRegion());
+        if (index >= 0) {
+            entry(slots(oldRegion())[index])->m_used = 0;
+            h->m_regions[oldRegion()].m_numDeleted++;
+            removed = true;
+        }
+    }
+    endWrite();
+    return removed;
+}
+
+// getPerson: Looks for the entry in the current region, then the old one
+const Person MappedCache::getPerson(string key, int ID) const {
+    if (m_base == nullptr) {
+        return Person("", 0, false);
+    }
+    if (m_readOnly == true) {
+        // No such key can be stored, and keyEquals must never read past a record
+        if (key.size() > (size_t)MAPKEYMAX) {
+            return Person("", 0, false);
+        }
+        bool found;
+        uint64_t seq;
+        do {
+            seq = readBegin();
+            int current = currentRegion() & 1;
+            found = findUnderWriter(key, ID, current) ||
+                    (header()->m_migrating != 0 && findUnderWriter(key, ID, 1 - current));
+        } while (readRetry(seq));
+        return found ? Person(key, ID, true) : Person("", 0, false);
+    }
+    int index = findPersonIndex(key, ID, currentRegion());
+    if (index >= 0) {
+        return Person(key, ID, true);
+    }
+    if (header()->m_migrating != 0 && findPersonIndex(key, ID, oldRegion()) >= 0) {
+        return Person(key, ID, true);
+    }
+    return Person("", 0, false);
+}
+
+// updateID: Changes the ID of an entry in place
+bool MappedCache::updateID(Person person, int ID) {
+    if (m_base == nullptr || m_readOnly == true || ID < MINID || ID > MAXID) {
+        return false;
+    }
+    int region = currentRegion();
+    int index = findPersonIndex(person.getKey(), person.getID(), region);
+    if (index < 0 && header()->m_migrating != 0) {
+        region = oldRegion();
+        index = findPersonIndex(person.getKey(), person.getID(), region);
+    }
+    if (index < 0) {
+        return false;
+    }
+    beginWrite();
+    entry(slots(region)[index])->m_id = ID;
+    endWrite();
+    return true;
+}
+
+// changeProbPolicy: The next rehash uses the new policy
+void MappedCache::changeProbPolicy(prob_t policy) {
+    if (m_base != nullptr && m_readOnly == false) {
+        header()->m_newPolicy = policy;
+    }
+}
+
+// lambda: Returns the load factor of the current region
+float MappedCache::lambda() const {
+    const MappedRegion& r = header()->m_regions[currentRegion()];
+    return float(r.m_size) / r.m_capacity;
+}
+
+// deletedRatio: Returns the ratio of deleted slots in the current region
+float MappedCache::deletedRatio() const {
+    const MappedRegion& r = header()->m_regions[currentRegion()];
+    if (r.m_size == 0) {
+        return 0.0;
+    }
+    return float(r.m_numDeleted) / r.m_size;
+}
+
+// liveCount: Returns the number of live entries in both regions
+int MappedCache::liveCount() const {
+    if (m_base == nullptr) {
+        return 0;
+    }
+    if (m_readOnly == true) {
+        int live;
+        uint64_t seq;
+        do {
+            seq = readBegin();
+            int current = currentRegion() & 1;
+            const MappedRegion& r = header()->m_regions[current];
+            live = r.m_size - r.m_numDeleted;
+            if (header()->m_migrating != 0) {
+                live += header()->m_regions[1 - current].m_size - header()->m_regions[1 - current].m_numDeleted;
+            }
+        } while (readRetry(seq));
+        return live;
+    }
+    const MappedRegion& r = header()->m_regions[currentRegion()];
+    int live = r.m_size - r.m_numDeleted;
+    if (header()->m_migrating != 0) {
+        const MappedRegion& old = header()->m_regions[oldRegion()];
+        live += old.m_size - old.m_numDeleted;
+    }
+    return live;
+}
+
+// sync: Flush the mapping to the file
+bool MappedCache::sync() {
+    if (m_base == nullptr || m_readOnly == true) {
+        return false;
+    }
+    return msync(m_base, m_length, MS_SYNC) == 0;
+}
+
+bool MappedCache::isPrime(int number) const {
+    bool result = true;
+    for (int i = 2; i <= number / 2; ++i) {
+        if (number % i == 0) {
+            result = false;
+            break;
+        }
+    }
+    return result;
+}
+
+int MappedCache::findNextPrime(int current) const {
+    //we always stay within the range [MINPRIME-MAXPRIME]
+    //the smallest prime starts at MINPRIME
+    if (current < MINPRIME) current = MINPRIME - 1;
+    for (int i = current; i < MAXPRIME; i++) {
+        for (int j = 2; j * j <= i; j++) {
+            if (i % j == 0)
+                break;
+            else if (j + 1 > sqrt(i) && i != current) {
+                return i;
+            }
+        }
+    }
+    //if a user tries to go over MAXPRIME
+    return MAXPRIME;
+}
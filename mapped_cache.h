@@ -0,0 +1,141 @@
+// Memory-Mapped Cache
+// The table arrays and the entries live in an mmap'd file and refer to each other by
+// relative offsets instead of pointers, so a restarted process (or a new binary) maps
+// the file and serves right away, with no load step
+// A class of its own rather than a Cache mode: Cache's entries are heap Persons with
+// std::string keys reached through pointers, none of which can live in a mapping, so every
+// table path differs. Like NaiveCache it keeps its own copy of the probing and prime helpers
+#ifndef MAPPED_CACHE_H
+#define MAPPED_CACHE_H
+
+#include "cache.h"
+#include <stdint.h>
+
+const unsigned int MAPMAGIC = 0x4D435448;   // "HTCM" at the start of a mapped file
+const unsigned int MAPVERSION = 1;
+const int MAPKEYMAX = 50;                   // longest key a mapped entry can hold
+const int MAPREGIONS = 2;                   // slot regions, the current and the old table take turns
+const int MAPREADSPINS = 64;                // seqlock retries before a reader yields
+
+// Where the table lives: a file, or a POSIX shared-memory object written by one process
+// and read by any number of others
+enum backing_t {BACK_FILE, BACK_SHM_WRITER, BACK_SHM_READER};
+
+// One table generation, the slot array holds entry references (record index + 1, 0 is empty)
+struct MappedRegion {
+    uint32_t m_offset;      // bytes from the start of the file to the slot array
+    int32_t  m_capacity;
+    int32_t  m_size;        // includes deleted entries, like Cache::m_currentSize
+    int32_t  m_numDeleted;
+    int32_t  m_probing;
+};
+
+// File header, everything else is located through it
+struct MappedHeader {
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint32_t m_hashCheck;   // hash of SNAPHASHPROBE, a different hash function cannot reuse the file
+    int32_t  m_current;     // region holding the current table
+    int32_t  m_migrating;   // 1 while the other region holds the old table
+    int32_t  m_transferIndex;
+    int32_t  m_newPolicy;
+    MappedRegion m_regions[MAPREGIONS];
+    uint32_t m_arenaOffset; // bytes from the start of the file to the entry records
+    int32_t  m_arenaCap;    // records in the arena
+    int32_t  m_arenaUsed;   // records handed out so far by the bump allocator
+    uint32_t m_freeHead;    // reference of the first free record, 0 if none
+    uint64_t m_seq;         // modification counter, odd while an operation is in progress
+};
+
+// Fixed size entry record
+struct MappedEntry {
+    uint32_t m_hash;        // stored so the rehash transfer never hashes a key again
+    int32_t  m_id;
+    uint32_t m_nextFree;    // free list link while the record is unused
+    uint8_t  m_used;        // lazy delete flag, same meaning as Person::m_used
+    uint8_t  m_keyLength;
+    char     m_key[MAPKEYMAX];
+};
+
+class MappedCache {
+public:
+    // Map the file at path, reusing its table if it was written with the same layout and
+    // hash function, otherwise (or if it does not exist) start an empty table of size slots in it
+    // With BACK_SHM_WRITER path names a shared-memory object (e.g. "/people") instead of a file
+    // BACK_SHM_READER maps an existing object read-only, it is not open if none was written
+    // A writer (BACK_FILE or BACK_SHM_WRITER) holds an exclusive flock on the file until it is
+    // destroyed, a second writer of the same table is not open
+    MappedCache(const string& path, int size, hash_fn hash, prob_t probing = DEFPOLCY, backing_t backing = BACK_FILE);
+    // Flushes and unmaps, the table stays in the file
+    ~MappedCache();
+
+    // True if the file could be mapped, every operation fails otherwise
+    bool isOpen() const { return m_base != nullptr; }
+    // True if an existing table was picked up from the file
+    bool reopened() const { return m_reopened; }
+    // True for a reader, every change fails
+    bool readOnly() const { return m_readOnly; }
+    // Remove a shared-memory object, mappings that exist stay valid until they are closed
+    static bool unlinkShared(const string& name);
+
+    // Core operations (same as Cache), keys longer than MAPKEYMAX cannot be inserted
+    // Readers never take a lock, getPerson and liveCount retry while the writer is mid-operation
+    bool insert(Person person);
+    bool remove(Person person);
+    const Person getPerson(string key, int ID) const;
+    bool updateID(Person person, int ID);
+    void changeProbPolicy(prob_t policy);
+
+    float lambda() const;
+    float deletedRatio() const;
+    int liveCount() const;
+    // Write the dirty pages back to the file, needed for durability beyond a process crash
+    bool sync();
+
+private:
+    MappedHeader* header() const { return (MappedHeader*)m_base; }
+    uint32_t* slots(int region) const { return (uint32_t*)(m_base + header()->m_regions[region].m_offset); }
+    MappedEntry* entry(uint32_t ref) const { return (MappedEntry*)(m_base + header()->m_arenaOffset) + (ref - 1); }
+    int currentRegion() const { return header()->m_current; }
+    int oldRegion() const { return 1 - header()->m_current; }
+
+    // Map an existing shared table read-only
+    void attachReader();
+    // Start an empty table in a freshly sized file
+    void format(int size, prob_t probing);
+    // Build the table and the free list again from the live records in the arena, after an
+    // owner stopped in the middle of an operation
+    void rebuild();
+    void beginWrite();
+    void endWrite();
+    // Seqlock read side: wait for an even sequence number, then check it did not move
+    uint64_t readBegin() const;
+    bool readRetry(uint64_t seq) const;
+    void startNewRehash();
+    void transferPartOfTable();
+    void reinsertFromOld(uint32_t ref);
+    uint32_t allocEntry();
+    void freeEntry(uint32_t ref);
+
+    // Helper functions (same as Cache, on references instead of pointers)
+    int probeIndex(int hashedKey, int i, int capacity, prob_t policy) const;
+    int locateInsertionSlot(unsigned int hashedKey, int region) const;
+    int findPersonIndex(const string& key, int id, int region) const;
+    // findPersonIndex inside a read section: the writer may be changing the table under it,
+    // so every reference is checked before use and garbage only ever yields a miss
+    bool findUnderWriter(const string& key, int id, int region) const;
+    bool keyEquals(const MappedEntry* e, const string& key) const;
+
+    // Utility functions
+    bool isPrime(int number) const;
+    int findNextPrime(int current) const;
+
+    char*    m_base;        // start of the mapping
+    size_t   m_length;      // length of the mapping
+    int      m_fd;
+    bool     m_reopened;
+    bool     m_readOnly;    // mapped read-only by a BACK_SHM_READER
+    hash_fn  m_hash;
+};
+
+#endif // MAPPED_CACHE_H
@@ -0,0 +1,286 @@
+// Memory Footprint Benchmark
+// Usage: ./memory_benchmark [entries] [min key length] [max key length]
+// Grows a Cache one insert at a time and follows three views of its memory: what
+// Cache::memoryUsage() reports, what a counting allocator saw it allocate, and the
+// process RSS. The table bytes jump while the old and the new table coexist and fall back
+// when the migration ends; removes leave tombstones behind until the next rehash.
+// Then compares the bytes per entry of Cache, NaiveCache and std::unordered_map.
+// Results go to results/memory.csv
+#include "cache.h"
+#include "naive_cache.h"
+#include "benchmark_utils.h"
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define COUNTING_ALLOCATOR 1
+#endif
+
+using namespace std;
+
+const int DEFAULT_ENTRIES = 40000;    // a Cache of MAXPRIME slots holds this many under the rehash load factor
+const int SAMPLES = 200;        // regular samples per phase, migration starts and ends add more
+
+/******************************************
+* Counting allocator
+******************************************/
+// Every operator new of the process ends up here, the live total uses the footprint rule
+// of heapFootprint() so it can be compared with memoryUsage() byte for byte
+// Without glibc there is no way to size a block on delete, the counts then stay 0
+static atomic<long long> g_heapBytes(0);
+
+#ifdef COUNTING_ALLOCATOR
+static inline long long blockFootprint(void* block) {
+    return (long long)(malloc_usable_size(block) + sizeof(size_t));
+}
+#endif
+
+void* operator new(size_t size) {
+    void* block = malloc(size > 0 ? size : 1);
+    if (block == nullptr) {
+        throw bad_alloc();
+    }
+#ifdef COUNTING_ALLOCATOR
+    g_heapBytes.fetch_add(blockFootprint(block), memory_order_relaxed);
+#endif
+    return block;
+}
+
+// Kept out of line, inlined next to a new expression GCC would flag the free as mismatched
+__attribute__((noinline)) void operator delete(void* block) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+#ifdef COUNTING_ALLOCATOR
+    g_heapBytes.fetch_sub(blockFootprint(block), memory_order_relaxed);
+#endif
+    free(block);
+}
+
+// Array and sized forms, the library defaults forward to these as well but not every
+// standard library guarantees it
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete[](void* block) noexcept {
+    operator delete(block);
+}
+void operator delete(void* block, size_t) noexcept {
+    operator delete(block);
+}
+void operator delete[](void* block, size_t) noexcept {
+    operator delete(block);
+}
+
+// residentBytes: Second field of /proc/self/statm, 0 where it does not exist
+long long residentBytes() {
+    ifstream statm("/proc/self/statm");
+    long long pages = 0;
+    long long resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/******************************************
+* Sampling
+******************************************/
+struct MemorySample {
+    string      phase;
+    int         entries;
+    bool        migrating;
+    CacheMemory usage;
+    long long   counted;        // heap bytes the allocator saw since the cache was created
+    long long   rss;
+};
+
+// takeSample: The three views at one moment, base is the allocator count before the cache
+MemorySample takeSample(const Cache& cache, const string& phase, long long base) {
+    MemorySample sample;
+    sample.phase = phase;
+    sample.usage = cache.memoryUsage();
+    sample.entries = sample.usage.m_liveEntries;
+    sample.migrating = cache.stats().m_migrating;
+    sample.counted = g_heapBytes.load() - base;
+    sample.rss = residentBytes();
+    return sample;
+}
+
+void saveSample(ofstream& file, const MemorySample& s) {
+    file << s.phase << "," << s.entries << "," << (s.migrating ? 1 : 0) << ","
+         << s.usage.m_tables.m_requested << "," << s.usage.m_oldTable.m_requested << ","
+         << s.usage.m_nodes.m_requested << "," << s.usage.m_keys.m_requested << ","
+         << s.usage.m_tombstones.m_requested << "," << s.usage.m_aux.m_requested << ","
+         << s.usage.overhead() << "," << s.usage.total() << "," << s.counted << "," << s.rss << ","
+         << fixed << setprecision(1) << s.usage.bytesPerEntry() << endl;
+}
+
+void printSample(const MemorySample& s) {
+    cout << setw(10) << s.phase << setw(9) << s.entries << setw(5) << (s.migrating ? "yes" : "no")
+         << setw(12) << s.usage.m_tables.m_requested << setw(12) << s.usage.m_nodes.m_requested
+         << setw(11) << s.usage.m_keys.m_requested << setw(11) << s.usage.m_tombstones.m_requested
+         << setw(11) << s.usage.overhead() << setw(12) << s.usage.total()
+         << setw(12) << s.rss / 1024 << setw(9) << fixed << setprecision(1) << s.usage.bytesPerEntry() << endl;
+}
+
+// Samples are kept where the migration state flips, plus every interval operations
+class Sampler {
+public:
+    Sampler(const Cache& cache, long long base, ofstream& file)
+        : m_cache(cache), m_base(base), m_file(file), m_wasMigrating(false),
+          m_worstMismatch(0) {}
+
+    void step(const string& phase, int done, int interval, bool last) {
+        bool migrating = m_cache.stats().m_migrating;
+        bool flipped = migrating != m_wasMigrating;
+        m_wasMigrating = migrating;
+        if (flipped == false && done % interval != 0 && last == false) {
+            return;
+        }
+        MemorySample sample = takeSample(m_cache, phase, m_base);
+        saveSample(m_file, sample);
+        // Print the moments a migration starts and ends, those show the spike
+        if (flipped || last) {
+            printSample(sample);
+        }
+        // The first sample of a migration has the old table and the freshly allocated new one
+        if (flipped && migrating) {
+            m_lastSpike = sample.usage;
+        }
+        long long mismatch = sample.counted - (long long)sample.usage.heap();
+        m_worstMismatch = max(m_worstMismatch, mismatch < 0 ? -mismatch : mismatch);
+    }
+
+    const CacheMemory& lastSpike() const { return m_lastSpike; }
+    long long worstMismatch() const { return m_worstMismatch; }
+
+private:
+    const Cache&       m_cache;
+    long long          m_base;
+    ofstream&          m_file;
+    bool               m_wasMigrating;
+    CacheMemory        m_lastSpike;     // at the start of the latest migration
+    long long          m_worstMismatch;
+};
+
+void printHeader() {
+    cout << setw(10) << "phase" << setw(9) << "entries" << setw(5) << "mig"
+         << setw(12) << "tables B" << setw(12) << "nodes B" << setw(11) << "keys B"
+         << setw(11) << "tombst. B" << setw(11) << "overhead B" << setw(12) << "total B"
+         << setw(12) << "RSS KiB" << setw(9) << "B/entry" << endl;
+}
+
+/******************************************
+* Comparison
+******************************************/
+void printPerEntry(const string& label, double bytes) {
+    cout << "  " << left << setw(24) << label << right << fixed << setprecision(1)
+         << setw(9) << bytes << " B" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int entries = argc > 1 ? atoi(argv[1]) : DEFAULT_ENTRIES;
+    WorkloadSpec spec = WorkloadSpec::preset('C');
+    if (argc > 3) {
+        spec.minKeyLength = atoi(argv[2]);
+        spec.maxKeyLength = atoi(argv[3]);
+    }
+    if (entries < 1 || entries > MAXPRIME / 2 || spec.minKeyLength < 1 || spec.maxKeyLength < spec.minKeyLength) {
+        cerr << "Usage: " << argv[0] << " [entries] [min key length] [max key length]" << endl;
+        cerr << "entries go up to " << MAXPRIME / 2 << ", the largest table at the rehash load factor" << endl;
+        return 1;
+    }
+    spec.recordCount = entries;
+    WorkloadGenerator generator(spec, 42);
+
+    cout << "========================================" << endl;
+    cout << "MEMORY FOOTPRINT" << endl;
+    cout << "========================================" << endl;
+    cout << entries << " entries, keys of " << spec.minKeyLength << " to " << spec.maxKeyLength
+         << " bytes, sizeof(Person) " << sizeof(Person) << ", sizeof(Cache) " << sizeof(Cache) << endl;
+#ifndef COUNTING_ALLOCATOR
+    cout << "(no glibc: the counting allocator is off, counted bytes read 0)" << endl;
+#endif
+
+    ofstream file("results/memory.csv");
+    file << "Phase,Entries,Migrating,TableBytes,OldTableBytes,NodeBytes,KeyBytes,TombstoneBytes,"
+            "AuxBytes,OverheadBytes,TotalBytes,CountedBytes,RSSBytes,BytesPerEntry" << endl;
+
+    long long base = g_heapBytes.load();
+    Cache cache(MINPRIME, HASH_WY, DOUBLEHASH);
+    Sampler sampler(cache, base, file);
+    int interval = max(1, entries / SAMPLES);
+    CacheMemory grown;
+
+    // Phase 1: grow from the smallest table, every rehash doubles up the table arrays
+    cout << "\n[1/3] Inserting, rows where a migration starts or ends:" << endl;
+    printHeader();
+    for (int i = 0; i < entries; i++) {
+        cache.insert(generator.record(i));
+        sampler.step("insert", i + 1, interval, i == entries - 1);
+    }
+    grown = cache.memoryUsage();
+    CacheMemory spike = sampler.lastSpike();
+
+    // Phase 2: remove every other entry, the nodes stay as tombstones until a rehash drops them
+    cout << "\n[2/3] Removing every other entry:" << endl;
+    printHeader();
+    int removals = (entries + 1) / 2;
+    for (int i = 0; i < removals; i++) {
+        cache.remove(generator.record(i * 2));
+        sampler.step("remove", i + 1, interval, i == removals - 1);
+    }
+
+    cout << "\nAfter loading:" << endl << grown.toString();
+    cout << "\nAfter removing:" << endl << cache.memoryUsage().toString();
+    // Before the rehash only the old array existed, after it only the new one will
+    unsigned long long before = spike.m_oldTable.total();
+    unsigned long long during = spike.m_tables.total();
+    cout << "\nLast migration, table arrays: " << before << " B before, " << during << " B while both existed, "
+         << during - before << " B after (" << fixed << setprecision(2) << double(during) / before
+         << "x before, total " << spike.total() << " B)" << endl;
+    cout << "memoryUsage() vs counting allocator: largest difference "
+         << sampler.worstMismatch() << " B over all samples" << endl;
+    file.close();
+
+    // Phase 3: the same records in each container, allocated with new so the counting
+    // allocator sees the object as well as everything it points to
+    cout << "\n[3/3] Bytes per entry after loading " << entries << " entries:" << endl;
+    {
+        base = g_heapBytes.load();
+        Cache* incremental = new Cache(MINPRIME, HASH_WY, DOUBLEHASH);
+        for (int i = 0; i < entries; i++) {
+            incremental->insert(generator.record(i));
+        }
+        while (incremental->advanceMigration()) {
+        }
+        printPerEntry("Incremental (reported)", incremental->memoryUsage().bytesPerEntry());
+        printPerEntry("Incremental (counted)", double(g_heapBytes.load() - base) / entries);
+        delete incremental;
+    }
+    {
+        base = g_heapBytes.load();
+        NaiveCache* naive = new NaiveCache(MINPRIME, wyHashCode, DOUBLEHASH);
+        for (int i = 0; i < entries; i++) {
+            naive->insert(generator.record(i));
+        }
+        printPerEntry("Naive (counted)", double(g_heapBytes.load() - base) / entries);
+        delete naive;
+    }
+    {
+        base = g_heapBytes.load();
+        unordered_map<string, Person>* map = new unordered_map<string, Person>();
+        for (int i = 0; i < entries; i++) {
+            Person person = generator.record(i);
+            map->insert(make_pair(person.getKey(), person));
+        }
+        printPerEntry("std_unordered_map", double(g_heapBytes.load() - base) / entries);
+        delete map;
+    }
+    cout << "\nResults saved to results/memory.csv" << endl;
+    return 0;
+}
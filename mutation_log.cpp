@@ -0,0 +1,427 @@
+// Mutation Log Implementation
+#include "mutation_log.h"
+#include "cache.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// wallClockMs: TTLs are logged as wall clock expiry times, the steady clock does not survive a restart
+static long long wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// syncPath: fsync a file that was written through a stream
+static bool syncPath(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = (fsync(fd) == 0);
+    close(fd);
+    return ok;
+}
+
+// fileExists: True if something is at path
+static bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+// Constructor
+MutationLog::MutationLog(const std::string& path, fsync_t policy, int intervalMs) {
+    m_path = path;
+    m_policy = policy;
+    m_intervalMs = (intervalMs > 0) ? intervalMs : LOGFLUSHMS;
+    m_appendedLSN = 0;
+    m_durableLSN = 0;
+    m_waiters = 0;
+    m_flushing = false;
+    m_stop = false;
+    m_error = 0;
+    m_syncs = 0;
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (m_fd >= 0) {
+        m_flusher = std::thread(&MutationLog::flusherLoop, this);
+    }
+}
+
+// Destructor
+MutationLog::~MutationLog() {
+    if (m_fd < 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_flusher.join();
+    flush();
+    close(m_fd);
+    m_fd = -1;
+}
+
+// checksum: 32-bit FNV-1a
+uint32_t MutationLog::checksum(const char* data, size_t size) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// append: Encode the record into the pending buffer
+unsigned long long MutationLog::append(logop_t op, const std::string& key, int id, long long arg) {
+    LogRecordHead head;
+    head.m_checksum = 0;
+    head.m_keyLength = (uint32_t)key.size();
+    head.m_op = op;
+    head.m_id = id;
+    head.m_arg = arg;
+    // The checksum covers the fields after it and the key
+    std::vector<char> body(sizeof(head) - sizeof(head.m_checksum) + key.size());
+    memcpy(&body[0], (const char*)&head + sizeof(head.m_checksum), sizeof(head) - sizeof(head.m_checksum));
+    memcpy(&body[sizeof(head) - sizeof(head.m_checksum)], key.data(), key.size());
+    head.m_checksum = checksum(&body[0], body.size());
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_error != 0) {
+        return 0;
+    }
+    const char* checksumBytes = (const char*)&head.m_checksum;
+    m_buffer.insert(m_buffer.end(), checksumBytes, checksumBytes + sizeof(head.m_checksum));
+    m_buffer.insert(m_buffer.end(), body.begin(), body.end());
+    unsigned long long lsn = ++m_appendedLSN;
+    if (m_buffer.size() >= LOGBUFFERMAX) {
+        m_wake.notify_one();
+    }
+    return lsn;
+}
+
+// waitDurable: Ask the flusher for a batch and sleep until it covers lsn or the log fails
+bool MutationLog::waitDurable(unsigned long long lsn) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_durableLSN >= lsn) {
+        return true;
+    }
+    if (m_fd < 0 || m_error != 0) {
+        return false;
+    }
+    m_waiters++;
+    m_wake.notify_one();
+    m_durable.wait(lock, [this, lsn]() { return m_durableLSN >= lsn || m_stop || m_error != 0; });
+    m_waiters--;
+    return m_durableLSN >= lsn;
+}
+
+// failed: A write or sync went wrong, nothing more is written
+bool MutationLog::failed() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_error != 0;
+}
+
+// getError: errno of the failure
+int MutationLog::getError() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_error;
+}
+
+// lastLSN: LSN of the last appended record
+unsigned long long MutationLog::lastLSN() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_appendedLSN;
+}
+
+// flusherLoop: Write a batch whenever someone waits, the buffer is large, or (unless the
+// policy is FSYNC_ALWAYS) the interval has passed
+// While a batch is being synced new records pile up and go out together in the next one
+// After a failure it only waits for the stop
+void MutationLog::flusherLoop() {
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (true) {
+        auto ready = [this]() {
+            return m_stop || (m_error == 0 && (m_buffer.size() >= LOGBUFFERMAX ||
+                                               (m_waiters > 0 && m_buffer.empty() == false)));
+        };
+        if (m_policy == FSYNC_ALWAYS) {
+            m_wake.wait(lock, ready);
+        } else {
+            m_wake.wait_for(lock, std::chrono::milliseconds(m_intervalMs), ready);
+        }
+        if (m_stop) {
+            break;
+        }
+        if (m_buffer.empty() == false && m_error == 0) {
+            writeBatch(lock, true, m_policy != FSYNC_NEVER);
+        }
+    }
+    m_durable.notify_all();
+}
+
+// writeBatch: Take the buffer, write it, then publish the new durable LSN
+// A failed write keeps the bytes it did not get out in front of the records appended
+// meanwhile. After a failed sync the bytes are in the file but nothing is promised durable;
+// Linux may have dropped the dirty pages, so a retried sync could not be trusted either
+bool MutationLog::writeBatch(std::unique_lock<std::mutex>& lock, bool unlock, bool sync) {
+    std::vector<char> batch;
+    batch.swap(m_buffer);
+    unsigned long long upTo = m_appendedLSN;
+    m_flushing = true;
+    if (unlock) {
+        lock.unlock();
+    }
+    size_t written = writeAll(batch);
+    int error = (written < batch.size()) ? errno : 0;
+    if (error == 0 && sync && fdatasync(m_fd) != 0) {
+        error = errno;
+    }
+    if (unlock) {
+        lock.lock();
+    }
+    m_flushing = false;
+    m_syncs++;
+    if (error == 0) {
+        m_durableLSN = upTo;
+    } else {
+        batch.erase(batch.begin(), batch.begin() + written);
+        batch.insert(batch.end(), m_buffer.begin(), m_buffer.end());
+        m_buffer.swap(batch);
+        m_error = error;
+    }
+    m_durable.notify_all();
+    return error == 0;
+}
+
+// writeAll: write until every byte is out, an interrupted write is retried
+size_t MutationLog::writeAll(const std::vector<char>& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(m_fd, &data[done], data.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            break;
+        }
+        done += (size_t)n;
+    }
+    return done;
+}
+
+// flush: Write and sync everything appended so far, waits for a batch already in flight
+bool MutationLog::flush() {
+    if (m_fd < 0) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_durable.wait(lock, [this]() { return m_flushing == false; });
+    if (m_error != 0) {
+        return false;
+    }
+    return writeBatch(lock, false, true);
+}
+
+// compact: Rotate the log aside, write the snapshot, then drop the rotated log
+// Commit point is the unlink of the rotated log, recover finishes an interrupted rename
+bool MutationLog::compact(const Cache& cache, const std::string& snapshotPath) {
+    if (flush() == false) {
+        return false;
+    }
+    std::string rotated = m_path + ".compacting";
+    std::string pending = snapshotPath + ".compact";
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_durable.wait(lock, [this]() { return m_flushing == false; });
+        if (std::rename(m_path.c_str(), rotated.c_str()) != 0) {
+            return false;
+        }
+        int fd = open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd < 0) {
+            std::rename(rotated.c_str(), m_path.c_str());
+            return false;
+        }
+        close(m_fd);
+        m_fd = fd;
+    }
+    if (cache.saveSnapshot(pending) == false || syncPath(pending) == false) {
+        // The rotated log still holds everything, recovery replays it before the new log
+        std::remove(pending.c_str());
+        return false;
+    }
+    if (unlink(rotated.c_str()) != 0) {
+        return false;
+    }
+    return std::rename(pending.c_str(), snapshotPath.c_str()) == 0;
+}
+
+// recover: Snapshot first, then the rotated log of an unfinished compaction, then the log
+bool MutationLog::recover(Cache& cache, const std::string& logPath, const std::string& snapshotPath) {
+    std::string rotated = logPath + ".compacting";
+    std::string pending = snapshotPath + ".compact";
+    if (fileExists(rotated)) {
+        // The compaction never committed, its snapshot may be incomplete
+        std::remove(pending.c_str());
+    } else if (fileExists(pending)) {
+        // Committed but not renamed yet
+        if (std::rename(pending.c_str(), snapshotPath.c_str()) != 0) {
+            return false;
+        }
+    }
+    if (fileExists(snapshotPath) && cache.loadSnapshot(snapshotPath) == false) {
+        return false;
+    }
+    if (fileExists(rotated)) {
+        if (replay(cache, rotated) < 0) {
+            return false;
+        }
+        if (fileExists(logPath)) {
+            if (replay(cache, logPath) < 0) {
+                return false;
+            }
+            // Fold the newer records behind the rotated ones so the log is whole again
+            std::ifstream in(logPath.c_str(), std::ios::binary);
+            std::ofstream out(rotated.c_str(), std::ios::binary | std::ios::app);
+            if (in.peek() != std::ifstream::traits_type::eof()) {
+                out << in.rdbuf();
+            }
+            out.close();
+            in.close();
+        }
+        return syncPath(rotated) && std::rename(rotated.c_str(), logPath.c_str()) == 0;
+    }
+    if (fileExists(logPath) == false) {
+        return true;
+    }
+    return replay(cache, logPath) >= 0;
+}
+
+// replay: Apply one log file and cut off a torn record at its end
+long long MutationLog::replay(Cache& cache, const std::string& path) {
+    long long validBytes = 0;
+    long long applied = replayFile(cache, path, validBytes);
+    if (applied < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && info.st_size > validBytes) {
+        if (truncate(path.c_str(), validBytes) != 0) {
+            return -1;
+        }
+    }
+    return applied;
+}
+
+// replayFile: Pipelined decode, a reader thread streams the file in chunks and decodes
+// records into batches while the calling thread applies them in log order
+long long MutationLog::replayFile(Cache& cache, const std::string& path, long long& validBytes) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        return -1;
+    }
+    std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<std::vector<DecodedRecord> > queue;
+    bool done = false;
+    long long decodedBytes = 0;
+
+    std::thread reader([&]() {
+        std::vector<char> data;
+        size_t start = 0;
+        std::vector<char> chunk(LOGREADCHUNK);
+        bool corrupt = false;
+        while (corrupt == false) {
+            in.read(&chunk[0], chunk.size());
+            std::streamsize got = in.gcount();
+            if (got <= 0) {
+                break;
+            }
+            // Keep the undecoded tail of the previous chunk in front of the new one
+            data.erase(data.begin(), data.begin() + start);
+            start = 0;
+            data.insert(data.end(), chunk.begin(), chunk.begin() + got);
+            std::vector<DecodedRecord> batch;
+            while (data.size() - start >= sizeof(LogRecordHead)) {
+                LogRecordHead head;
+                memcpy(&head, &data[start], sizeof(head));
+                if (head.m_keyLength > LOGREADCHUNK) {
+                    corrupt = true;
+                    break;
+                }
+                size_t length = sizeof(head) + head.m_keyLength;
+                if (data.size() - start < length) {
+                    break;
+                }
+                const char* body = &data[start] + sizeof(head.m_checksum);
+                if (checksum(body, length - sizeof(head.m_checksum)) != head.m_checksum) {
+                    corrupt = true;
+                    break;
+                }
+                DecodedRecord record;
+                record.m_op = head.m_op;
+                record.m_key.assign(&data[start] + sizeof(head), head.m_keyLength);
+                record.m_id = head.m_id;
+                record.m_arg = head.m_arg;
+                batch.push_back(record);
+                start += length;
+                decodedBytes += length;
+            }
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueChanged.wait(lock, [&]() { return (int)queue.size() < LOGREPLAYQUEUE; });
+            queue.push_back(std::vector<DecodedRecord>());
+            queue.back().swap(batch);
+            queueChanged.notify_all();
+        }
+        std::lock_guard<std::mutex> guard(queueLock);
+        done = true;
+        queueChanged.notify_all();
+    });
+
+    long long applied = 0;
+    long long now = wallClockMs();
+    while (true) {
+        std::vector<DecodedRecord> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueChanged.wait(lock, [&]() { return queue.empty() == false || done; });
+            if (queue.empty()) {
+                break;
+            }
+            batch.swap(queue.front());
+            queue.pop_front();
+            queueChanged.notify_all();
+        }
+        for (unsigned int i = 0; i < batch.size(); i++) {
+            const DecodedRecord& r = batch[i];
+            Person person(r.m_key, r.m_id, true);
+            if (r.m_op == LOG_INSERT) {
+                if (r.m_arg == 0) {
+                    cache.insert(person);
+                } else if (r.m_arg > now) {
+                    // Only the time left is restored, entries that expired meanwhile stay out
+                    long long left = r.m_arg - now;
+                    cache.insert(person, (int)(left < INT_MAX ? left : INT_MAX));
+                }
+            } else if (r.m_op == LOG_REMOVE) {
+                cache.remove(person);
+            } else if (r.m_op == LOG_UPDATE) {
+                cache.updateID(person, (int)r.m_arg);
+            }
+            applied++;
+        }
+    }
+    reader.join();
+    validBytes = decodedBytes;
+    return applied;
+}
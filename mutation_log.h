@@ -0,0 +1,111 @@
+// Mutation Log (append-only write-ahead log for Cache)
+// Every successful insert/remove/updateID is appended as a checksummed record. A background
+// flusher writes the records in batches with one write and one fdatasync per batch, so
+// concurrent committers share a sync (group commit)
+#ifndef MUTATION_LOG_H
+#define MUTATION_LOG_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+class Cache;    // forward declaration
+
+enum fsync_t {FSYNC_ALWAYS, FSYNC_EVERY_MS, FSYNC_NEVER};  // when appended records reach the disk
+enum logop_t {LOG_INSERT = 1, LOG_REMOVE = 2, LOG_UPDATE = 3};
+
+const int LOGFLUSHMS = 10;                  // default flush interval of FSYNC_EVERY_MS
+const size_t LOGBUFFERMAX = 1 << 20;        // a buffer this large is flushed right away
+const size_t LOGREADCHUNK = 1 << 20;        // bytes read at a time during replay
+const int LOGREPLAYQUEUE = 4;               // decoded batches the replay reader may run ahead
+
+// Fixed part of every record, followed by m_keyLength bytes of key
+struct LogRecordHead {
+    uint32_t m_checksum;    // FNV-1a of everything after this field, key included
+    uint32_t m_keyLength;
+    int32_t  m_op;          // logop_t
+    int32_t  m_id;
+    int64_t  m_arg;         // new ID for LOG_UPDATE, wall clock expiry in ms for LOG_INSERT (0 = none)
+};
+
+class MutationLog {
+public:
+    // Open (or create) the log for appending, records are added after the existing ones
+    MutationLog(const std::string& path, fsync_t policy = FSYNC_EVERY_MS, int intervalMs = LOGFLUSHMS);
+    // Writes and syncs what is left, then stops the flusher
+    ~MutationLog();
+
+    bool isOpen() const { return m_fd >= 0; }
+    fsync_t getPolicy() const { return m_policy; }
+    // True once a write or sync failed; the log then takes no more records and the records
+    // not written stay in memory only
+    bool failed();
+    // errno of the failed write or sync, 0 if none failed
+    int getError();
+
+    // Queue one record, returns its log sequence number (LSN), 0 if the log has failed
+    unsigned long long append(logop_t op, const std::string& key, int id, long long arg);
+    // Block until every record up to lsn is written (and synced unless the policy is FSYNC_NEVER)
+    // Returns false if the log failed before that
+    bool waitDurable(unsigned long long lsn);
+    // LSN of the last appended record
+    unsigned long long lastLSN();
+    // Write and sync everything appended so far on the calling thread
+    bool flush();
+
+    // Replace the log by a snapshot of cache, which must reflect every record appended so far
+    // A crash at any point leaves either the old snapshot and log or the new ones
+    bool compact(const Cache& cache, const std::string& snapshotPath);
+    // Bring cache to the last durable state: load the snapshot if there is one, then replay
+    // the log. A torn record at the end of the log is cut off. Call before opening the log
+    static bool recover(Cache& cache, const std::string& logPath, const std::string& snapshotPath);
+    // Apply the records of one log file to cache, returns the number applied or -1 if the
+    // file cannot be read. Replay is pipelined, not parallel: a reader thread decodes the
+    // next batches while the calling thread applies the records one by one in log order
+    static long long replay(Cache& cache, const std::string& path);
+
+    // Expose for benchmarking
+    int getSyncCount() const { return m_syncs; }
+
+private:
+    // One record decoded by the replay reader
+    struct DecodedRecord {
+        int         m_op;
+        std::string m_key;
+        int         m_id;
+        long long   m_arg;
+    };
+
+    void flusherLoop();
+    // Write the pending buffer (and sync it if sync is set), publish the new durable LSN
+    // On failure the bytes not written go back into the buffer and the error is latched
+    // Called with the lock held, which is released during the I/O if unlock is set
+    bool writeBatch(std::unique_lock<std::mutex>& lock, bool unlock, bool sync);
+    // Returns the bytes written, fewer than data.size() only on an error
+    size_t writeAll(const std::vector<char>& data);
+    static uint32_t checksum(const char* data, size_t size);
+    static long long replayFile(Cache& cache, const std::string& path, long long& validBytes);
+
+    std::string             m_path;
+    int                     m_fd;
+    fsync_t                 m_policy;
+    int                     m_intervalMs;
+
+    std::mutex              m_lock;         // guards everything below
+    std::condition_variable m_wake;         // wakes the flusher
+    std::condition_variable m_durable;      // wakes threads waiting for their LSN
+    std::vector<char>       m_buffer;       // records not written yet
+    unsigned long long      m_appendedLSN;  // last LSN handed out
+    unsigned long long      m_durableLSN;   // last LSN written (and synced)
+    int                     m_waiters;      // threads inside waitDurable
+    bool                    m_flushing;     // a batch is being written
+    bool                    m_stop;
+    int                     m_error;        // errno of the first failed write or sync, 0 if none
+    int                     m_syncs;        // write batches issued
+    std::thread             m_flusher;
+};
+
+#endif // MUTATION_LOG_H
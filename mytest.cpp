@@ -3,6 +3,10 @@
 #include <algorithm>
 #include <random>
 #include <vector>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <cstdio>
 
 using namespace std;
 
@@ -615,6 +619,654 @@ public:
         return false;
     }
 
+    // testLRUEvictsLeastRecent: Test that a bounded cache evicts the least recently used entry and never exceeds its bound.
+    bool testLRUEvictsLeastRecent() {
+        Cache c(MINPRIME, hashCode, LINEAR);
+        c.setMaxEntries(10, LRU);
+
+        // Fill the cache up to its bound
+        for (int i = 0; i < 10; i++) {
+            if (c.insert(Person("key" + to_string(i), MINID + i, true)) == false) {
+                return false;
+            }
+        }
+        // Touch key0 so key1 becomes the least recently used
+        if (c.getPerson("key0", MINID).getKey() != "key0") {
+            return false;
+        }
+        // Inserting one more must evict key1 only
+        if (c.insert(Person("key10", MINID + 10, true)) == false) {
+            return false;
+        }
+        if (c.liveCount() != 10) {
+            return false;
+        }
+        if (c.getPerson("key1", MINID + 1).getKey() != "") {
+            return false;
+        }
+        if (c.getPerson("key0", MINID).getKey() != "key0") {
+            return false;
+        }
+        if (c.getPerson("key10", MINID + 10).getKey() != "key10") {
+            return false;
+        }
+        return true;
+    }
+    // testLRUAcrossRehash: Test that the recency order survives the incremental transfer between tables.
+    bool testLRUAcrossRehash() {
+        Cache c(MINPRIME, hashCode, QUADRATIC);
+        const int BOUND = 60;
+        c.setMaxEntries(BOUND, LRU);
+
+        bool sawRehash = false;
+        for (int i = 0; i < 200; i++) {
+            if (c.insert(Person("key" + to_string(i), MINID + i, true)) == false) {
+                return false;
+            }
+            if (c.m_oldTable != nullptr) {
+                sawRehash = true;
+            }
+            // The bound holds at every step
+            if (c.liveCount() > BOUND) {
+                return false;
+            }
+            // Keep key0 hot, it must never be evicted
+            if (c.getPerson("key0", MINID).getKey() != "key0") {
+                return false;
+            }
+        }
+        if (sawRehash == false) {
+            return false;
+        }
+        // The most recent entries are still there, the oldest cold ones are gone
+        for (int i = 200 - BOUND + 1; i < 200; i++) {
+            if (c.getPerson("key" + to_string(i), MINID + i).getKey() == "") {
+                return false;
+            }
+        }
+        if (c.getPerson("key1", MINID + 1).getKey() != "") {
+            return false;
+        }
+        // Walking the list from the tail must see exactly the live entries
+        int linked = 0;
+        for (Person* p = c.m_lruTail; p != nullptr; p = p->m_prev) {
+            if (p->m_used == false) {
+                return false;
+            }
+            linked++;
+        }
+        return linked == c.liveCount();
+    }
+
+    // testClockSecondChance: Test that CLOCK eviction skips referenced entries and evicts an unreferenced one.
+    bool testClockSecondChance() {
+        Cache c(MINPRIME, hashCode, LINEAR);
+        c.setMaxEntries(10, CLOCK);
+
+        for (int i = 0; i < 11; i++) {
+            if (c.insert(Person("key" + to_string(i), MINID + i, true)) == false) {
+                return false;
+            }
+        }
+        if (c.liveCount() != 10) {
+            return false;
+        }
+        // Find the entries that survived the first eviction and reference all of them but one
+        string victim = "";
+        for (int i = 0; i < 10; i++) {
+            string key = "key" + to_string(i);
+            if (c.getPerson(key, MINID + i).getKey() == "") {
+                continue;
+            }
+            if (victim == "") {
+                victim = key;
+                // Undo the reference bit set by the lookup above
+                Person target(key, MINID + i, true);
+                int index = c.findPersonIndex(target, c.m_currentTable, c.m_currentCap, c.m_currProbing);
+                c.m_currentTable[index]->m_ref = false;
+            }
+        }
+        if (c.insert(Person("key11", MINID + 11, true)) == false) {
+            return false;
+        }
+        // Only the unreferenced entry is gone
+        for (int i = 0; i < 12; i++) {
+            string key = "key" + to_string(i);
+            Person found = c.getPerson(key, MINID + i);
+            if (key == victim && found.getKey() != "") {
+                return false;
+            }
+        }
+        return c.liveCount() == 10;
+    }
+    // testClockAcrossRehash: Test that CLOCK eviction keeps the bound and hot entries while entries are transferred.
+    bool testClockAcrossRehash() {
+        Cache c(MINPRIME, hashCode, QUADRATIC);
+        const int BOUND = 60;
+        c.setMaxEntries(BOUND, CLOCK);
+
+        bool sawRehash = false;
+        for (int i = 0; i < 300; i++) {
+            if (c.insert(Person("key" + to_string(i), MINID + i, true)) == false) {
+                return false;
+            }
+            if (c.m_oldTable != nullptr) {
+                sawRehash = true;
+            }
+            if (c.liveCount() > BOUND) {
+                return false;
+            }
+            // key0 is read after every insert, so it always has its reference bit set
+            if (c.getPerson("key0", MINID).getKey() != "key0") {
+                return false;
+            }
+        }
+        return sawRehash;
+    }
+
+    // testAdmissionResistsScan: Test that the TinyLFU admission filter keeps a hot set through a scan of one-hit keys.
+    bool testAdmissionResistsScan() {
+        const int BOUND = 100;
+        const int HOT = 50;
+        int keptWithFilter = 0;
+        int keptWithout = 0;
+        for (int run = 0; run < 2; run++) {
+            Cache c(MINPRIME, hashCode, DOUBLEHASH);
+            c.setMaxEntries(BOUND, LRU);
+            c.setAdmissionFilter(run == 0);
+            // Build a hot set that is read several times
+            for (int i = 0; i < HOT; i++) {
+                if (c.insert(Person("hot" + to_string(i), MINID + i, true)) == false) {
+                    return false;
+                }
+            }
+            for (int round = 0; round < 5; round++) {
+                for (int i = 0; i < HOT; i++) {
+                    c.getPerson("hot" + to_string(i), MINID + i);
+                }
+            }
+            // A batch job scans through many keys that are never read again
+            for (int i = 0; i < 1000; i++) {
+                if (c.insert(Person("scan" + to_string(i), MINID + 1000 + i, true)) == false) {
+                    return false;
+                }
+                if (c.liveCount() > BOUND) {
+                    return false;
+                }
+            }
+            int kept = 0;
+            for (int i = 0; i < HOT; i++) {
+                if (c.getPerson("hot" + to_string(i), MINID + i).getKey() != "") {
+                    kept++;
+                }
+            }
+            if (run == 0) {
+                keptWithFilter = kept;
+            } else {
+                keptWithout = kept;
+            }
+        }
+        // Plain LRU loses the whole hot set, the filter keeps nearly all of it
+        return keptWithout == 0 && keptWithFilter >= HOT * 9 / 10;
+    }
+
+    // testTTLExpiry: Test that entries with a TTL disappear and are reclaimed while others stay.
+    bool testTTLExpiry() {
+        Cache c(MINPRIME, hashCode, DOUBLEHASH);
+        for (int i = 0; i < 20; i++) {
+            // Half of the entries expire after 20 ms, the rest never
+            if (c.insert(Person("ttl" + to_string(i), MINID + i, true), (i % 2 == 0) ? 20 : 0) == false) {
+                return false;
+            }
+        }
+        if (c.getPerson("ttl0", MINID).getKey() != "ttl0") {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        // Expired entries are misses right away
+        for (int i = 0; i < 20; i++) {
+            bool found = c.getPerson("ttl" + to_string(i), MINID + i).getKey() != "";
+            if (found != (i % 2 == 1)) {
+                return false;
+            }
+        }
+        // A few more operations reclaim them through the lazy delete
+        for (int i = 0; i < 5; i++) {
+            c.insert(Person("other" + to_string(i), MINID + 100 + i, true));
+        }
+        return c.liveCount() == 15 && c.remove(Person("ttl2", MINID + 2, true)) == false;
+    }
+
+    // testTTLReinsertAndUpdate: Test re-inserting an expired key and that updateID keeps the TTL.
+    bool testTTLReinsertAndUpdate() {
+        Cache c(MINPRIME, hashCode, DOUBLEHASH);
+        if (c.insert(Person("short", MINID, true), 10) == false ||
+            c.insert(Person("moved", MINID + 1, true), 30) == false) {
+            return false;
+        }
+        // The key is still live, a second insert is a duplicate
+        if (c.insert(Person("short", MINID, true)) == true) {
+            return false;
+        }
+        if (c.updateID(Person("moved", MINID + 1, true), MINID + 2) == false) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        // The expired copy does not block a new insert, which never expires
+        if (c.insert(Person("short", MINID, true)) == false) {
+            return false;
+        }
+        // The updated entry expired under its new ID too
+        if (c.getPerson("moved", MINID + 2).getKey() != "" ||
+            c.updateID(Person("moved", MINID + 2, true), MINID + 3) == true) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        c.insert(Person("tick", MINID + 4, true));
+        // The stale timer of the first "short" must not take the new one with it
+        return c.getPerson("short", MINID).getKey() == "short";
+    }
+
+    // testNegativeFilterMatchesTable: Test that a cache with the negative filter answers like one without it.
+    bool testNegativeFilterMatchesTable() {
+        Cache plain(MINPRIME, hashCode, DOUBLEHASH);
+        Cache filtered(MINPRIME, hashCode, DOUBLEHASH);
+        filtered.setNegativeFilter(true);
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<int> pick(0, 1999);
+        std::uniform_int_distribution<int> action(0, 9);
+        // Mixed inserts, removes, updates and lookups through many rehashes
+        for (int step = 0; step < 20000; step++) {
+            int n = pick(gen);
+            Person p("neg" + to_string(n), MINID + n, true);
+            int a = action(gen);
+            if (a < 4) {
+                if (plain.insert(p) != filtered.insert(p)) {
+                    return false;
+                }
+            } else if (a < 7) {
+                if (plain.remove(p) != filtered.remove(p)) {
+                    return false;
+                }
+            } else if (a < 8) {
+                // Move the ID back and forth, the key and so its fingerprint stay the same
+                int other = (n % 2 == 0) ? MINID + n + 1 : MINID + n - 1;
+                if (plain.updateID(p, other) != filtered.updateID(p, other) ||
+                    plain.updateID(Person(p.getKey(), other, true), MINID + n) !=
+                    filtered.updateID(Person(p.getKey(), other, true), MINID + n)) {
+                    return false;
+                }
+            } else {
+                if (plain.getPerson(p.getKey(), p.getID()).getKey() != filtered.getPerson(p.getKey(), p.getID()).getKey()) {
+                    return false;
+                }
+            }
+        }
+        if (plain.liveCount() != filtered.liveCount() || filtered.m_currFilter.saturated() == true) {
+            return false;
+        }
+        // The filters hold exactly the live entries of their tables
+        int live = filtered.m_currentSize - filtered.m_currNumDeleted;
+        int oldLive = filtered.m_oldTable != nullptr ? filtered.m_oldSize - filtered.m_oldNumDeleted : 0;
+        return filtered.m_currFilter.size() == live && filtered.m_oldFilter.size() == oldLive;
+    }
+
+    // testNegativeFilterEnableLate: Test turning the filter on with entries in both tables.
+    bool testNegativeFilterEnableLate() {
+        Cache c(MINPRIME, hashCode, QUADRATIC);
+        int inserted = 0;
+        // Stop right after a rehash starts so both tables hold entries
+        while (c.m_oldTable == nullptr) {
+            if (c.insert(Person("late" + to_string(inserted), MINID + inserted, true)) == false) {
+                return false;
+            }
+            inserted++;
+        }
+        c.setNegativeFilter(true);
+        for (int i = 0; i < inserted; i++) {
+            if (c.getPerson("late" + to_string(i), MINID + i).getKey() == "") {
+                return false;
+            }
+        }
+        // Missing keys are filtered out, no false negatives for the present ones above
+        int misses = 0;
+        for (int i = 0; i < 1000; i++) {
+            if (c.getPerson("missing" + to_string(i), MINID + i).getKey() == "") {
+                misses++;
+            }
+        }
+        return misses == 1000;
+    }
+
+    // testIDIndexRange: Test range and ID lookups with the index against a full scan, through rehashes.
+    bool testIDIndexRange() {
+        Cache indexed(MINPRIME, hashCode, QUADRATIC);
+        Cache scanned(MINPRIME, hashCode, QUADRATIC);
+        indexed.setIDIndex(true);
+        std::mt19937 gen(11);
+        std::uniform_int_distribution<int> pick(0, 2999);
+        std::uniform_int_distribution<int> action(0, 9);
+        for (int step = 0; step < 15000; step++) {
+            int n = pick(gen);
+            // IDs repeat across keys so one ID can map to several entries
+            Person p("idx" + to_string(n), MINID + n % 500, true);
+            int a = action(gen);
+            if (a < 5) {
+                if (indexed.insert(p) != scanned.insert(p)) {
+                    return false;
+                }
+            } else if (a < 8) {
+                if (indexed.remove(p) != scanned.remove(p)) {
+                    return false;
+                }
+            } else {
+                int newID = MINID + pick(gen) % 500;
+                if (indexed.updateID(p, newID) != scanned.updateID(p, newID)) {
+                    return false;
+                }
+            }
+            if (step % 500 == 0) {
+                int lo = MINID + pick(gen) % 500;
+                vector<Person> fromIndex = indexed.getByIDRange(lo, lo + 50);
+                vector<Person> fromScan = scanned.getByIDRange(lo, lo + 50);
+                if (fromIndex.size() != fromScan.size()) {
+                    return false;
+                }
+                for (unsigned int i = 0; i < fromIndex.size(); i++) {
+                    // Same IDs in the same order, the keys of equal IDs may come in another order
+                    if (fromIndex[i].getID() != fromScan[i].getID() ||
+                        fromIndex[i].getID() < lo || fromIndex[i].getID() > lo + 50) {
+                        return false;
+                    }
+                }
+                if (indexed.getByID(lo).getID() != scanned.getByID(lo).getID()) {
+                    return false;
+                }
+            }
+        }
+        // Every live entry is indexed once
+        return (int)indexed.getByIDRange(MINID, MAXID).size() == indexed.liveCount() &&
+               indexed.m_idIndex.size() == indexed.liveCount();
+    }
+
+    // testKeyGroups: Test getAllByKey against the inserted entries, across rehashes and removes.
+    bool testKeyGroups() {
+        Cache c(MINPRIME, hashCode, DOUBLEHASH);
+        const int KEYS = 5;
+        const int PERKEY = 300;
+        // A small vocabulary of keys with many IDs each
+        for (int i = 0; i < KEYS * PERKEY / 2; i++) {
+            c.insert(Person("group" + to_string(i % KEYS), MINID + i, true));
+        }
+        // Turn the groups on halfway through, then keep inserting across rehashes
+        if (c.getAllByKey("group0").size() != PERKEY / 2) {
+            return false;
+        }
+        for (int i = KEYS * PERKEY / 2; i < KEYS * PERKEY; i++) {
+            c.insert(Person("group" + to_string(i % KEYS), MINID + i, true));
+        }
+        // The range is taken while a migration may be running and walked after more transfers
+        KeyRange range = c.getAllByKey("group1");
+        for (int i = 0; i < 10; i++) {
+            c.insert(Person("other" + to_string(i), MINID + i, true));
+        }
+        int count = 0;
+        for (KeyRange::iterator it = range.begin(); it != range.end(); ++it) {
+            if (it->getKey() != "group1" || (it->getID() - MINID) % KEYS != 1) {
+                return false;
+            }
+            count++;
+        }
+        if (count != PERKEY) {
+            return false;
+        }
+        // Removed entries leave their group, an emptied group is gone
+        for (int i = 0; i < KEYS * PERKEY; i += KEYS) {
+            c.remove(Person("group0", MINID + i, true));
+        }
+        for (int i = 2; i < KEYS * PERKEY; i += 2 * KEYS) {
+            c.remove(Person("group2", MINID + i, true));
+        }
+        return c.getAllByKey("group0").empty() && c.getAllByKey("group2").size() == PERKEY / 2 &&
+               c.getAllByKey("group3").size() == PERKEY && c.getAllByKey("missing").empty();
+    }
+
+    // testScanAcrossRehash: Test that a cursor scan visits every stable entry while rehashes run underneath.
+    bool testScanAcrossRehash() {
+        Cache c(MINPRIME, hashCode, QUADRATIC);
+        const int STABLE = 400;
+        for (int i = 0; i < STABLE; i++) {
+            c.insert(Person("stable" + to_string(i), MINID + i, true));
+        }
+        // A full scan without writes sees every entry exactly once
+        vector<int> seen(STABLE, 0);
+        unsigned long long cursor = 0;
+        do {
+            cursor = c.scan(cursor, 10, [&seen](const Person& p) { seen[p.getID() - MINID]++; });
+        } while (cursor != 0);
+        for (int i = 0; i < STABLE; i++) {
+            if (seen[i] != 1) {
+                return false;
+            }
+        }
+        // Now churn between the steps: inserts grow the table through several rehashes
+        // and removes create tombstones, the stable entries must still all be visited
+        seen.assign(STABLE, 0);
+        unsigned int startEpoch = c.m_rehashEpoch;
+        int churn = 0;
+        int steps = 0;
+        cursor = 0;
+        do {
+            cursor = c.scan(cursor, 7, [&seen](const Person& p) {
+                if (p.getKey().compare(0, 6, "stable") == 0) {
+                    seen[p.getID() - MINID]++;
+                }
+            });
+            // Writes stop after a while, otherwise the table outgrows the cursor forever
+            for (int j = 0; j < 5 && churn < 3000; j++) {
+                c.insert(Person("churn" + to_string(churn), MINID + STABLE + churn, true));
+                if (churn % 3 == 0) {
+                    c.remove(Person("churn" + to_string(churn / 2), MINID + STABLE + churn / 2, true));
+                }
+                churn++;
+            }
+            steps++;
+        } while (cursor != 0 && steps < 100000);
+        if (cursor != 0 || c.m_rehashEpoch - startEpoch < 2) {
+            return false;
+        }
+        for (int i = 0; i < STABLE; i++) {
+            if (seen[i] == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // testSnapshotRoundTrip: Test that a snapshot restores every live entry into a table at its final size.
+    bool testSnapshotRoundTrip() {
+        const char* path = "mytest_snapshot.bin";
+        Cache source(MINPRIME, hashCode, DOUBLEHASH);
+        for (int i = 0; i < 3000; i++) {
+            source.insert(Person("snap" + to_string(i), MINID + i, true));
+        }
+        // Tombstones and a TTL entry that is still live when saved
+        for (int i = 0; i < 3000; i += 3) {
+            source.remove(Person("snap" + to_string(i), MINID + i, true));
+        }
+        source.insert(Person("ttl", MINID, true), 60000);
+        if (source.saveSnapshot(path) == false) {
+            return false;
+        }
+        Cache target(MINPRIME, hashCode, QUADRATIC);
+        target.insert(Person("before", MINID, true));
+        bool result = target.loadSnapshot(path);
+        // The table is built in one step, no migration follows
+        result = result && target.m_oldTable == nullptr && target.lambda() <= 0.5 &&
+                 target.liveCount() == source.liveCount() && target.m_currProbing == DOUBLEHASH;
+        for (int i = 0; i < 3000 && result; i++) {
+            bool expected = (i % 3 != 0);
+            result = (target.getPerson("snap" + to_string(i), MINID + i).getKey() != "") == expected;
+        }
+        result = result && target.getPerson("before", MINID).getKey() == "" &&
+                 target.getPerson("ttl", MINID).getKey() == "ttl" && target.getPerson("ttl", MINID).getID() == MINID;
+        // A truncated file is rejected and the contents stay as they are
+        ifstream in(path, ios::binary);
+        string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        in.close();
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(bytes.data(), bytes.size() / 2);
+        out.close();
+        result = result && target.loadSnapshot(path) == false && target.liveCount() == source.liveCount();
+        std::remove(path);
+        return result && target.loadSnapshot(path) == false;
+    }
+
+    // testSnapshotLargeCache: Test that a cache past MAXPRIME / 2 entries, which fills the largest
+    // table beyond half, saves and loads again with every entry.
+    bool testSnapshotLargeCache() {
+        const char* path = "mytest_large_snapshot.bin";
+        const int entries = 70000;
+        Cache source(MINPRIME, hashCode, DOUBLEHASH);
+        for (int i = 0; i < entries; i++) {
+            source.insert(Person("large" + to_string(i), MINID + i % (MAXID - MINID), true));
+        }
+        while (source.advanceMigration()) {}
+        bool result = source.liveCount() == entries && source.saveSnapshot(path);
+        Cache target(MINPRIME, hashCode, DOUBLEHASH);
+        result = result && target.loadSnapshot(path) && target.liveCount() == entries &&
+                 target.m_currentCap == MAXPRIME;
+        for (int i = 0; i < entries && result; i++) {
+            result = target.getPerson("large" + to_string(i), MINID + i % (MAXID - MINID)).getKey() != "";
+        }
+        std::remove(path);
+        return result;
+    }
+
+    // testSnapshotAsyncDuringMigration: Test that a background snapshot holds the state at the call,
+    // with both tables of a running migration, while the parent keeps changing the table.
+    bool testSnapshotAsyncDuringMigration() {
+        const char* path = "mytest_async_snapshot.bin";
+        Cache source(MINPRIME, hashCode, DOUBLEHASH);
+        int n = 0;
+        // Stop one insert after a rehash started, so entries sit in both tables
+        while (n < 2000 || source.m_oldTable == nullptr) {
+            source.insert(Person("async" + to_string(n), MINID + n, true));
+            n++;
+        }
+        source.insert(Person("async" + to_string(n), MINID + n, true));
+        n++;
+        bool result = source.m_oldTable != nullptr && source.m_currentSize > 0 && source.saveSnapshotAsync(path);
+        int live = source.liveCount();
+        // Changes after the fork must not reach the file
+        for (int i = 0; i < n; i += 2) {
+            source.remove(Person("async" + to_string(i), MINID + i, true));
+        }
+        source.insert(Person("later", MINID, true));
+        result = result && source.waitSnapshot() && source.snapshotPending() == false;
+        Cache target(MINPRIME, hashCode, DOUBLEHASH);
+        result = result && target.loadSnapshot(path) && target.liveCount() == live;
+        for (int i = 0; i < n && result; i++) {
+            result = target.getPerson("async" + to_string(i), MINID + i).getKey() != "";
+        }
+        result = result && target.getPerson("later", MINID).getKey() == "";
+        std::remove(path);
+        return result;
+    }
+
+    // testStatsCounters: Test that stats() counts every outcome, fills the probe histograms and
+    // follows the migration.
+    bool testStatsCounters() {
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        for (int i = 0; i < 1000; i++) {
+            cache.insert(Person("stat" + to_string(i), MINID + i, true));
+        }
+        cache.insert(Person("stat0", MINID, true));     // duplicate
+        cache.insert(Person("bad", 1, true));           // invalid ID
+        int hits = 0;
+        for (int i = 0; i < 1000; i += 2) {
+            hits += cache.getPerson("stat" + to_string(i), MINID + i).getKey() != "" ? 1 : 0;
+        }
+        cache.getPerson("missing", MINID);
+        cache.remove(Person("stat1", MINID + 1, true));
+        cache.remove(Person("stat1", MINID + 1, true));
+        cache.updateID(Person("stat3", MINID + 3, true), MAXID);
+        cache.updateID(Person("missing", MINID, true), MAXID);
+        CacheStats s = cache.stats();
+#ifdef CACHE_NO_STATS
+        return s.m_inserts == 0 && s.m_liveEntries == 999;
+#endif
+        bool result = s.m_inserts == 1000 && s.m_failedInserts == 2 && s.m_hits == (unsigned)hits &&
+                      s.m_misses == 1 && s.m_removes == 1 && s.m_failedRemoves == 1 &&
+                      s.m_updates == 1 && s.m_failedUpdates == 1 && s.m_liveEntries == 999;
+        // One histogram sample per operation, only the invalid ID was rejected without probing
+        unsigned long long samples[STATOPS] = {0, 0, 0, 0};
+        for (int op = 0; op < STATOPS; op++) {
+            for (int b = 0; b < PROBEBUCKETS; b++) {
+                samples[op] += s.m_probes[op][b];
+            }
+        }
+        result = result && samples[STAT_GET] == s.m_hits + s.m_misses && samples[STAT_INSERT] == 1002 &&
+                 samples[STAT_REMOVE] == 2 && samples[STAT_UPDATE] == 2 && s.m_probes[STAT_INSERT][0] == 1 &&
+                 s.m_probeSum[STAT_INSERT] >= 1001;
+        // Growing from MINPRIME to 1000 entries takes several rehashes
+        result = result && s.m_rehashes >= 3 && s.m_transferSteps >= 4 * (s.m_rehashes - 1);
+        result = result && (s.m_migrating == false || s.m_transferIndex < s.m_oldCap) &&
+                 s.migrationProgress() >= 0.0 && s.migrationProgress() <= 1.0;
+        string text = s.toPrometheus("test");
+        result = result && text.find("test_ops_total{op=\"insert\",result=\"ok\"} 1000\n") != string::npos &&
+                 text.find("test_probe_length_count{op=\"insert\"} 1002\n") != string::npos &&
+                 text.find("# TYPE test_probe_length histogram\n") != string::npos;
+        cache.resetStats();
+        return result && cache.stats().m_inserts == 0 && cache.stats().m_liveEntries == 999;
+    }
+
+    // testMemoryUsage: Test that memoryUsage() counts both table arrays while a migration runs,
+    // one node per entry, key buffers only for long keys and deleted nodes as tombstones
+    bool testMemoryUsage() {
+        Cache c(MINPRIME, hashCode, DOUBLEHASH);
+        int inserted = 0;
+        while (c.m_oldTable == nullptr) {
+            c.insert(Person("mem" + to_string(inserted), MINID + inserted, true));
+            inserted++;
+        }
+        CacheMemory during = c.memoryUsage();
+        bool result = during.m_tables.m_requested == (c.m_currentCap + c.m_oldCap) * sizeof(Person*) &&
+                      during.m_oldTable.m_requested == c.m_oldCap * sizeof(Person*) &&
+                      during.m_nodes.m_requested == inserted * sizeof(Person) &&
+                      during.m_liveEntries == inserted && during.m_keys.m_blocks == 0 &&
+                      during.overhead() > 0 && during.total() == during.heap() + sizeof(Cache);
+        while (c.advanceMigration()) {
+        }
+        CacheMemory after = c.memoryUsage();
+        result = result && after.m_oldTable.m_blocks == 0 &&
+                 after.m_tables.m_requested == c.m_currentCap * sizeof(Person*) &&
+                 after.m_tables.m_requested < during.m_tables.m_requested &&
+                 after.m_nodes.m_requested == during.m_nodes.m_requested;
+        // A key too long for the string's inline buffer gets its own block
+        string longKey(40, 'k');
+        c.insert(Person(longKey, MINID, true));
+        for (int i = 0; i < 10; i++) {
+            c.remove(Person("mem" + to_string(i), MINID + i, true));
+        }
+        CacheMemory removed = c.memoryUsage();
+        int deleted = c.m_currNumDeleted + (c.m_oldTable != nullptr ? c.m_oldNumDeleted : 0);
+        result = result && removed.m_keys.m_blocks == 1 && removed.m_keys.m_requested >= longKey.size() + 1 &&
+                 removed.m_tombstoneCount == deleted && deleted >= 10 &&
+                 removed.m_tombstones.m_requested == deleted * sizeof(Person) &&
+                 removed.m_liveEntries == c.liveCount();
+        // A TTL entry carries an EntryLinks block, the recency links of a bounded cache do not
+        c.insert(Person("ttl", MINID, true), 60000);
+        CacheMemory withTTL = c.memoryUsage();
+        result = result && withTTL.m_nodes.m_requested == removed.m_nodes.m_requested + sizeof(Person) + sizeof(EntryLinks);
+        Cache bounded(MINPRIME, hashCode, DOUBLEHASH);
+        bounded.setMaxEntries(20, LRU);
+        for (int i = 0; i < 30; i++) {
+            bounded.insert(Person("lru" + to_string(i), MINID + i, true));
+        }
+        return result && bounded.memoryUsage().m_nodes.m_requested == bounded.liveCount() * sizeof(Person);
+    }
+
 };
 
 int main() {
@@ -631,6 +1283,23 @@ int main() {
     cout << (t.testRehashLoadFactor() == true ? "testRehashLoadFactor PASSED" : "testRehashLoadFactor FAILED") << endl;
     cout << (t.testRehashRemoval() == true ? "testRehashRemoval PASSED" : "testRehashRemoval FAILED") << endl;
     cout << (t.testRehashCompletionRemoval() == true ? "testRehashCompletionRemoval PASSED" : "testRehashCompletionRemoval FAILED") << endl;
+    cout << (t.testLRUEvictsLeastRecent() == true ? "testLRUEvictsLeastRecent PASSED" : "testLRUEvictsLeastRecent FAILED") << endl;
+    cout << (t.testLRUAcrossRehash() == true ? "testLRUAcrossRehash PASSED" : "testLRUAcrossRehash FAILED") << endl;
+    cout << (t.testClockSecondChance() == true ? "testClockSecondChance PASSED" : "testClockSecondChance FAILED") << endl;
+    cout << (t.testClockAcrossRehash() == true ? "testClockAcrossRehash PASSED" : "testClockAcrossRehash FAILED") << endl;
+    cout << (t.testAdmissionResistsScan() == true ? "testAdmissionResistsScan PASSED" : "testAdmissionResistsScan FAILED") << endl;
+    cout << (t.testTTLExpiry() == true ? "testTTLExpiry PASSED" : "testTTLExpiry FAILED") << endl;
+    cout << (t.testTTLReinsertAndUpdate() == true ? "testTTLReinsertAndUpdate PASSED" : "testTTLReinsertAndUpdate FAILED") << endl;
+    cout << (t.testNegativeFilterMatchesTable() == true ? "testNegativeFilterMatchesTable PASSED" : "testNegativeFilterMatchesTable FAILED") << endl;
+    cout << (t.testNegativeFilterEnableLate() == true ? "testNegativeFilterEnableLate PASSED" : "testNegativeFilterEnableLate FAILED") << endl;
+    cout << (t.testIDIndexRange() == true ? "testIDIndexRange PASSED" : "testIDIndexRange FAILED") << endl;
+    cout << (t.testKeyGroups() == true ? "testKeyGroups PASSED" : "testKeyGroups FAILED") << endl;
+    cout << (t.testScanAcrossRehash() == true ? "testScanAcrossRehash PASSED" : "testScanAcrossRehash FAILED") << endl;
+    cout << (t.testSnapshotRoundTrip() == true ? "testSnapshotRoundTrip PASSED" : "testSnapshotRoundTrip FAILED") << endl;
+    cout << (t.testSnapshotLargeCache() == true ? "testSnapshotLargeCache PASSED" : "testSnapshotLargeCache FAILED") << endl;
+    cout << (t.testSnapshotAsyncDuringMigration() == true ? "testSnapshotAsyncDuringMigration PASSED" : "testSnapshotAsyncDuringMigration FAILED") << endl;
+    cout << (t.testStatsCounters() == true ? "testStatsCounters PASSED" : "testStatsCounters FAILED") << endl;
+    cout << (t.testMemoryUsage() == true ? "testMemoryUsage PASSED" : "testMemoryUsage FAILED") << endl;
 
     return 0;
 }
\ No newline at end of file
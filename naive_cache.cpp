@@ -160,6 +160,19 @@ const Person NaiveCache::getPerson(string key, int ID) const {
     return Person("", 0, false);
 }
 
+// Update ID operation (same as Cache: the slot depends on the key only, so the entry stays put)
+bool NaiveCache::updateID(Person person, int ID) {
+    if (ID < MINID || ID > MAXID) {
+        return false;
+    }
+    int personIndex = findPersonIndex(person, m_currentTable, m_currentCap, m_currProbing);
+    if (personIndex < 0) {
+        return false;
+    }
+    m_currentTable[personIndex]->setID(ID);
+    return true;
+}
+
 // Calculate load factor
 float NaiveCache::lambda() const {
     return float(m_currentSize) / m_currentCap;
@@ -175,21 +188,24 @@ float NaiveCache::deletedRatio() const {
 
 // Probe index calculation (same as Cache)
 int NaiveCache::probeIndex(int hashedKey, int i, int capacity, prob_t policy) const {
-    int value = 0;
+    // Widen the unsigned hash so the formulas never go negative or overflow
+    unsigned long long key = (unsigned int)hashedKey;
+    unsigned long long step = i;
+    unsigned long long value = 0;
     
     if (policy == LINEAR) {
-        value = (hashedKey + i) % capacity;
+        value = (key + step) % capacity;
     } else if (policy == QUADRATIC) {
-        value = (hashedKey + i * i) % capacity;
+        value = (key + step * step) % capacity;
     } else if (policy == DOUBLEHASH) {
-        int dbValue = 11 - (hashedKey % 11);
+        unsigned long long dbValue = 11 - (key % 11);
         if (dbValue == 0) {
             dbValue = 1;
         }
-        value = (hashedKey + i * dbValue) % capacity;
+        value = (key + step * dbValue) % capacity;
     }
     
-    return value;
+    return (int)value;
 }
 
 // Locate insertion slot
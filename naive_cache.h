@@ -15,6 +15,7 @@ public:
     bool insert(Person person);
     bool remove(Person person);
     const Person getPerson(string key, int ID) const;
+    bool updateID(Person person, int ID);
     
     // Expose for benchmarking
     int getCurrentSize() const { return m_currentSize; }
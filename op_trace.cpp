@@ -0,0 +1,250 @@
+// Operation Trace Implementation
+#include "op_trace.h"
+#include <cstring>
+
+// zigzag: Small negative IDs stay small varints too
+static inline uint64_t zigzag(int value) {
+    return ((uint64_t)(int64_t)value << 1) ^ (uint64_t)((int64_t)value >> 63);
+}
+static inline int unzigzag(uint64_t value) {
+    return (int)(int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/******************************************
+* TraceWriter
+******************************************/
+// Constructor
+TraceWriter::TraceWriter(const std::string& path)
+    : m_out(path.c_str(), std::ios::binary | std::ios::trunc) {
+    m_lastTimeNs = 0;
+    m_count = 0;
+    m_bytes = 0;
+    m_failed = false;
+    m_buffer.reserve(TRACEBUFFER);
+    if (m_out.is_open()) {
+        m_buffer.insert(m_buffer.end(), TRACEMAGIC, TRACEMAGIC + sizeof(TRACEMAGIC));
+    }
+}
+
+// Destructor
+TraceWriter::~TraceWriter() {
+    flush();
+}
+
+// putVarint: Seven bits per byte, low bits first, the top bit marks that more follow
+void TraceWriter::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        m_buffer.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    m_buffer.push_back((char)value);
+}
+
+// append: Encode the record after the buffered ones, write the buffer once it is full
+bool TraceWriter::append(const TraceRecord& record) {
+    if (isOpen() == false || record.m_timeNs < m_lastTimeNs) {
+        return false;
+    }
+    bool sameKey = m_count > 0 && record.m_key == m_lastKey;
+    uint8_t flags = (uint8_t)record.m_op & TRACEOPMASK;
+    flags |= record.m_ok ? TRACEOK : 0;
+    flags |= sameKey ? TRACESAMEKEY : 0;
+    m_buffer.push_back((char)flags);
+    putVarint(record.m_timeNs - m_lastTimeNs);
+    if (sameKey == false) {
+        putVarint(record.m_key.size());
+        m_buffer.insert(m_buffer.end(), record.m_key.begin(), record.m_key.end());
+        m_lastKey = record.m_key;
+    }
+    putVarint(zigzag(record.m_id));
+    if (record.m_op == TRACE_UPDATE) {
+        putVarint(zigzag(record.m_newID));
+    }
+    m_lastTimeNs = record.m_timeNs;
+    m_count++;
+    if (m_buffer.size() >= TRACEBUFFER) {
+        return flush();
+    }
+    return true;
+}
+
+// flush: Hand the buffer to the stream and push it to the file
+bool TraceWriter::flush() {
+    if (m_out.is_open() == false) {
+        return false;
+    }
+    if (m_buffer.empty() == false) {
+        m_out.write(m_buffer.data(), m_buffer.size());
+        m_bytes += m_buffer.size();
+        m_buffer.clear();
+    }
+    m_out.flush();
+    m_failed = m_failed || m_out.fail();
+    return m_failed == false;
+}
+
+/******************************************
+* TraceReader
+******************************************/
+// Constructor: Read the first chunk and check the header
+TraceReader::TraceReader(const std::string& path)
+    : m_in(path.c_str(), std::ios::binary), m_chunk(TRACEBUFFER) {
+    m_pos = 0;
+    m_end = 0;
+    m_lastTimeNs = 0;
+    m_valid = false;
+    m_truncated = false;
+    if (m_in.is_open() == false) {
+        return;
+    }
+    char magic[sizeof(TRACEMAGIC)];
+    for (size_t i = 0; i < sizeof(magic); i++) {
+        uint8_t byte;
+        if (getByte(byte) == false) {
+            return;
+        }
+        magic[i] = (char)byte;
+    }
+    m_valid = memcmp(magic, TRACEMAGIC, sizeof(magic)) == 0;
+}
+
+// getByte: Next byte of the file, refilling the chunk when it runs out
+bool TraceReader::getByte(uint8_t& byte) {
+    if (m_pos == m_end) {
+        m_in.read(m_chunk.data(), m_chunk.size());
+        m_end = (size_t)m_in.gcount();
+        m_pos = 0;
+        if (m_end == 0) {
+            return false;
+        }
+    }
+    byte = (uint8_t)m_chunk[m_pos++];
+    return true;
+}
+
+// getVarint: At most ten bytes, a longer run is treated as a damaged record
+bool TraceReader::getVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+        uint8_t byte;
+        if (getByte(byte) == false) {
+            return false;
+        }
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// next: A clean end of file lies between records, anything else marks the trace truncated
+bool TraceReader::next(TraceRecord& record) {
+    if (m_valid == false || m_truncated) {
+        return false;
+    }
+    uint8_t flags;
+    if (getByte(flags) == false) {
+        return false;
+    }
+    m_truncated = true;
+    int op = flags & TRACEOPMASK;
+    uint64_t delta;
+    if (op < TRACE_GET || op > TRACE_UPDATE || getVarint(delta) == false) {
+        return false;
+    }
+    if ((flags & TRACESAMEKEY) == 0) {
+        uint64_t length;
+        if (getVarint(length) == false || length > TRACEBUFFER * 16) {
+            return false;
+        }
+        m_lastKey.resize(length);
+        for (uint64_t i = 0; i < length; i++) {
+            uint8_t byte;
+            if (getByte(byte) == false) {
+                return false;
+            }
+            m_lastKey[i] = (char)byte;
+        }
+    }
+    uint64_t id;
+    uint64_t newID = 0;
+    if (getVarint(id) == false || (op == TRACE_UPDATE && getVarint(newID) == false)) {
+        return false;
+    }
+    m_truncated = false;
+    m_lastTimeNs += delta;
+    record.m_op = (traceop_t)op;
+    record.m_ok = (flags & TRACEOK) != 0;
+    record.m_key = m_lastKey;
+    record.m_id = unzigzag(id);
+    record.m_newID = unzigzag(newID);
+    record.m_timeNs = m_lastTimeNs;
+    return true;
+}
+
+// readAll: Decode the whole file, a truncated tail is dropped
+bool TraceReader::readAll(const std::string& path, std::vector<TraceRecord>& records) {
+    TraceReader reader(path);
+    if (reader.isOpen() == false) {
+        return false;
+    }
+    TraceRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    return true;
+}
+
+/******************************************
+* TracingCache
+******************************************/
+// Constructor: Trace times count from here
+TracingCache::TracingCache(Cache& cache, TraceWriter& writer)
+    : m_cache(cache), m_writer(writer), m_start(std::chrono::steady_clock::now()) {
+}
+
+// now: ns since the constructor
+unsigned long long TracingCache::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+// record: The operation is stamped with the time it started, which is when a replay issues it
+void TracingCache::record(unsigned long long timeNs, traceop_t op, bool ok, const std::string& key, int id, int newID) {
+    TraceRecord rec;
+    rec.m_op = op;
+    rec.m_ok = ok;
+    rec.m_key = key;
+    rec.m_id = id;
+    rec.m_newID = newID;
+    rec.m_timeNs = timeNs;
+    m_writer.append(rec);
+}
+
+bool TracingCache::insert(Person person) {
+    unsigned long long start = now();
+    bool ok = m_cache.insert(person);
+    record(start, TRACE_INSERT, ok, person.getKey(), person.getID(), 0);
+    return ok;
+}
+
+bool TracingCache::remove(Person person) {
+    unsigned long long start = now();
+    bool ok = m_cache.remove(person);
+    record(start, TRACE_REMOVE, ok, person.getKey(), person.getID(), 0);
+    return ok;
+}
+
+const Person TracingCache::getPerson(std::string key, int ID) {
+    unsigned long long start = now();
+    const Person found = m_cache.getPerson(key, ID);
+    record(start, TRACE_GET, found.getKey() == key && key != "", key, ID, 0);
+    return found;
+}
+
+bool TracingCache::updateID(Person person, int ID) {
+    unsigned long long start = now();
+    bool ok = m_cache.updateID(person, ID);
+    record(start, TRACE_UPDATE, ok, person.getKey(), person.getID(), ID);
+    return ok;
+}
@@ -0,0 +1,129 @@
+// Operation Trace (capture and replay of Cache traffic)
+// A compact binary file of operations: type, result, key, ID and time. TracingCache records
+// everything that goes through it into a TraceWriter; a TraceReader hands the records back
+// in order so a captured stream can be replayed against any cache with the Cache interface
+#ifndef OP_TRACE_H
+#define OP_TRACE_H
+
+#include "cache.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+enum traceop_t {TRACE_GET = 1, TRACE_INSERT = 2, TRACE_REMOVE = 3, TRACE_UPDATE = 4};
+
+const char TRACEMAGIC[8] = {'H', 'C', 'T', 'R', 'A', 'C', 'E', '1'};   // file header, version 1
+const size_t TRACEBUFFER = 1 << 16;     // bytes buffered by the writer and read at a time
+
+// File layout: TRACEMAGIC, then one record after another
+//   flags    1 byte: traceop_t in bits 0-2, TRACEOK, TRACESAMEKEY
+//   time     varint: ns since the previous record (the first: since the trace started)
+//   key      varint length and the bytes, left out with TRACESAMEKEY
+//   ID       zigzag varint
+//   new ID   zigzag varint, TRACE_UPDATE only
+const uint8_t TRACEOPMASK = 7;
+const uint8_t TRACEOK = 8;          // the operation succeeded (a get found its entry)
+const uint8_t TRACESAMEKEY = 16;    // same key as the record before
+
+struct TraceRecord {
+    traceop_t          m_op;
+    bool               m_ok;        // result when it was recorded
+    std::string        m_key;
+    int                m_id;
+    int                m_newID;     // TRACE_UPDATE only
+    unsigned long long m_timeNs;    // since the trace started
+    TraceRecord() : m_op(TRACE_GET), m_ok(false), m_id(0), m_newID(0), m_timeNs(0) {}
+};
+
+class TraceWriter {
+public:
+    // Create (or truncate) the trace file and write the header
+    explicit TraceWriter(const std::string& path);
+    // Writes what is still buffered
+    ~TraceWriter();
+
+    bool isOpen() const { return m_out.is_open() && m_failed == false; }
+    // Encode one record, times must not go backwards
+    bool append(const TraceRecord& record);
+    // Write the buffer to the file
+    bool flush();
+    unsigned long long count() const { return m_count; }
+    // Bytes written so far, header included
+    unsigned long long bytes() const { return m_bytes + m_buffer.size(); }
+
+private:
+    void putVarint(uint64_t value);
+
+    std::ofstream      m_out;
+    std::vector<char>  m_buffer;
+    std::string        m_lastKey;
+    unsigned long long m_lastTimeNs;
+    unsigned long long m_count;
+    unsigned long long m_bytes;     // flushed to the file
+    bool               m_failed;
+};
+
+class TraceReader {
+public:
+    // Open the trace file, isOpen() is false if it is missing or has no valid header
+    explicit TraceReader(const std::string& path);
+
+    bool isOpen() const { return m_valid; }
+    // Decode the next record, false at the end of the file or at a cut-off record
+    bool next(TraceRecord& record);
+    // True if the file ends inside a record (e.g. the recorder was killed)
+    bool truncated() const { return m_truncated; }
+    // Every record of a file, returns false if it cannot be opened
+    static bool readAll(const std::string& path, std::vector<TraceRecord>& records);
+
+private:
+    bool getByte(uint8_t& byte);
+    bool getVarint(uint64_t& value);
+
+    std::ifstream      m_in;
+    std::vector<char>  m_chunk;
+    size_t             m_pos;       // next byte in m_chunk
+    size_t             m_end;       // bytes in m_chunk
+    std::string        m_lastKey;
+    unsigned long long m_lastTimeNs;
+    bool               m_valid;
+    bool               m_truncated;
+};
+
+// Records every operation on a live Cache, the cache is not owned
+// Like Cache itself it is not thread safe, callers that share it serialize around it
+class TracingCache {
+public:
+    TracingCache(Cache& cache, TraceWriter& writer);
+
+    bool insert(Person person);
+    bool remove(Person person);
+    const Person getPerson(std::string key, int ID);
+    bool updateID(Person person, int ID);
+
+private:
+    unsigned long long now() const;
+    void record(unsigned long long timeNs, traceop_t op, bool ok, const std::string& key, int id, int newID);
+
+    Cache&       m_cache;
+    TraceWriter& m_writer;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// applyTraceRecord: Run one record against any cache with the Cache interface (Cache,
+// NaiveCache, the benchmark's std::unordered_map adapter), returns the operation's result
+template <typename CacheType>
+bool applyTraceRecord(CacheType& cache, const TraceRecord& record) {
+    if (record.m_op == TRACE_GET) {
+        return cache.getPerson(record.m_key, record.m_id).getKey() == record.m_key && record.m_key != "";
+    } else if (record.m_op == TRACE_INSERT) {
+        return cache.insert(Person(record.m_key, record.m_id, true));
+    } else if (record.m_op == TRACE_REMOVE) {
+        return cache.remove(Person(record.m_key, record.m_id, true));
+    }
+    return cache.updateID(Person(record.m_key, record.m_id, true), record.m_newID);
+}
+
+#endif // OP_TRACE_H
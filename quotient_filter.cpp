@@ -0,0 +1,194 @@
+// Quotient Filter Implementation
+#include "quotient_filter.h"
+#include "cache_stats.h"
+
+// Constructor
+QuotientFilter::QuotientFilter() {
+    m_mask = 0;
+    m_count = 0;
+    m_saturated = false;
+    resize(QFMINSLOTS);
+}
+
+// resize: A power of two number of slots, at least twice the capacity so runs stay short
+void QuotientFilter::resize(int capacity) {
+    int slots = QFMINSLOTS;
+    while (slots < capacity * 2) {
+        slots *= 2;
+    }
+    m_slots.assign(slots, 0);
+    m_mask = slots - 1;
+    m_count = 0;
+    m_saturated = false;
+}
+
+// clear: Release the table, the filter is rebuilt by the next resize
+void QuotientFilter::clear() {
+    std::vector<uint16_t>().swap(m_slots);
+    m_slots.assign(1, 0);
+    m_mask = 0;
+    m_count = 0;
+    m_saturated = false;
+}
+
+// split: The low bits are the remainder, the bits above them pick the slot
+void QuotientFilter::split(unsigned long long hash, int& quotient, uint16_t& remainder) const {
+    remainder = (uint16_t)(hash & ((1u << QFREMBITS) - 1));
+    quotient = (int)((hash >> QFREMBITS) & m_mask);
+}
+
+// runStart: Walk back to the start of the cluster, then forward one run per occupied slot
+int QuotientFilter::runStart(int quotient) const {
+    int b = quotient;
+    while (m_slots[b] & SHIFTED) {
+        b = prev(b);
+    }
+    int s = b;
+    while (b != quotient) {
+        // Skip the run of b
+        do {
+            s = next(s);
+        } while (m_slots[s] & CONTINUATION);
+        // Next quotient that has a run
+        do {
+            b = next(b);
+        } while ((m_slots[b] & OCCUPIED) == 0);
+    }
+    return s;
+}
+
+// mayContain: Look for the remainder in the run of its quotient
+bool QuotientFilter::mayContain(unsigned long long hash) const {
+    if (m_saturated == true) {
+        return true;
+    }
+    int quotient = 0;
+    uint16_t remainder = 0;
+    split(hash, quotient, remainder);
+    if ((m_slots[quotient] & OCCUPIED) == 0) {
+        return false;
+    }
+    int s = runStart(quotient);
+    do {
+        if (remainderAt(s) == remainder) {
+            return true;
+        }
+        s = next(s);
+    } while (m_slots[s] & CONTINUATION);
+    return false;
+}
+
+// insert: Append the remainder to its run and shift the rest of the cluster right by one slot
+void QuotientFilter::insert(unsigned long long hash) {
+    if (m_saturated == true) {
+        return;
+    }
+    // Runs get long close to full, stop filtering instead
+    if (m_count >= m_mask - (m_mask >> 3)) {
+        m_saturated = true;
+        return;
+    }
+    int quotient = 0;
+    uint16_t remainder = 0;
+    split(hash, quotient, remainder);
+    m_count++;
+    // The home slot is free
+    if (isEmpty(quotient)) {
+        m_slots[quotient] = (uint16_t)((remainder << 3) | OCCUPIED);
+        return;
+    }
+    bool hadRun = (m_slots[quotient] & OCCUPIED) != 0;
+    m_slots[quotient] |= OCCUPIED;
+    int pos = runStart(quotient);
+    uint16_t entry = (uint16_t)(remainder << 3);
+    if (hadRun == true) {
+        // Go to the end of the existing run
+        do {
+            pos = next(pos);
+        } while (m_slots[pos] & CONTINUATION);
+        entry |= CONTINUATION;
+    }
+    if (pos != quotient) {
+        entry |= SHIFTED;
+    }
+    // Shift everything up to the next empty slot, occupied bits stay with their slots
+    while (isEmpty(pos) == false) {
+        uint16_t moving = m_slots[pos];
+        m_slots[pos] = (uint16_t)((m_slots[pos] & OCCUPIED) | (entry & ~OCCUPIED));
+        entry = (uint16_t)((moving & ~OCCUPIED) | SHIFTED);
+        pos = next(pos);
+    }
+    m_slots[pos] = (uint16_t)((m_slots[pos] & OCCUPIED) | (entry & ~OCCUPIED));
+}
+
+// remove: Take one copy of the remainder out of its run and shift the rest of the cluster left
+void QuotientFilter::remove(unsigned long long hash) {
+    if (m_saturated == true) {
+        return;
+    }
+    int quotient = 0;
+    uint16_t remainder = 0;
+    split(hash, quotient, remainder);
+    if ((m_slots[quotient] & OCCUPIED) == 0) {
+        return;
+    }
+    int start = runStart(quotient);
+    int pos = start;
+    while (remainderAt(pos) != remainder) {
+        pos = next(pos);
+        if ((m_slots[pos] & CONTINUATION) == 0) {
+            // Not in the run
+            return;
+        }
+    }
+    m_count--;
+    bool promote = false;
+    if (pos == start) {
+        if (m_slots[next(pos)] & CONTINUATION) {
+            // The second entry of the run becomes its start
+            promote = true;
+        } else {
+            // It was the only entry, the quotient has no run any more
+            m_slots[quotient] &= ~OCCUPIED;
+        }
+    }
+    // Quotient owning the run being shifted, the runs after it belong to later occupied slots
+    int owner = quotient;
+    int cur = pos;
+    int nxt = next(cur);
+    while (isEmpty(nxt) == false && (m_slots[nxt] & SHIFTED) != 0) {
+        uint16_t moving = (uint16_t)(m_slots[nxt] & ~OCCUPIED);
+        if (promote == true) {
+            moving &= ~CONTINUATION;
+            promote = false;
+        } else if ((moving & CONTINUATION) == 0) {
+            do {
+                owner = next(owner);
+            } while ((m_slots[owner] & OCCUPIED) == 0);
+        }
+        // A run start that reaches its home slot is no longer shifted
+        moving &= ~SHIFTED;
+        if ((moving & CONTINUATION) != 0 || cur != owner) {
+            moving |= SHIFTED;
+        }
+        m_slots[cur] = (uint16_t)((m_slots[cur] & OCCUPIED) | moving);
+        cur = nxt;
+        nxt = next(cur);
+    }
+    m_slots[cur] &= OCCUPIED;
+}
+
+// swap: Exchange the contents of two filters
+void QuotientFilter::swap(QuotientFilter& other) {
+    m_slots.swap(other.m_slots);
+    std::swap(m_mask, other.m_mask);
+    std::swap(m_count, other.m_count);
+    std::swap(m_saturated, other.m_saturated);
+}
+
+// memoryUsage: One block, the vector's capacity
+void QuotientFilter::memoryUsage(HeapBytes& bytes) const {
+    if (m_slots.capacity() > 0) {
+        bytes.addBlock(m_slots.data(), m_slots.capacity() * sizeof(uint16_t));
+    }
+}
@@ -0,0 +1,58 @@
+// Quotient Filter for negative lookups
+// A compact approximate set of fingerprints that supports deletes: "no" is always
+// right, "maybe" is wrong with probability about load * 2^-QFREMBITS
+#ifndef QUOTIENT_FILTER_H
+#define QUOTIENT_FILTER_H
+
+#include <vector>
+#include <stdint.h>
+#include <utility>
+
+struct HeapBytes;   // cache_stats.h
+
+const int QFREMBITS = 13;       // remainder bits per slot, the other 3 bits of a slot are metadata
+const int QFMINSLOTS = 64;      // smallest table
+
+class QuotientFilter {
+public:
+    QuotientFilter();
+    // Size the filter for up to capacity fingerprints and clear it
+    void resize(int capacity);
+    // Drop all fingerprints and release the table
+    void clear();
+    // Add one fingerprint, duplicates are kept as separate copies
+    void insert(unsigned long long hash);
+    // Remove one copy of a fingerprint that was inserted before
+    void remove(unsigned long long hash);
+    // False means no fingerprint with this hash was ever inserted (or all were removed)
+    bool mayContain(unsigned long long hash) const;
+    int size() const { return m_count; }
+    // A full filter stops filtering and answers "maybe" until the next resize
+    bool saturated() const { return m_saturated; }
+    void swap(QuotientFilter& other);
+    // Add the slot array to bytes
+    void memoryUsage(HeapBytes& bytes) const;
+
+private:
+    // Slot metadata, stored in the low bits of every slot
+    static const uint16_t OCCUPIED = 1;     // some fingerprint has this slot as its quotient
+    static const uint16_t CONTINUATION = 2; // the slot continues the run of the slot before it
+    static const uint16_t SHIFTED = 4;      // the remainder is not in its quotient's slot
+    static const uint16_t METAMASK = 7;
+
+    int next(int i) const { return (i + 1) & m_mask; }
+    int prev(int i) const { return (i - 1) & m_mask; }
+    bool isEmpty(int i) const { return (m_slots[i] & METAMASK) == 0; }
+    uint16_t remainderAt(int i) const { return m_slots[i] >> 3; }
+    // Split a hash into its slot and its remainder
+    void split(unsigned long long hash, int& quotient, uint16_t& remainder) const;
+    // First slot of the run of an occupied quotient
+    int runStart(int quotient) const;
+
+    std::vector<uint16_t> m_slots;
+    int  m_mask;        // number of slots - 1 (a power of two)
+    int  m_count;       // fingerprints stored
+    bool m_saturated;   // an insert found the table full
+};
+
+#endif // QUOTIENT_FILTER_H
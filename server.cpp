@@ -0,0 +1,41 @@
+// Cache server binary
+// Usage: ./server [port] [unix-socket-path]
+// Serves one Cache on 127.0.0.1:port (default 6380) and optionally on a Unix socket
+#include "cache_server.h"
+#include <csignal>
+#include <cstdlib>
+
+static CacheServer* runningServer = nullptr;
+
+// onSignal: stop only writes to an eventfd, which is safe in a signal handler
+static void onSignal(int) {
+    if (runningServer != nullptr) {
+        runningServer->stop();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int port = (argc > 1) ? atoi(argv[1]) : 6380;
+    Cache cache(MINPRIME, HASH_WY, DOUBLEHASH);
+    CacheServer server(cache);
+    if (server.listenTCP(port) == false) {
+        cerr << "Cannot listen on port " << port << endl;
+        return 1;
+    }
+    if (argc > 2 && server.listenUnix(argv[2]) == false) {
+        cerr << "Cannot listen on " << argv[2] << endl;
+        return 1;
+    }
+    runningServer = &server;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    cout << "Serving on 127.0.0.1:" << server.getPort();
+    if (argc > 2) {
+        cout << " and " << argv[2];
+    }
+    cout << endl;
+    bool ok = server.run();
+    runningServer = nullptr;
+    cout << "Stopped with " << cache.liveCount() << " entries" << endl;
+    return ok ? 0 : 1;
+}
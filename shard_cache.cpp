@@ -0,0 +1,205 @@
+// Shard-Per-Core Cache Implementation
+#include "shard_cache.h"
+#include <memory>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Constructor: starts one owner thread per shard
+ShardedCache::ShardedCache(int numShards, int sizePerShard, hash_fn hash, prob_t probing, bool pinThreads)
+    : m_stop(false) {
+    if (numShards <= 0) {
+        numShards = std::thread::hardware_concurrency();
+        if (numShards <= 0) numShards = 1;
+    }
+    m_numShards = numShards;
+    m_sizePerShard = sizePerShard;
+    m_hash = hash;
+    m_probing = probing;
+    m_pinThreads = pinThreads;
+    for (int i = 0; i < m_numShards; i++) {
+        Shard* shard = new Shard();
+        shard->m_cache = nullptr;
+        m_shards.push_back(shard);
+    }
+    for (int i = 0; i < m_numShards; i++) {
+        m_shards[i]->m_thread = std::thread(&ShardedCache::run, this, i);
+    }
+}
+
+// Destructor: shard threads drain their rings and exit
+ShardedCache::~ShardedCache() {
+    m_stop.store(true, std::memory_order_release);
+    for (int i = 0; i < m_numShards; i++) {
+        m_shards[i]->m_thread.join();
+        delete m_shards[i];
+        m_shards[i] = nullptr;
+    }
+}
+
+// shardFor: Mix the hash before reducing it so shard choice and slot choice
+// inside the shard's table do not use the same bits
+int ShardedCache::shardFor(const string& key) const {
+    unsigned int mixed = m_hash(key) * 2654435761u;
+    return (mixed >> 16) % m_numShards;
+}
+
+// run: Owner loop of one shard
+void ShardedCache::run(int index) {
+#ifdef __linux__
+    if (m_pinThreads) {
+        int cores = std::thread::hardware_concurrency();
+        if (cores > 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(index % cores, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+    }
+#endif
+    Shard* shard = m_shards[index];
+    // Allocate the table on the owning core
+    shard->m_cache = new Cache(m_sizePerShard, m_hash, m_probing);
+    int idle = 0;
+    while (true) {
+        ShardTask* task = nullptr;
+        if (shard->m_ring.pop(task)) {
+            idle = 0;
+            task->m_results.resize(task->m_ops.size());
+            for (unsigned int i = 0; i < task->m_ops.size(); i++) {
+                task->m_results[i] = apply(*shard->m_cache, task->m_ops[i]);
+            }
+            task->m_done(task);
+            delete task;
+        } else if (m_stop.load(std::memory_order_acquire)) {
+            // Ring is empty and no more work will come
+            break;
+        } else if (++idle < 64) {
+            std::this_thread::yield();
+        } else {
+            // Back off so an idle shard does not burn its core
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    delete shard->m_cache;
+    shard->m_cache = nullptr;
+}
+
+// send: Push into the shard's ring, waiting for space if it is full
+void ShardedCache::send(int index, ShardTask* task) {
+    while (!m_shards[index]->m_ring.push(task)) {
+        std::this_thread::yield();
+    }
+}
+
+// apply: Run one operation, only called on the owning shard thread
+ShardResult ShardedCache::apply(Cache& cache, const ShardOp& op) {
+    ShardResult result;
+    if (op.m_op == SHARD_INSERT) {
+        result.m_ok = cache.insert(op.m_person);
+    } else if (op.m_op == SHARD_REMOVE) {
+        result.m_ok = cache.remove(op.m_person);
+    } else if (op.m_op == SHARD_UPDATE) {
+        result.m_ok = cache.updateID(op.m_person, op.m_newID);
+    } else if (op.m_op == SHARD_GET) {
+        result.m_person = cache.getPerson(op.m_person.getKey(), op.m_person.getID());
+        result.m_ok = !result.m_person.getKey().empty();
+    }
+    return result;
+}
+
+// submit: Send a single operation, callback gets the result on the shard thread
+void ShardedCache::submit(const ShardOp& op, std::function<void(const ShardResult&)> callback) {
+    ShardTask* task = new ShardTask();
+    task->m_ops.push_back(op);
+    task->m_done = [callback](ShardTask* done) {
+        callback(done->m_results[0]);
+    };
+    send(shardFor(op.m_person.getKey()), task);
+}
+
+// insert: Future resolves to the result of Cache::insert
+std::future<bool> ShardedCache::insert(Person person) {
+    std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>());
+    submit(ShardOp(SHARD_INSERT, person), [promise](const ShardResult& result) {
+        promise->set_value(result.m_ok);
+    });
+    return promise->get_future();
+}
+
+// remove: Future resolves to the result of Cache::remove
+std::future<bool> ShardedCache::remove(Person person) {
+    std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>());
+    submit(ShardOp(SHARD_REMOVE, person), [promise](const ShardResult& result) {
+        promise->set_value(result.m_ok);
+    });
+    return promise->get_future();
+}
+
+// updateID: Future resolves to the result of Cache::updateID
+std::future<bool> ShardedCache::updateID(Person person, int ID) {
+    std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>());
+    submit(ShardOp(SHARD_UPDATE, person, ID), [promise](const ShardResult& result) {
+        promise->set_value(result.m_ok);
+    });
+    return promise->get_future();
+}
+
+// getPerson: Future resolves to the found person, or an empty person on a miss
+std::future<Person> ShardedCache::getPerson(string key, int ID) {
+    std::shared_ptr<std::promise<Person> > promise(new std::promise<Person>());
+    submit(ShardOp(SHARD_GET, Person(key, ID, true)), [promise](const ShardResult& result) {
+        promise->set_value(result.m_person);
+    });
+    return promise->get_future();
+}
+
+// submitBatch: One ring message per shard instead of one per operation
+std::future<std::vector<ShardResult> > ShardedCache::submitBatch(const std::vector<ShardOp>& ops) {
+    // Shared between all per-shard tasks, the last one to finish fulfills the promise
+    struct BatchState {
+        std::vector<ShardResult> m_results;
+        std::atomic<int> m_pending;
+        std::promise<std::vector<ShardResult> > m_promise;
+    };
+    std::shared_ptr<BatchState> state(new BatchState());
+    state->m_results.resize(ops.size());
+
+    // Group the operations by owning shard, remembering their original position
+    std::vector<ShardTask*> tasks(m_numShards, nullptr);
+    std::vector<std::shared_ptr<std::vector<int> > > positions(m_numShards);
+    for (unsigned int i = 0; i < ops.size(); i++) {
+        int index = shardFor(ops[i].m_person.getKey());
+        if (tasks[index] == nullptr) {
+            tasks[index] = new ShardTask();
+            positions[index].reset(new std::vector<int>());
+        }
+        tasks[index]->m_ops.push_back(ops[i]);
+        positions[index]->push_back(i);
+    }
+    int used = 0;
+    for (int s = 0; s < m_numShards; s++) {
+        if (tasks[s] != nullptr) used++;
+    }
+    std::future<std::vector<ShardResult> > result = state->m_promise.get_future();
+    if (used == 0) {
+        state->m_promise.set_value(state->m_results);
+        return result;
+    }
+    state->m_pending.store(used);
+    for (int s = 0; s < m_numShards; s++) {
+        if (tasks[s] == nullptr) continue;
+        std::shared_ptr<std::vector<int> > where = positions[s];
+        tasks[s]->m_done = [state, where](ShardTask* done) {
+            for (unsigned int i = 0; i < where->size(); i++) {
+                state->m_results[(*where)[i]] = done->m_results[i];
+            }
+            if (state->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                state->m_promise.set_value(state->m_results);
+            }
+        };
+        send(s, tasks[s]);
+    }
+    return result;
+}
@@ -0,0 +1,146 @@
+// Shard-Per-Core Cache (actor mode)
+// Every shard thread owns one Cache exclusively; other threads never touch the
+// table and talk to the owner through a lock-free ring of requests
+#ifndef SHARD_CACHE_H
+#define SHARD_CACHE_H
+
+#include "cache.h"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+const int SHARDRINGSIZE = 1024; // ring slots per shard, must be a power of two
+
+enum shard_op_t {SHARD_INSERT, SHARD_REMOVE, SHARD_UPDATE, SHARD_GET}; // request types
+
+// One operation sent to a shard
+struct ShardOp {
+    shard_op_t m_op;
+    Person     m_person;    // operand (key and ID)
+    int        m_newID;     // new ID for SHARD_UPDATE
+    ShardOp(shard_op_t op = SHARD_GET, Person person = Person(), int newID = 0)
+        : m_op(op), m_person(person), m_newID(newID) {}
+};
+
+// Result of one operation
+struct ShardResult {
+    bool       m_ok;        // result of insert/remove/update, true on a get hit
+    Person     m_person;    // result of get
+    ShardResult() : m_ok(false) {}
+};
+
+// A message in a shard's ring: one or more operations plus a completion
+// m_done runs on the shard thread once all operations are applied
+struct ShardTask {
+    std::vector<ShardOp>     m_ops;
+    std::vector<ShardResult> m_results;
+    std::function<void(ShardTask*)> m_done;
+};
+
+// Bounded multi-producer single-consumer ring (sequence-numbered slots)
+// Producers claim a slot with one CAS, the consumer never writes shared counters
+// other threads contend on, so a single producer degenerates to an SPSC ring
+template <typename T>
+class MpscRing {
+public:
+    MpscRing() : m_head(0), m_tail(0) {
+        for (int i = 0; i < SHARDRINGSIZE; i++) {
+            m_cells[i].m_seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    // push: Returns false if the ring is full
+    bool push(const T& value) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[pos & (SHARDRINGSIZE - 1)];
+            size_t seq = cell.m_seq.load(std::memory_order_acquire);
+            long diff = (long)seq - (long)pos;
+            if (diff == 0) {
+                // Slot is free for this position, try to claim it
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.m_value = value;
+                    cell.m_seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Consumer has not freed this slot yet
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    // pop: Only the owning shard thread calls this, returns false if empty
+    bool pop(T& value) {
+        Cell& cell = m_cells[m_head & (SHARDRINGSIZE - 1)];
+        size_t seq = cell.m_seq.load(std::memory_order_acquire);
+        if ((long)seq - (long)(m_head + 1) < 0) {
+            return false;
+        }
+        value = cell.m_value;
+        cell.m_seq.store(m_head + SHARDRINGSIZE, std::memory_order_release);
+        m_head++;
+        return true;
+    }
+private:
+    struct Cell {
+        std::atomic<size_t> m_seq;
+        T m_value;
+    };
+    Cell m_cells[SHARDRINGSIZE];
+    // padding keeps the consumer and producer positions on separate cache lines
+    char m_pad1[64];
+    size_t m_head;                  // consumer position (owner only)
+    char m_pad2[64];
+    std::atomic<size_t> m_tail;     // producer position
+};
+
+class ShardedCache {
+public:
+    // numShards of 0 means one shard per hardware thread
+    // pinThreads binds shard i to core i (mod core count) where supported
+    ShardedCache(int numShards, int sizePerShard, hash_fn hash, prob_t probing = DEFPOLCY, bool pinThreads = true);
+    ~ShardedCache();
+
+    // Future-based interface
+    std::future<bool> insert(Person person);
+    std::future<bool> remove(Person person);
+    std::future<bool> updateID(Person person, int ID);
+    std::future<Person> getPerson(string key, int ID);
+
+    // Callback-based interface, the callback runs on the shard thread
+    void submit(const ShardOp& op, std::function<void(const ShardResult&)> callback);
+
+    // Batched interface: ops are grouped into one message per shard,
+    // results come back in the same order as ops
+    std::future<std::vector<ShardResult> > submitBatch(const std::vector<ShardOp>& ops);
+
+    int numShards() const { return m_numShards; }
+    // Which shard owns this key
+    int shardFor(const string& key) const;
+
+private:
+    struct Shard {
+        MpscRing<ShardTask*> m_ring;
+        std::thread          m_thread;
+        Cache*               m_cache;   // created, used and deleted only by m_thread
+    };
+    // Shard thread main loop
+    void run(int index);
+    // Push a task into the shard's ring, waits while the ring is full
+    void send(int index, ShardTask* task);
+    // Run one operation against a shard's table
+    static ShardResult apply(Cache& cache, const ShardOp& op);
+
+    int                 m_numShards;
+    int                 m_sizePerShard;
+    hash_fn             m_hash;
+    prob_t              m_probing;
+    bool                m_pinThreads;
+    std::vector<Shard*> m_shards;
+    std::atomic<bool>   m_stop;
+};
+
+#endif // SHARD_CACHE_H
@@ -0,0 +1,166 @@
+// Test program to verify CombiningCache works correctly under concurrency
+#include "combining_cache.h"
+#include "benchmark_utils.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+
+// Hash function (same as driver.cpp)
+unsigned int hashCode(const string str) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * thirtyThree + str[i];
+    return val;
+}
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing CombiningCache Implementation" << endl;
+    cout << "========================================\n" << endl;
+
+    const int NUM_THREADS = 8;
+    const int PER_THREAD = 500;
+    CombiningCache cache(MINPRIME, hashCode, DOUBLEHASH);
+
+    // Every thread owns a disjoint set of IDs so every insert must succeed
+    vector<vector<Person> > data(NUM_THREADS);
+    for (int t = 0; t < NUM_THREADS; t++) {
+        for (int i = 0; i < PER_THREAD; i++) {
+            data[t].push_back(Person("key" + to_string(i % 16), MINID + t * PER_THREAD + i, true));
+        }
+    }
+
+    // Test 1: Concurrent insertion
+    cout << "TEST 1: Concurrent Insertion" << endl;
+    cout << "----------------------------" << endl;
+    vector<int> failures(NUM_THREADS, 0);
+    vector<thread> workers;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        workers.push_back(thread([t, &cache, &data, &failures]() {
+            for (unsigned int i = 0; i < data[t].size(); i++) {
+                if (!cache.insert(data[t][i])) failures[t]++;
+            }
+        }));
+    }
+    for (int t = 0; t < NUM_THREADS; t++) workers[t].join();
+    workers.clear();
+    for (int t = 0; t < NUM_THREADS; t++) {
+        if (failures[t] != 0) {
+            cout << "✗ Thread " << t << " failed " << failures[t] << " inserts!" << endl;
+            return 1;
+        }
+    }
+    cout << "✓ Inserted " << NUM_THREADS * PER_THREAD << " persons from " << NUM_THREADS << " threads" << endl;
+    cout << "  Combining rounds: " << cache.getCombineRounds() << endl;
+
+    // Test 2: Concurrent removal of every other person while reading the rest
+    cout << "\nTEST 2: Concurrent Removal And Retrieval" << endl;
+    cout << "----------------------------------------" << endl;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        workers.push_back(thread([t, &cache, &data, &failures]() {
+            for (unsigned int i = 0; i < data[t].size(); i++) {
+                if (i % 2 == 0) {
+                    if (!cache.remove(data[t][i])) failures[t]++;
+                } else {
+                    Person found = cache.getPerson(data[t][i].getKey(), data[t][i].getID());
+                    if (!(found == data[t][i])) failures[t]++;
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < NUM_THREADS; t++) workers[t].join();
+    for (int t = 0; t < NUM_THREADS; t++) {
+        if (failures[t] != 0) {
+            cout << "✗ Thread " << t << " had " << failures[t] << " wrong results!" << endl;
+            return 1;
+        }
+    }
+    cout << "✓ Removals and lookups were all correct" << endl;
+
+    // Test 3: Final state
+    cout << "\nTEST 3: Final State" << endl;
+    cout << "-------------------" << endl;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        for (unsigned int i = 0; i < data[t].size(); i++) {
+            Person found = cache.getPerson(data[t][i].getKey(), data[t][i].getID());
+            bool expected = (i % 2 == 1);
+            if ((found.getKey() != "") != expected) {
+                cout << "✗ Wrong final state for " << data[t][i].getKey() << endl;
+                return 1;
+            }
+        }
+    }
+    cout << "✓ Final state matches" << endl;
+
+    // Test 4: Threads give their slot back when they exit, so a process that keeps
+    // creating short-lived threads stays on the combining path
+    cout << "\nTEST 4: Short-Lived Threads" << endl;
+    cout << "---------------------------" << endl;
+    {
+        CombiningCache fresh(MINPRIME, hashCode, DOUBLEHASH);
+        const int GENERATIONS = 3 * MAXCOMBTHREADS;
+        for (int g = 0; g < GENERATIONS; g += NUM_THREADS) {
+            for (int t = 0; t < NUM_THREADS; t++) {
+                workers[t] = thread([g, t, &fresh]() {
+                    fresh.insert(Person("short" + to_string(g + t), MINID + g + t, true));
+                    fresh.getPerson("short" + to_string(g + t), MINID + g + t);
+                });
+            }
+            for (int t = 0; t < NUM_THREADS; t++) workers[t].join();
+        }
+        int combined = fresh.getCombinedOps();
+        if (fresh.getDirectOps() != 0 || combined != 2 * GENERATIONS) {
+            cout << "✗ " << fresh.getDirectOps() << " of " << 2 * GENERATIONS
+                 << " requests by short-lived threads bypassed the combiner!" << endl;
+            return 1;
+        }
+        cout << "✓ " << GENERATIONS << " threads, " << combined << " requests, all through the combiner" << endl;
+
+        // With every slot held, one more thread runs directly under the lock and still
+        // gets correct results; once the holders exit the combiner takes it back
+        atomic<int> holding(0);
+        atomic<bool> release(false);
+        vector<thread> holders;
+        for (int t = 0; t < MAXCOMBTHREADS; t++) {
+            holders.push_back(thread([t, &fresh, &holding, &release]() {
+                fresh.getPerson("short" + to_string(t), MINID + t);
+                holding++;
+                while (release.load() == false) {
+                    this_thread::yield();
+                }
+            }));
+        }
+        while (holding.load() < MAXCOMBTHREADS) {
+            this_thread::yield();
+        }
+        bool directOK = false;
+        thread extra([&fresh, &directOK]() {
+            directOK = fresh.insert(Person("extra", MINID, true)) &&
+                       fresh.getPerson("extra", MINID).getKey() == "extra";
+        });
+        extra.join();
+        int direct = fresh.getDirectOps();
+        release = true;
+        for (int t = 0; t < MAXCOMBTHREADS; t++) holders[t].join();
+        combined = fresh.getCombinedOps();
+        thread after([&fresh]() {
+            fresh.remove(Person("extra", MINID, true));
+        });
+        after.join();
+        if (!directOK || direct != 2 || fresh.getCombinedOps() != combined + 1 || fresh.getDirectOps() != 2) {
+            cout << "✗ Overflow thread: correct " << directOK << ", direct requests " << direct
+                 << ", combining did not resume after the holders exited" << endl;
+            return 1;
+        }
+        cout << "✓ A thread beyond " << MAXCOMBTHREADS << " ran directly, later threads combine again" << endl;
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "  All Tests Passed!" << endl;
+    cout << "========================================" << endl;
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Test program to verify the built-in hash functions
+#include "cache.h"
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing Built-in Hash Functions" << endl;
+    cout << "========================================\n" << endl;
+
+    // Test 1: Published check values
+    cout << "TEST 1: Reference Values" << endl;
+    cout << "------------------------" << endl;
+    {
+        // CRC32C check value and the SipHash-2-4 paper's vectors (key 00..0f, message 00..len-1)
+        unsigned char message[15];
+        for (int i = 0; i < 15; i++) {
+            message[i] = (unsigned char)i;
+        }
+        uint64_t k0 = 0x0706050403020100ull;
+        uint64_t k1 = 0x0f0e0d0c0b0a0908ull;
+        bool ok = crc32c("123456789", 9) == 0xE3069283u;
+        ok = ok && sipHash24(message, 0, k0, k1) == 0x726fdb47dd0e0e31ull;
+        ok = ok && sipHash24(message, 15, k0, k1) == 0xa129ca6149be45e5ull;
+        if (!ok) {
+            cout << "✗ CRC32C or SipHash-2-4 does not match the reference values!" << endl;
+            return 1;
+        }
+        cout << "✓ CRC32C (" << (crc32cHardware() ? "SSE4.2" : "table") << ") and SipHash-2-4 match" << endl;
+    }
+
+    // Test 2: Every length path, split CRCs and seeds
+    cout << "\nTEST 2: Lengths and Seeds" << endl;
+    cout << "-------------------------" << endl;
+    {
+        string data;
+        for (int i = 0; i < 200; i++) {
+            data += (char)(i * 37 + 11);
+        }
+        bool ok = true;
+        for (size_t length = 0; length <= data.size() && ok; length++) {
+            // Changing the last byte must change the hash, whichever branch the length takes
+            string changed = data.substr(0, length);
+            if (length > 0) {
+                changed[length - 1] ^= 0x01;
+                ok = wyHash64(data.data(), length) != wyHash64(changed.data(), length);
+            }
+            ok = ok && wyHash64(data.data(), length, 1) != wyHash64(data.data(), length, 2);
+            ok = ok && crc32c(data.data() + length, data.size() - length, crc32c(data.data(), length)) ==
+                       crc32c(data.data(), data.size());
+        }
+        if (!ok) {
+            cout << "✗ A length or seed is ignored!" << endl;
+            return 1;
+        }
+        cout << "✓ 0 to 200 byte inputs hash differently per byte and per seed" << endl;
+    }
+
+    // Test 3: The SipHash key changes the hash
+    cout << "\nTEST 3: SipHash Key" << endl;
+    cout << "-------------------" << endl;
+    {
+        setSipHashKey(1, 2);
+        unsigned int first = sipHashCode("attacker-chosen");
+        setSipHashKey(3, 4);
+        unsigned int second = sipHashCode("attacker-chosen");
+        setSipHashKey(1, 2);
+        if (first == second || sipHashCode("attacker-chosen") != first) {
+            cout << "✗ sipHashCode does not depend on the key!" << endl;
+            return 1;
+        }
+        cout << "✓ Same key, same hash; new key, new hash" << endl;
+    }
+
+    // Test 4: Caches built with each hash, short keys take fewer probes than the old hash
+    cout << "\nTEST 4: Cache Construction" << endl;
+    cout << "--------------------------" << endl;
+    {
+        const int TOTAL = 5000;
+        double legacyProbes = 0;
+        hashkind_t kinds[] = {HASH_LEGACY, HASH_WY, HASH_CRC32C, HASH_SIP};
+        for (hashkind_t kind : kinds) {
+            Cache cache(MAXPRIME, kind, DOUBLEHASH);
+            for (int i = 0; i < TOTAL; i++) {
+                cache.insert(Person("k" + to_string(i), MINID + i, true));
+            }
+            cache.resetStats();
+            int found = 0;
+            for (int i = 0; i < TOTAL; i++) {
+                found += cache.getPerson("k" + to_string(i), MINID + i).getID() == MINID + i ? 1 : 0;
+            }
+            double probes = double(cache.stats().m_probeSum[STAT_GET]) / TOTAL;
+            if (found != TOTAL || (kind != HASH_LEGACY && probes >= legacyProbes)) {
+                cout << "✗ " << hashName(kind) << ": " << found << " of " << TOTAL
+                     << " found, " << probes << " probes per lookup" << endl;
+                return 1;
+            }
+            if (kind == HASH_LEGACY) {
+                legacyProbes = probes;
+            }
+            cout << "✓ " << hashName(kind) << ": " << probes << " probes per lookup" << endl;
+        }
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "  All hash function tests passed!" << endl;
+    cout << "========================================" << endl;
+    return 0;
+}
@@ -0,0 +1,270 @@
+// Test program to verify MappedCache keeps its table across reopening the file
+#include "mapped_cache.h"
+#include <iostream>
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Hash function (same as driver.cpp)
+unsigned int hashCode(const string str) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * thirtyThree + str[i];
+    return val;
+}
+
+// A different hash function, a file written with hashCode must not be reused with it
+unsigned int otherHash(const string str) {
+    unsigned int val = 5381;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * 31 + str[i];
+    return val;
+}
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing MappedCache Implementation" << endl;
+    cout << "========================================\n" << endl;
+
+    const char* path = "test_mapped.bin";
+    const int TOTAL = 5000;
+    std::remove(path);
+
+    // Test 1: Insert through several rehashes, remove some
+    cout << "TEST 1: Insert And Remove" << endl;
+    cout << "-------------------------" << endl;
+    {
+        MappedCache cache(path, MINPRIME, hashCode, DOUBLEHASH);
+        if (!cache.isOpen() || cache.reopened()) {
+            cout << "✗ Could not create a fresh mapped file!" << endl;
+            return 1;
+        }
+        for (int i = 0; i < TOTAL; i++) {
+            if (!cache.insert(Person("key" + to_string(i % 16), MINID + i, true))) {
+                cout << "✗ Insert " << i << " failed!" << endl;
+                return 1;
+            }
+        }
+        for (int i = 0; i < TOTAL; i += 2) {
+            cache.remove(Person("key" + to_string(i % 16), MINID + i, true));
+        }
+        // Leave a migration running, the next process picks it up
+        while (cache.lambda() <= 0.5 && cache.liveCount() < 20000) {
+            int n = cache.liveCount() + TOTAL;
+            cache.insert(Person("more", MINID + n, true));
+        }
+        if (cache.insert(Person(string(MAPKEYMAX + 1, 'x'), MINID, true))) {
+            cout << "✗ A key longer than MAPKEYMAX was accepted!" << endl;
+            return 1;
+        }
+        // A second writer of the same file is turned away while this one has it
+        MappedCache second(path, MINPRIME, hashCode, DOUBLEHASH);
+        if (second.isOpen()) {
+            cout << "✗ A second writer mapped a table that already has one!" << endl;
+            return 1;
+        }
+        cout << "✓ " << cache.liveCount() << " live entries, closing with a migration in progress" << endl;
+        cout << "✓ A second writer of the same file is refused" << endl;
+    }
+
+    // Test 2: Reopen and serve without a load step
+    cout << "\nTEST 2: Reopen" << endl;
+    cout << "--------------" << endl;
+    int live = 0;
+    {
+        MappedCache cache(path, MINPRIME, hashCode, DOUBLEHASH);
+        if (!cache.reopened()) {
+            cout << "✗ The table was not picked up from the file!" << endl;
+            return 1;
+        }
+        for (int i = 0; i < TOTAL; i++) {
+            bool found = cache.getPerson("key" + to_string(i % 16), MINID + i).getKey() != "";
+            if (found != (i % 2 == 1)) {
+                cout << "✗ Entry " << i << " is " << (found ? "present" : "missing") << " after reopening!" << endl;
+                return 1;
+            }
+        }
+        // The migration continues where the previous process left it
+        for (int i = 0; i < 20; i++) {
+            cache.updateID(Person("key" + to_string(1 % 16), MINID + 1 + 2 * i * 16, true), MINID + 1 + 2 * i * 16);
+            cache.insert(Person("after", MAXID - i, true));
+        }
+        live = cache.liveCount();
+        cout << "✓ All entries served right after mapping, " << live << " live entries" << endl;
+    }
+
+    // Test 3: An interrupted operation is repaired on reopening
+    cout << "\nTEST 3: Interrupted Owner" << endl;
+    cout << "-------------------------" << endl;
+    {
+        FILE* f = fopen(path, "r+b");
+        MappedHeader h;
+        if (f == nullptr || fread(&h, sizeof(h), 1, f) != 1) {
+            cout << "✗ Could not read the header!" << endl;
+            return 1;
+        }
+        // Find two live records referenced from the current table
+        const MappedRegion& region = h.m_regions[h.m_current];
+        uint32_t moved = 0;
+        uint32_t reused = 0;
+        MappedEntry movedEntry;
+        for (int i = 0; i < region.m_capacity && reused == 0; i++) {
+            uint32_t ref = 0;
+            MappedEntry e;
+            fseek(f, region.m_offset + (long)i * sizeof(ref), SEEK_SET);
+            if (fread(&ref, sizeof(ref), 1, f) != 1 || ref == 0) {
+                continue;
+            }
+            fseek(f, h.m_arenaOffset + (long)(ref - 1) * sizeof(e), SEEK_SET);
+            if (fread(&e, sizeof(e), 1, f) != 1 || e.m_used == 0) {
+                continue;
+            }
+            if (moved == 0) {
+                // Died in transferPartOfTable: the slot is cleared, the entry not placed yet
+                moved = ref;
+                movedEntry = e;
+                uint32_t empty = 0;
+                fseek(f, region.m_offset + (long)i * sizeof(ref), SEEK_SET);
+                fwrite(&empty, sizeof(empty), 1, f);
+            } else {
+                reused = ref;
+            }
+        }
+        // Died in freeEntry with the counters off and a live record at the head of the free list
+        h.m_seq |= 1;
+        h.m_regions[h.m_current].m_size += 7;
+        h.m_freeHead = reused;
+        fseek(f, 0, SEEK_SET);
+        fwrite(&h, sizeof(h), 1, f);
+        fclose(f);
+        MappedCache cache(path, MINPRIME, hashCode, DOUBLEHASH);
+        string movedKey(movedEntry.m_key, movedEntry.m_keyLength);
+        bool ok = reused != 0 && cache.reopened() && cache.liveCount() == live &&
+                  cache.getPerson(movedKey, movedEntry.m_id).getKey() == movedKey;
+        // New records must come from free records, not from the live one on the old free list
+        for (int i = 0; i < 100 && ok; i++) {
+            ok = cache.insert(Person("recovered", MINID + i, true));
+        }
+        for (int i = 1; i < TOTAL && ok; i += 2) {
+            ok = cache.getPerson("key" + to_string(i % 16), MINID + i).getKey() != "";
+        }
+        if (!ok || cache.liveCount() != live + 100) {
+            cout << "✗ Table not rebuilt: " << cache.liveCount() << " live instead of " << live + 100 << endl;
+            return 1;
+        }
+        cout << "✓ Table and free list rebuilt from the arena, the entry caught mid-transfer is back" << endl;
+    }
+
+    // Test 4: A different hash function starts over
+    cout << "\nTEST 4: Hash Function Check" << endl;
+    cout << "---------------------------" << endl;
+    {
+        MappedCache cache(path, MINPRIME, otherHash, DOUBLEHASH);
+        if (cache.reopened() || cache.liveCount() != 0) {
+            cout << "✗ The table was reused with another hash function!" << endl;
+            return 1;
+        }
+        cout << "✓ Table reformatted for the new hash function" << endl;
+    }
+    std::remove(path);
+
+    // Test 5: Reader processes share one table while the writer rehashes it
+    cout << "\nTEST 5: Shared Memory Readers" << endl;
+    cout << "-----------------------------" << endl;
+    {
+        const string name = "/test_mapped_" + to_string(getpid());
+        const int STABLE = 2000;
+        const int READERS = 4;
+        const int GROW = 40000;
+        const int FINAL = STABLE + GROW - (GROW + 2) / 3;
+        MappedCache writer(name, MINPRIME, hashCode, DOUBLEHASH, BACK_SHM_WRITER);
+        {
+            MappedCache early(name + "_missing", MINPRIME, hashCode, DOUBLEHASH, BACK_SHM_READER);
+            MappedCache second(name, MINPRIME, hashCode, DOUBLEHASH, BACK_SHM_WRITER);
+            if (!writer.isOpen() || early.isOpen() || second.isOpen()) {
+                cout << "✗ Could not create the shared table, attached to a missing one, or opened a second writer!" << endl;
+                MappedCache::unlinkShared(name);
+                return 1;
+            }
+        }
+        for (int i = 0; i < STABLE; i++) {
+            writer.insert(Person("stable" + to_string(i % 8), MINID + i, true));
+        }
+        vector<pid_t> children;
+        for (int r = 0; r < READERS; r++) {
+            pid_t child = fork();
+            if (child == 0) {
+                // Every stable entry must be found at all times, through every generation switch
+                MappedCache reader(name, 0, hashCode, DOUBLEHASH, BACK_SHM_READER);
+                // Keep reading until the writer's last change shows up
+                int misses = 0;
+                bool sawWriter = false;
+                for (int round = 0; round < 100000 && reader.isOpen() && !sawWriter; round++) {
+                    for (int i = r; i < STABLE; i += 37) {
+                        if (reader.getPerson("stable" + to_string(i % 8), MINID + i).getKey() == "") {
+                            misses++;
+                        }
+                    }
+                    sawWriter = reader.liveCount() == FINAL;
+                }
+                bool refused = !reader.insert(Person("reader", MINID, true));
+                _exit(reader.isOpen() && misses == 0 && sawWriter && refused ? 0 : 1);
+            }
+            children.push_back(child);
+        }
+        // Grow through several rehashes while the readers look up
+        for (int i = 0; i < GROW; i++) {
+            writer.insert(Person("grow" + to_string(i), MINID + STABLE + i, true));
+            if (i % 3 == 0) {
+                writer.remove(Person("grow" + to_string(i), MINID + STABLE + i, true));
+            }
+        }
+        int failed = 0;
+        for (int r = 0; r < READERS; r++) {
+            int status = 0;
+            waitpid(children[r], &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed++;
+            }
+        }
+        MappedCache::unlinkShared(name);
+        if (failed != 0) {
+            cout << "✗ " << failed << " reader processes missed entries during the writer's rehashes!" << endl;
+            return 1;
+        }
+        cout << "✓ " << READERS << " reader processes served from one copy across rehashes" << endl;
+    }
+
+    // Test 6: updateID keeps IDs in range, as Cache does
+    cout << "\nTEST 6: Out-Of-Range IDs" << endl;
+    cout << "------------------------" << endl;
+    {
+        {
+            MappedCache cache(path, MINPRIME, hashCode, DOUBLEHASH);
+            cache.insert(Person("ranged", MINID, true));
+            if (cache.updateID(Person("ranged", MINID, true), 5) ||
+                cache.updateID(Person("ranged", MINID, true), MAXID + 1) ||
+                !cache.updateID(Person("ranged", MINID, true), MAXID)) {
+                cout << "✗ updateID accepted an ID out of range or refused a valid one!" << endl;
+                std::remove(path);
+                return 1;
+            }
+        }
+        MappedCache cache(path, MINPRIME, hashCode, DOUBLEHASH);
+        bool kept = cache.reopened() && cache.getPerson("ranged", MAXID).getKey() == "ranged";
+        std::remove(path);
+        if (!kept) {
+            cout << "✗ The entry did not survive reopening!" << endl;
+            return 1;
+        }
+        cout << "✓ IDs outside [MINID, MAXID] are refused, the entry keeps its valid ID" << endl;
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "  All MappedCache tests passed!" << endl;
+    cout << "========================================" << endl;
+    return 0;
+}
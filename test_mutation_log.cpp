@@ -0,0 +1,241 @@
+// Test program to verify the mutation log restores Cache after a restart
+#include "mutation_log.h"
+#include "combining_cache.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Hash function (same as driver.cpp)
+unsigned int hashCode(const string str) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * thirtyThree + str[i];
+    return val;
+}
+
+// Count the expected entries that cache does not hold, and any extra ones
+int countMismatches(Cache& cache, const set<pair<string, int> >& expected) {
+    int bad = 0;
+    for (set<pair<string, int> >::const_iterator it = expected.begin(); it != expected.end(); ++it) {
+        if (cache.getPerson(it->first, it->second).getKey() != it->first) {
+            bad++;
+        }
+    }
+    return bad + (cache.liveCount() - (int)expected.size() + bad);
+}
+
+long fileSize(const char* path) {
+    ifstream in(path, ios::binary | ios::ate);
+    return in ? (long)in.tellg() : -1;
+}
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing MutationLog Implementation" << endl;
+    cout << "========================================\n" << endl;
+
+    const char* logPath = "test_mutation.log";
+    const char* snapPath = "test_mutation.snap";
+    const string rotated = string(logPath) + ".compacting";
+    const string pending = string(snapPath) + ".compact";
+    std::remove(logPath);
+    std::remove(snapPath);
+    std::remove(rotated.c_str());
+    std::remove(pending.c_str());
+    const int TOTAL = 5000;
+    set<pair<string, int> > expected;
+
+    // Test 1: Replay inserts, removes, updates and TTLs through several rehashes
+    cout << "TEST 1: Recovery Round Trip" << endl;
+    cout << "---------------------------" << endl;
+    {
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        MutationLog log(logPath, FSYNC_EVERY_MS);
+        cache.setMutationLog(&log);
+        for (int i = 0; i < TOTAL; i++) {
+            cache.insert(Person("key" + to_string(i % 32), MINID + i, true));
+            expected.insert(make_pair("key" + to_string(i % 32), MINID + i));
+        }
+        for (int i = 0; i < TOTAL; i += 3) {
+            cache.remove(Person("key" + to_string(i % 32), MINID + i, true));
+            expected.erase(make_pair("key" + to_string(i % 32), MINID + i));
+        }
+        for (int i = 1; i < TOTAL; i += 3) {
+            cache.updateID(Person("key" + to_string(i % 32), MINID + i, true), MAXID - i);
+            expected.erase(make_pair("key" + to_string(i % 32), MINID + i));
+            expected.insert(make_pair("key" + to_string(i % 32), MAXID - i));
+        }
+        // Failed operations leave no record
+        cache.insert(Person("key1", MAXID - 1, true));
+        cache.remove(Person("missing", MINID, true));
+        // A long TTL survives the restart, a short one is gone by then
+        cache.insert(Person("lasting", MINID, true), 60000);
+        cache.insert(Person("brief", MINID, true), 1);
+        expected.insert(make_pair("lasting", MINID));
+    }
+    {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        if (!MutationLog::recover(cache, logPath, snapPath)) {
+            cout << "✗ Recovery failed!" << endl;
+            return 1;
+        }
+        int bad = countMismatches(cache, expected);
+        if (bad != 0) {
+            cout << "✗ " << bad << " entries differ after replay!" << endl;
+            return 1;
+        }
+        cout << "✓ " << cache.liveCount() << " live entries restored from the log" << endl;
+    }
+
+    // Test 2: A record torn by a crash is cut off
+    cout << "\nTEST 2: Torn Tail" << endl;
+    cout << "-----------------" << endl;
+    {
+        long before = fileSize(logPath);
+        {
+            ofstream out(logPath, ios::binary | ios::app);
+            LogRecordHead head = {12345, 20, LOG_INSERT, MINID, 0};
+            out.write((const char*)&head, sizeof(head));
+            out.write("torn", 4);
+        }
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        if (!MutationLog::recover(cache, logPath, snapPath) || countMismatches(cache, expected) != 0) {
+            cout << "✗ Recovery did not stop at the torn record!" << endl;
+            return 1;
+        }
+        if (fileSize(logPath) != before) {
+            cout << "✗ The log was not truncated to its valid length!" << endl;
+            return 1;
+        }
+        cout << "✓ Torn record ignored and truncated" << endl;
+    }
+
+    // Test 3: Compaction replaces the log by a snapshot, also when it is interrupted
+    cout << "\nTEST 3: Compaction" << endl;
+    cout << "------------------" << endl;
+    {
+        {
+            Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+            MutationLog::recover(cache, logPath, snapPath);
+            MutationLog log(logPath, FSYNC_NEVER);
+            cache.setMutationLog(&log);
+            if (!log.compact(cache, snapPath) || fileSize(logPath) != 0) {
+                cout << "✗ Compaction failed!" << endl;
+                return 1;
+            }
+            cache.insert(Person("compacted", MINID, true));
+            expected.insert(make_pair("compacted", MINID));
+        }
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        if (!MutationLog::recover(cache, logPath, snapPath) || countMismatches(cache, expected) != 0) {
+            cout << "✗ Snapshot plus log differ from the table!" << endl;
+            return 1;
+        }
+        cout << "✓ Snapshot plus new log restored" << endl;
+
+        // Crash before the commit point: the rotated log is still there, the new snapshot is junk
+        std::rename(logPath, rotated.c_str());
+        { ofstream(pending.c_str()) << "partial"; }
+        {
+            Cache later(MINPRIME, hashCode, DOUBLEHASH);
+            MutationLog log(logPath, FSYNC_NEVER);
+            later.setMutationLog(&log);
+            later.insert(Person("newer", MINID, true));
+        }
+        expected.insert(make_pair("newer", MINID));
+        Cache first(MINPRIME, hashCode, DOUBLEHASH);
+        if (!MutationLog::recover(first, logPath, snapPath) || countMismatches(first, expected) != 0
+            || fileSize(rotated.c_str()) >= 0 || fileSize(pending.c_str()) >= 0) {
+            cout << "✗ An uncommitted compaction was not rolled back!" << endl;
+            return 1;
+        }
+        // Crash after the commit point: only the rename of the new snapshot is missing
+        {
+            MutationLog log(logPath, FSYNC_NEVER);
+            log.compact(first, snapPath);
+        }
+        std::rename(snapPath, pending.c_str());
+        Cache second(MINPRIME, hashCode, DOUBLEHASH);
+        if (!MutationLog::recover(second, logPath, snapPath) || countMismatches(second, expected) != 0) {
+            cout << "✗ A committed compaction was not finished!" << endl;
+            return 1;
+        }
+        cout << "✓ Interrupted compactions recovered on both sides of the commit point" << endl;
+    }
+
+    // Test 4: Combined operations share a sync
+    cout << "\nTEST 4: Group Commit" << endl;
+    cout << "--------------------" << endl;
+    {
+        const int THREADS = 8;
+        const int OPS = 200;
+        std::remove(logPath);
+        std::remove(snapPath);
+        int syncs = 0;
+        {
+            CombiningCache cache(MINPRIME, hashCode);
+            MutationLog log(logPath, FSYNC_ALWAYS);
+            cache.setMutationLog(&log);
+            vector<thread> threads;
+            for (int t = 0; t < THREADS; t++) {
+                threads.push_back(thread([&cache, t]() {
+                    for (int i = 0; i < OPS; i++) {
+                        cache.insert(Person("t" + to_string(t), MINID + i, true));
+                    }
+                }));
+            }
+            for (int t = 0; t < THREADS; t++) {
+                threads[t].join();
+            }
+            syncs = log.getSyncCount();
+        }
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        MutationLog::recover(cache, logPath, snapPath);
+        if (cache.liveCount() != THREADS * OPS) {
+            cout << "✗ " << cache.liveCount() << " of " << THREADS * OPS << " synced inserts restored!" << endl;
+            return 1;
+        }
+        if (syncs >= THREADS * OPS) {
+            cout << "✗ Every insert was synced on its own!" << endl;
+            return 1;
+        }
+        cout << "✓ " << THREADS * OPS << " inserts committed with " << syncs << " syncs" << endl;
+    }
+    std::remove(logPath);
+    std::remove(snapPath);
+
+    // Test 5: A failed write is reported, never counted as durable and never waited on forever
+    cout << "\nTEST 5: Failed Writes" << endl;
+    cout << "---------------------" << endl;
+    {
+        // Every write to /dev/full fails with ENOSPC
+        MutationLog log("/dev/full", FSYNC_ALWAYS);
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        cache.setMutationLog(&log);
+        bool inserted = log.isOpen() && cache.insert(Person("full", MINID, true));
+        unsigned long long lsn = log.lastLSN();
+        bool durable = log.waitDurable(lsn);
+        unsigned long long after = log.append(LOG_INSERT, "after", MINID, 0);
+        bool flushed = log.flush();
+        if (!inserted || lsn != 1 || durable || !log.failed() || log.getError() != ENOSPC ||
+            after != 0 || flushed || log.waitDurable(lsn)) {
+            cout << "✗ Write failure: durable " << durable << ", failed " << log.failed()
+                 << ", errno " << log.getError() << ", append after it " << after << endl;
+            return 1;
+        }
+        cout << "✓ The failed batch stays pending, the error is latched and later appends are refused" << endl;
+    }
+
+    cout << "\n========================================" << endl;
+    cout << "  All MutationLog tests passed!" << endl;
+    cout << "========================================" << endl;
+    return 0;
+}
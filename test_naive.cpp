@@ -122,6 +122,22 @@ int main() {
         return 1;
     }
     
+    // Test 6: Update ID
+    cout << "\nTEST 6: Update ID" << endl;
+    cout << "-----------------" << endl;
+    
+    Person moved = testData[1];
+    int newID = (moved.getID() == MAXID) ? MINID : moved.getID() + 1;
+    if (cache.updateID(moved, newID) &&
+        cache.getPerson(moved.getKey(), newID).getID() == newID &&
+        cache.getPerson(moved.getKey(), moved.getID()).getKey() == "" &&
+        !cache.updateID(testData[0], newID) && !cache.updateID(Person(moved.getKey(), newID, true), MAXID + 1)) {
+        cout << "✓ Updated: " << moved.getKey() << " (ID: " << moved.getID() << " -> " << newID << ")" << endl;
+    } else {
+        cout << "✗ Update ID failed!" << endl;
+        return 1;
+    }
+    
     cout << "\n========================================" << endl;
     cout << "  All Tests Passed!" << endl;
     cout << "========================================" << endl;
@@ -0,0 +1,151 @@
+// Test program to verify CacheServer and CacheClient over localhost
+#include "cache_server.h"
+#include "cache_client.h"
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+// Hash function (same as driver.cpp)
+unsigned int hashCode(const string str) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * thirtyThree + str[i];
+    return val;
+}
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing CacheServer Implementation" << endl;
+    cout << "========================================\n" << endl;
+
+    const string socketPath = "/tmp/test_server_" + to_string(getpid()) + ".sock";
+    Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+    CacheServer server(cache);
+    if (!server.listenTCP(0) || !server.listenUnix(socketPath)) {
+        cout << "✗ Could not listen on localhost!" << endl;
+        return 1;
+    }
+    thread loop([&server]() { server.run(); });
+
+    // Test 1: Core operations over TCP
+    cout << "TEST 1: Core Operations" << endl;
+    cout << "-----------------------" << endl;
+    {
+        CacheClient client;
+        if (!client.connectTCP("127.0.0.1", server.getPort()) || !client.ping()) {
+            cout << "✗ Could not reach the server on port " << server.getPort() << endl;
+            server.stop();
+            loop.join();
+            return 1;
+        }
+        bool ok = client.insert(Person("alice", MINID, true));
+        ok = ok && client.insert(Person("alice", MINID, true)) == false;
+        ok = ok && client.getPerson("alice", MINID).getID() == MINID;
+        ok = ok && client.updateID(Person("alice", MINID, true), MINID + 1);
+        ok = ok && client.getPerson("alice", MINID).getKey() == "";
+        ok = ok && client.getPerson("alice", MINID + 1).getKey() == "alice";
+        ok = ok && client.remove(Person("alice", MINID + 1, true));
+        ok = ok && client.remove(Person("alice", MINID + 1, true)) == false;
+        ok = ok && client.insert(Person("brief", MINID, true), 60000) && client.liveCount() == 1;
+        if (!ok) {
+            cout << "✗ Operations over TCP returned wrong results!" << endl;
+            server.stop();
+            loop.join();
+            return 1;
+        }
+        cout << "✓ Insert, get, update, remove and TTL insert over TCP" << endl;
+    }
+
+    // Test 2: Pipelined commands are answered in order
+    cout << "\nTEST 2: Pipelining" << endl;
+    cout << "------------------" << endl;
+    const int TOTAL = 5000;
+    {
+        CacheClient client;
+        client.connectTCP("127.0.0.1", server.getPort());
+        for (int i = 0; i < TOTAL; i++) {
+            vector<string> args;
+            args.push_back("INSERT");
+            args.push_back("key" + to_string(i % 16));
+            args.push_back(to_string(MINID + 1 + i));
+            client.queue(args);
+        }
+        client.queue(vector<string>(1, "COUNT"));
+        client.queue(vector<string>(1, "NOSUCHCOMMAND"));
+        client.sendQueued();
+        int accepted = 0;
+        CacheReply reply;
+        for (int i = 0; i < TOTAL && client.readReply(reply); i++) {
+            accepted += (reply.m_type == REPLY_INTEGER && reply.m_integer == 1) ? 1 : 0;
+        }
+        bool counted = client.readReply(reply) && reply.m_type == REPLY_INTEGER && reply.m_integer == TOTAL + 1;
+        bool rejected = client.readReply(reply) && reply.m_type == REPLY_ERROR;
+        if (accepted != TOTAL || !counted || !rejected) {
+            cout << "✗ Only " << accepted << " of " << TOTAL << " pipelined inserts answered in order!" << endl;
+            server.stop();
+            loop.join();
+            return 1;
+        }
+        cout << "✓ " << TOTAL << " pipelined inserts sent in one write and answered in order" << endl;
+    }
+
+    // Test 3: Several clients on the Unix socket at once
+    cout << "\nTEST 3: Concurrent Clients" << endl;
+    cout << "--------------------------" << endl;
+    {
+        const int CLIENTS = 4;
+        const int PER_CLIENT = 500;
+        vector<int> failures(CLIENTS, 0);
+        vector<thread> clients;
+        for (int c = 0; c < CLIENTS; c++) {
+            clients.push_back(thread([&, c]() {
+                CacheClient client;
+                if (!client.connectUnix(socketPath)) {
+                    failures[c] = PER_CLIENT;
+                    return;
+                }
+                for (int i = 0; i < PER_CLIENT; i++) {
+                    int id = MAXID - c * PER_CLIENT - i;
+                    if (!client.insert(Person("unix" + to_string(c), id, true)) ||
+                        client.getPerson("unix" + to_string(c), id).getID() != id) {
+                        failures[c]++;
+                    }
+                }
+            }));
+        }
+        int failed = 0;
+        for (int c = 0; c < CLIENTS; c++) {
+            clients[c].join();
+            failed += failures[c];
+        }
+        CacheClient client;
+        client.connectUnix(socketPath);
+        if (failed != 0 || client.liveCount() != TOTAL + 1 + CLIENTS * PER_CLIENT) {
+            cout << "✗ " << failed << " operations failed over the Unix socket!" << endl;
+            server.stop();
+            loop.join();
+            return 1;
+        }
+        cout << "✓ " << CLIENTS << " clients served by one event loop" << endl;
+    }
+
+    // Test 4: The migration finishes while clients are idle
+    cout << "\nTEST 4: Idle Migration" << endl;
+    cout << "----------------------" << endl;
+    usleep(100000);
+    server.stop();
+    loop.join();
+    if (server.getIdleSteps() == 0 || cache.advanceMigration()) {
+        cout << "✗ The migration did not advance between bursts!" << endl;
+        return 1;
+    }
+    cout << "✓ " << server.getIdleSteps() << " migration steps taken while idle" << endl;
+
+    cout << "\n========================================" << endl;
+    cout << "  All CacheServer tests passed!" << endl;
+    cout << "========================================" << endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Test program to verify ShardedCache (shard-per-core actor mode)
+#include "shard_cache.h"
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+// Hash function (same as driver.cpp)
+unsigned int hashCode(const string str) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * thirtyThree + str[i];
+    return val;
+}
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing ShardedCache Implementation" << endl;
+    cout << "========================================\n" << endl;
+
+    const int NUM_SHARDS = 4;
+    const int NUM_CLIENTS = 4;
+    const int PER_CLIENT = 400;
+    ShardedCache cache(NUM_SHARDS, MINPRIME, hashCode, DOUBLEHASH, false);
+
+    // Test 1: Futures from several client threads
+    cout << "TEST 1: Concurrent Inserts Through Futures" << endl;
+    cout << "------------------------------------------" << endl;
+    vector<int> failures(NUM_CLIENTS, 0);
+    vector<thread> clients;
+    for (int t = 0; t < NUM_CLIENTS; t++) {
+        clients.push_back(thread([t, &cache, &failures]() {
+            vector<future<bool> > pending;
+            for (int i = 0; i < PER_CLIENT; i++) {
+                pending.push_back(cache.insert(Person("key" + to_string(i % 32), MINID + t * PER_CLIENT + i, true)));
+            }
+            for (unsigned int i = 0; i < pending.size(); i++) {
+                if (!pending[i].get()) failures[t]++;
+            }
+        }));
+    }
+    for (int t = 0; t < NUM_CLIENTS; t++) clients[t].join();
+    for (int t = 0; t < NUM_CLIENTS; t++) {
+        if (failures[t] != 0) {
+            cout << "✗ Client " << t << " failed " << failures[t] << " inserts!" << endl;
+            return 1;
+        }
+    }
+    cout << "✓ Inserted " << NUM_CLIENTS * PER_CLIENT << " persons into " << NUM_SHARDS << " shards" << endl;
+
+    // Test 2: Batched lookups keep the request order
+    cout << "\nTEST 2: Batched Submit" << endl;
+    cout << "----------------------" << endl;
+    vector<ShardOp> ops;
+    for (int i = 0; i < PER_CLIENT; i++) {
+        ops.push_back(ShardOp(SHARD_GET, Person("key" + to_string(i % 32), MINID + i, true)));
+    }
+    // One miss in the middle
+    ops.push_back(ShardOp(SHARD_GET, Person("missing", MINID, true)));
+    vector<ShardResult> results = cache.submitBatch(ops).get();
+    for (int i = 0; i < PER_CLIENT; i++) {
+        if (!results[i].m_ok || results[i].m_person.getID() != MINID + i) {
+            cout << "✗ Batch result " << i << " is wrong!" << endl;
+            return 1;
+        }
+    }
+    if (results[PER_CLIENT].m_ok) {
+        cout << "✗ Missing person was found!" << endl;
+        return 1;
+    }
+    cout << "✓ " << results.size() << " batched results in order" << endl;
+
+    // Test 3: Remove, update and callbacks
+    cout << "\nTEST 3: Remove, Update And Callbacks" << endl;
+    cout << "------------------------------------" << endl;
+    if (!cache.remove(Person("key0", MINID, true)).get()) {
+        cout << "✗ Failed to remove!" << endl;
+        return 1;
+    }
+    if (!cache.updateID(Person("key1", MINID + 1, true), MAXID).get()) {
+        cout << "✗ Failed to update!" << endl;
+        return 1;
+    }
+    promise<bool> done;
+    cache.submit(ShardOp(SHARD_GET, Person("key1", MAXID, true)), [&done](const ShardResult& result) {
+        done.set_value(result.m_ok);
+    });
+    if (!done.get_future().get()) {
+        cout << "✗ Updated person not found through callback!" << endl;
+        return 1;
+    }
+    if (cache.getPerson("key0", MINID).get().getKey() != "") {
+        cout << "✗ Removed person still found!" << endl;
+        return 1;
+    }
+    cout << "✓ Remove, update and callback all correct" << endl;
+
+    cout << "\n========================================" << endl;
+    cout << "  All Tests Passed!" << endl;
+    cout << "========================================" << endl;
+
+    return 0;
+}
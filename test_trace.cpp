@@ -0,0 +1,195 @@
+// Test program to verify operation traces round-trip and replay deterministically
+#include "op_trace.h"
+#include "naive_cache.h"
+#include <iostream>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+// Hash function (same as driver.cpp)
+unsigned int hashCode(const string str) {
+    unsigned int val = 0;
+    const unsigned int thirtyThree = 33;
+    for (int i = 0; i < (int)(str.length()); i++)
+        val = val * thirtyThree + str[i];
+    return val;
+}
+
+long fileSize(const char* path) {
+    ifstream in(path, ios::binary | ios::ate);
+    return in ? (long)in.tellg() : -1;
+}
+
+bool sameRecord(const TraceRecord& a, const TraceRecord& b) {
+    return a.m_op == b.m_op && a.m_ok == b.m_ok && a.m_key == b.m_key && a.m_id == b.m_id &&
+           (a.m_op != TRACE_UPDATE || a.m_newID == b.m_newID) && a.m_timeNs == b.m_timeNs;
+}
+
+// replayMismatches: Records whose result differs from the recorded one
+template <typename CacheType>
+int replayMismatches(CacheType& cache, const vector<TraceRecord>& records) {
+    int mismatches = 0;
+    for (unsigned int i = 0; i < records.size(); i++) {
+        mismatches += applyTraceRecord(cache, records[i]) != records[i].m_ok ? 1 : 0;
+    }
+    return mismatches;
+}
+
+int main() {
+    cout << "========================================" << endl;
+    cout << "  Testing Operation Traces" << endl;
+    cout << "========================================\n" << endl;
+
+    const char* tracePath = "test_trace.trace";
+    std::remove(tracePath);
+
+    // Test 1: Every field survives the encoding, repeated keys cost no key bytes
+    cout << "TEST 1: Encoding Round Trip" << endl;
+    cout << "---------------------------" << endl;
+    {
+        vector<TraceRecord> written;
+        for (int i = 0; i < 3000; i++) {
+            TraceRecord r;
+            r.m_op = (traceop_t)(TRACE_GET + i % 4);
+            r.m_ok = i % 3 != 0;
+            r.m_key = (i % 100 == 0) ? string(300, 'a' + i % 26) : "key" + to_string(i / 2);
+            r.m_id = (i % 50 == 0) ? -i : MINID + i;
+            r.m_newID = MAXID - i;
+            r.m_timeNs = (unsigned long long)i * i * 1000;
+            written.push_back(r);
+        }
+        {
+            TraceWriter writer(tracePath);
+            for (unsigned int i = 0; i < written.size(); i++) {
+                if (writer.append(written[i]) == false) {
+                    cout << "✗ append failed at record " << i << endl;
+                    return 1;
+                }
+            }
+            TraceRecord backwards = written.back();
+            backwards.m_timeNs = 0;
+            if (writer.append(backwards) || writer.count() != written.size()) {
+                cout << "✗ A record going back in time was accepted!" << endl;
+                return 1;
+            }
+        }
+        vector<TraceRecord> read;
+        TraceReader::readAll(tracePath, read);
+        bool ok = read.size() == written.size();
+        for (unsigned int i = 0; ok && i < read.size(); i++) {
+            ok = sameRecord(read[i], written[i]);
+        }
+        if (!ok) {
+            cout << "✗ Read back " << read.size() << " of " << written.size() << " records, or a field differs!" << endl;
+            return 1;
+        }
+        double perRecord = double(fileSize(tracePath) - sizeof(TRACEMAGIC)) / written.size();
+        if (perRecord > 16) {
+            cout << "✗ " << perRecord << " bytes per record!" << endl;
+            return 1;
+        }
+        cout << "✓ " << written.size() << " records read back unchanged, " << perRecord << " bytes each" << endl;
+    }
+
+    // Test 2: The recorder logs what the cache did, in order
+    cout << "\nTEST 2: Recording a Live Cache" << endl;
+    cout << "------------------------------" << endl;
+    vector<TraceRecord> recorded;
+    int liveAfterRecording;
+    {
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        {
+            TraceWriter writer(tracePath);
+            TracingCache traced(cache, writer);
+            // Enough inserts for several rehashes, then every kind of hit and miss
+            for (int i = 0; i < 2000; i++) {
+                traced.insert(Person("key" + to_string(i % 64), MINID + i, true));
+            }
+            traced.insert(Person("key0", MINID, true));     // duplicate
+            for (int i = 0; i < 2000; i += 2) {
+                traced.getPerson("key" + to_string(i % 64), MINID + i);
+                traced.getPerson("missing" + to_string(i), MINID + i);
+                traced.remove(Person("key" + to_string(i % 64), MINID + i, true));
+                traced.updateID(Person("key" + to_string((i + 1) % 64), MINID + i + 1, true), MAXID - i);
+            }
+            traced.remove(Person("key0", MINID, true));     // already removed
+        }
+        liveAfterRecording = cache.liveCount();
+        TraceReader::readAll(tracePath, recorded);
+    }
+    {
+        int successes[5] = {0, 0, 0, 0, 0};
+        bool ordered = true;
+        for (unsigned int i = 0; i < recorded.size(); i++) {
+            successes[recorded[i].m_op] += recorded[i].m_ok ? 1 : 0;
+            ordered = ordered && (i == 0 || recorded[i].m_timeNs >= recorded[i - 1].m_timeNs);
+        }
+        if (recorded.size() != 6002 || !ordered || successes[TRACE_INSERT] != 2000 ||
+            successes[TRACE_GET] != 1000 || successes[TRACE_REMOVE] != 1000 || successes[TRACE_UPDATE] != 1000) {
+            cout << "✗ Recorded " << recorded.size() << " operations, inserts " << successes[TRACE_INSERT]
+                 << ", gets " << successes[TRACE_GET] << ", removes " << successes[TRACE_REMOVE]
+                 << ", updates " << successes[TRACE_UPDATE] << endl;
+            return 1;
+        }
+        cout << "✓ " << recorded.size() << " operations recorded with their results, times never go back" << endl;
+    }
+
+    // Test 3: Replaying reproduces every result, in any implementation
+    cout << "\nTEST 3: Deterministic Replay" << endl;
+    cout << "----------------------------" << endl;
+    {
+        Cache cache(MINPRIME, hashCode, DOUBLEHASH);
+        NaiveCache naive(MINPRIME, hashCode, DOUBLEHASH);
+        Cache linear(MAXPRIME, hashCode, LINEAR);
+        int mismatches = replayMismatches(cache, recorded);
+        int naiveMismatches = replayMismatches(naive, recorded);
+        int linearMismatches = replayMismatches(linear, recorded);
+        if (mismatches != 0 || naiveMismatches != 0 || linearMismatches != 0 ||
+            cache.liveCount() != liveAfterRecording || linear.liveCount() != liveAfterRecording) {
+            cout << "✗ Results differ: Cache " << mismatches << ", NaiveCache " << naiveMismatches
+                 << ", linear probing " << linearMismatches << endl;
+            return 1;
+        }
+        cout << "✓ Cache, NaiveCache and a linear-probing Cache reproduce all " << recorded.size() << " results" << endl;
+    }
+
+    // Test 4: A cut-off record ends the trace, a foreign file is rejected
+    cout << "\nTEST 4: Truncated and Foreign Files" << endl;
+    cout << "-----------------------------------" << endl;
+    {
+        string bytes;
+        {
+            ifstream in(tracePath, ios::binary);
+            bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        }
+        {
+            ofstream out(tracePath, ios::binary | ios::trunc);
+            out.write(bytes.data(), bytes.size() - 2);
+        }
+        TraceReader reader(tracePath);
+        TraceRecord record;
+        unsigned int count = 0;
+        while (reader.next(record)) {
+            count++;
+        }
+        bool truncated = reader.truncated();
+        {
+            ofstream out(tracePath, ios::binary | ios::trunc);
+            out << "not a trace";
+        }
+        TraceReader foreign(tracePath);
+        if (count != recorded.size() - 1 || !truncated || foreign.isOpen() || TraceReader("no_such.trace").isOpen()) {
+            cout << "✗ Read " << count << " records of a cut-off trace, or opened a file that is no trace!" << endl;
+            return 1;
+        }
+        cout << "✓ The cut-off record is dropped and reported, other files do not open" << endl;
+    }
+    std::remove(tracePath);
+
+    cout << "\n========================================" << endl;
+    cout << "  All trace tests passed!" << endl;
+    cout << "========================================" << endl;
+    return 0;
+}
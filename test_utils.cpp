@@ -27,7 +27,12 @@ int main() {
     timer.start();
     this_thread::sleep_for(chrono::milliseconds(10)); // Sleep for 10ms
     double elapsed = timer.elapsed();
-    cout << "Slept for ~10ms, timer measured: " << elapsed / 1000.0 << " ms" << endl;
+    cout << "Slept for ~10ms, timer measured: " << elapsed / 1000.0 << " ms"
+         << (TscClock::usingTsc() ? " (TSC)" : " (steady_clock)") << endl;
+    if (elapsed < 9000.0 || elapsed > 1000000.0) {
+        cout << "✗ Timer is off!" << endl;
+        return 1;
+    }
     cout << "✓ Timer is working!\n" << endl;
     
     // Test 2: LatencyStats class
@@ -44,7 +49,7 @@ int main() {
     
     cout << "Recorded latencies: 5, 10, 15, 20, 100 μs" << endl;
     cout << "Average: " << stats.getAverage() << " μs (expected: 30)" << endl;
-    cout << "P50: " << stats.getP50() << " μs (expected: 15)" << endl;
+    cout << "P50: " << stats.getP50() << " μs (expected: 15, to 3 significant digits)" << endl;
     cout << "P99: " << stats.getP99() << " μs (expected: 100)" << endl;
     cout << "✓ LatencyStats is working!\n" << endl;
     
@@ -88,6 +93,172 @@ int main() {
     cout << "Check the file to see CSV output format" << endl;
     cout << "✓ CSV output is working!\n" << endl;
     
+    // Test 6: Sub-microsecond resolution
+    cout << "TEST 6: Nanosecond Resolution" << endl;
+    cout << "-----------------------------" << endl;
+    {
+        LatencyStats fast;
+        for (int i = 0; i < 100; i++) {
+            fast.recordNs(40 + i);          // 40 to 139 ns, exact below 2048 ns
+        }
+        Timer nsTimer;
+        nsTimer.start();
+        double tiny = nsTimer.elapsedNs();
+        cout << "Back-to-back timer reads: " << tiny << " ns" << endl;
+        if (fast.getPercentileNs(0.5) != 89 || fast.getMin() != 0.04 || tiny >= 1000.0) {
+            cout << "✗ Sub-microsecond latencies are not resolved!" << endl;
+            return 1;
+        }
+        cout << "✓ P50 of 40..139 ns is " << fast.getPercentileNs(0.5) << " ns\n" << endl;
+    }
+
+    // Test 7: Percentiles within the histogram precision of the exact values
+    cout << "TEST 7: Percentile Accuracy" << endl;
+    cout << "---------------------------" << endl;
+    {
+        mt19937 rng(7);
+        lognormal_distribution<double> dist(7.0, 1.5);      // mostly around 1μs, long tail
+        vector<uint64_t> exact;
+        LatencyStats hist;
+        for (int i = 0; i < 200000; i++) {
+            uint64_t ns = (uint64_t)dist(rng);
+            exact.push_back(ns);
+            hist.recordNs(ns);
+        }
+        sort(exact.begin(), exact.end());
+        double worst = 0;
+        double points[] = {0.1, 0.5, 0.9, 0.99, 0.999, 0.9999};
+        for (double p : points) {
+            uint64_t want = exact[(size_t)ceil(p * exact.size()) - 1];
+            double error = fabs(double(hist.getPercentileNs(p)) - want) / (want > 0 ? want : 1);
+            worst = error > worst ? error : worst;
+        }
+        if (worst > 0.001 || hist.getMax() != exact.back() / 1000.0) {
+            cout << "✗ Percentiles are " << worst * 100 << "% off!" << endl;
+            return 1;
+        }
+        cout << "✓ P10 to P99.99 within " << worst * 100 << "% of a full sort\n" << endl;
+    }
+
+    // Test 8: Per-thread histograms merge into one
+    cout << "TEST 8: Merging" << endl;
+    cout << "---------------" << endl;
+    {
+        vector<LatencyStats> perThread(4);
+        vector<thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.push_back(thread([&perThread, t]() {
+                for (int i = 0; i < 10000; i++) {
+                    perThread[t].recordNs(1000 * (t + 1));
+                }
+            }));
+        }
+        LatencyStats all;
+        for (int t = 0; t < 4; t++) {
+            threads[t].join();
+            all.merge(perThread[t]);
+        }
+        if (all.count() != 40000 || all.getPercentileNs(0.5) != 2000 || all.getMax() != 4.0 ||
+            all.getAverage() != 2.5) {
+            cout << "✗ Merged histogram is wrong!" << endl;
+            return 1;
+        }
+        cout << "✓ 4 threads x 10000 samples merged, P50 " << all.getP50() << " μs\n" << endl;
+    }
+
+    // Test 9: YCSB workload generator
+    cout << "TEST 9: YCSB Workload Generator" << endl;
+    cout << "-------------------------------" << endl;
+    {
+        const int DRAWS = 200000;
+        bool ok = true;
+        for (char w = 'A'; w <= 'F'; w++) {
+            WorkloadSpec spec = WorkloadSpec::preset(w);
+            double sum = spec.readProportion + spec.updateProportion + spec.insertProportion +
+                         spec.scanProportion + spec.rmwProportion;
+            ok = ok && fabs(sum - 1.0) < 1e-9;
+        }
+
+        // Keys are distinct and within the length range
+        WorkloadSpec spec = WorkloadSpec::preset('C');
+        WorkloadGenerator zipf(spec);
+        unordered_map<string, bool> seen;
+        for (int r = 0; r < spec.recordCount; r++) {
+            string key = zipf.keyOf(r);
+            ok = ok && (int)key.size() >= spec.minKeyLength && (int)key.size() <= spec.maxKeyLength;
+            seen[key] = true;
+        }
+        ok = ok && (int)seen.size() == spec.recordCount;
+
+        // Zipfian: the top 1% of records take about half the reads
+        vector<int> hits(spec.recordCount, 0);
+        for (int i = 0; i < DRAWS; i++) {
+            hits[zipf.next().record]++;
+        }
+        sort(hits.rbegin(), hits.rend());
+        double top = accumulate(hits.begin(), hits.begin() + spec.recordCount / 100, 0.0) / DRAWS;
+
+        // Hotspot: 80% of the operations on 20% of the records
+        spec.popularity = POP_HOTSPOT;
+        WorkloadGenerator hotspot(spec);
+        int hot = 0;
+        for (int i = 0; i < DRAWS; i++) {
+            hot += hotspot.next().record < spec.recordCount / 5 ? 1 : 0;
+        }
+        double hotShare = double(hot) / DRAWS;
+
+        // Latest: reads follow the inserts
+        WorkloadGenerator latest(WorkloadSpec::preset('D'));
+        int newest = 0;
+        int reads = 0;
+        for (int i = 0; i < DRAWS; i++) {
+            WorkloadOp op = latest.next();
+            if (op.op == YCSB_READ) {
+                reads++;
+                newest += op.record >= latest.recordCount() - 10 ? 1 : 0;
+            }
+        }
+        double newestShare = double(newest) / reads;
+
+        cout << "Top 1% of records: " << fixed << setprecision(1) << top * 100 << "% of reads" << endl;
+        cout << "Hot 20% of records: " << hotShare * 100 << "% of operations" << endl;
+        cout << "10 newest records: " << newestShare * 100 << "% of reads in workload D" << endl;
+        if (!ok || top < 0.4 || fabs(hotShare - 0.8) > 0.01 || newestShare < 0.25) {
+            cout << "✗ Workload generator does not follow its distributions!" << endl;
+            return 1;
+        }
+        cout << "✓ Presets, keys and popularity distributions are right\n" << endl;
+    }
+
+    // Test 10: Barrier-synchronized start
+    cout << "TEST 10: Start Barrier" << endl;
+    cout << "----------------------" << endl;
+    {
+        const int WORKERS = 4;
+        StartBarrier barrier;
+        atomic<int> started(0);
+        vector<thread> workers;
+        for (int t = 0; t < WORKERS; t++) {
+            workers.push_back(thread([&barrier, &started, t]() {
+                pinThread(t);
+                barrier.arrive();
+                started++;
+            }));
+        }
+        barrier.waitForAll(WORKERS);
+        this_thread::sleep_for(chrono::milliseconds(10));
+        int early = started.load();
+        barrier.release();
+        for (int t = 0; t < WORKERS; t++) {
+            workers[t].join();
+        }
+        if (early != 0 || started.load() != WORKERS) {
+            cout << "✗ " << early << " workers started before the release!" << endl;
+            return 1;
+        }
+        cout << "✓ " << WORKERS << " workers held at the barrier until released\n" << endl;
+    }
+
     cout << "\n========================================" << endl;
     cout << "  All Tests Passed!" << endl;
     cout << "========================================" << endl;
@@ -0,0 +1,108 @@
+// Hierarchical Timing Wheel Implementation
+#include "timing_wheel.h"
+#include "cache_stats.h"
+
+// Constructor
+TimingWheel::TimingWheel() {
+    m_current = 0;
+    m_size = 0;
+}
+
+// reset: Start turning from time now
+void TimingWheel::reset(long long now) {
+    m_current = now;
+}
+
+// schedule: Add one expiry
+void TimingWheel::schedule(const std::string& key, int id, long long expireAt) {
+    place(TimerEntry(key, id, expireAt));
+    m_size++;
+}
+
+// place: The entry goes to the lowest level whose enclosing block it shares with m_current,
+// so it is cascaded down (or handed out) exactly when the wheel reaches its time
+void TimingWheel::place(const TimerEntry& entry) {
+    long long when = entry.m_expireAt;
+    // Already due, hand it out on the next tick
+    if (when < m_current) {
+        when = m_current;
+    }
+    int top = WHEELLEVELS - 1;
+    for (int level = 0; level < top; level++) {
+        int shift = WHEELBITS * (level + 1);
+        if ((when >> shift) == (m_current >> shift)) {
+            int slot = (int)((when >> (WHEELBITS * level)) & (WHEELSLOTS - 1));
+            m_slots[level][slot].push_back(entry);
+            return;
+        }
+    }
+    int slot = 0;
+    if (when - m_current < (1LL << (WHEELBITS * WHEELLEVELS))) {
+        // Within one turn of the top level, its slot comes round exactly at the block start
+        slot = (int)((when >> (WHEELBITS * top)) & (WHEELSLOTS - 1));
+    } else {
+        // Further out than the wheel reaches, park it in the top level slot visited last
+        // (it is placed again from there when that slot cascades)
+        slot = (int)(((m_current >> (WHEELBITS * top)) - 1) & (WHEELSLOTS - 1));
+    }
+    m_slots[top][slot].push_back(entry);
+}
+
+// cascade: Move the entries of the level's current slot to lower levels
+void TimingWheel::cascade(int level) {
+    int slot = (int)((m_current >> (WHEELBITS * level)) & (WHEELSLOTS - 1));
+    std::vector<TimerEntry> moving;
+    moving.swap(m_slots[level][slot]);
+    for (unsigned int i = 0; i < moving.size(); i++) {
+        place(moving[i]);
+    }
+}
+
+// advance: Process ticks up to now, handing out at most budget due entries
+int TimingWheel::advance(long long now, int budget, std::vector<TimerEntry>& due) {
+    int appended = 0;
+    int ticks = 0;
+    while (m_current <= now && ticks < WHEELMAXTICKS) {
+        // An empty wheel can jump straight to now
+        if (m_size == 0) {
+            m_current = now + 1;
+            break;
+        }
+        std::vector<TimerEntry>& slot = m_slots[0][m_current & (WHEELSLOTS - 1)];
+        while (slot.empty() == false && appended < budget) {
+            due.push_back(slot.back());
+            slot.pop_back();
+            m_size--;
+            appended++;
+        }
+        // Out of budget in the middle of a slot, continue here next time
+        if (slot.empty() == false) {
+            break;
+        }
+        m_current++;
+        ticks++;
+        // Crossing a block boundary of a level pulls its next slot down
+        for (int level = 1; level < WHEELLEVELS; level++) {
+            if ((m_current & ((1LL << (WHEELBITS * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+    }
+    return appended;
+}
+
+// memoryUsage: Slots keep their capacity after they are emptied, so idle levels count too
+void TimingWheel::memoryUsage(HeapBytes& bytes) const {
+    for (int level = 0; level < WHEELLEVELS; level++) {
+        for (int slot = 0; slot < WHEELSLOTS; slot++) {
+            const std::vector<TimerEntry>& entries = m_slots[level][slot];
+            if (entries.capacity() > 0) {
+                bytes.addBlock(entries.data(), entries.capacity() * sizeof(TimerEntry));
+            }
+            for (size_t i = 0; i < entries.size(); i++) {
+                bytes.addString(entries[i].m_key);
+            }
+        }
+    }
+}
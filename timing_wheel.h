@@ -0,0 +1,52 @@
+// Hierarchical Timing Wheel for per-entry TTL expiry
+// Level 0 has one slot per millisecond, every higher level covers WHEELSLOTS
+// slots of the level below; entries cascade down as the wheel turns
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <string>
+#include <vector>
+
+struct HeapBytes;   // cache_stats.h
+
+const int WHEELLEVELS = 4;      // levels, the top one spans 64^4 ms (about 4.6 hours)
+const int WHEELSLOTS = 64;      // slots per level, a power of two
+const int WHEELBITS = 6;        // log2(WHEELSLOTS)
+const int WHEELMAXTICKS = 4096; // ticks one advance call may walk before giving up its turn
+
+// A scheduled expiry, it refers to the entry by value so it can never dangle
+struct TimerEntry {
+    std::string m_key;
+    int         m_id;
+    long long   m_expireAt;     // absolute time in ms
+    TimerEntry(const std::string& key = "", int id = 0, long long expireAt = 0)
+        : m_key(key), m_id(id), m_expireAt(expireAt) {}
+};
+
+class TimingWheel {
+public:
+    TimingWheel();
+    // Start the wheel at time now (ms), only used before anything is scheduled
+    void reset(long long now);
+    // Add an expiry, times in the past are due on the next advance
+    void schedule(const std::string& key, int id, long long expireAt);
+    // Turn the wheel towards now and append at most budget due entries to due
+    // Returns the number of entries appended
+    int advance(long long now, int budget, std::vector<TimerEntry>& due);
+    int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    // Add every slot's entry array and the keys' heap buffers to bytes
+    void memoryUsage(HeapBytes& bytes) const;
+
+private:
+    // Put an entry in the level and slot matching its distance from m_current
+    void place(const TimerEntry& entry);
+    // Re-place every entry of one slot of a higher level
+    void cascade(int level);
+
+    std::vector<TimerEntry> m_slots[WHEELLEVELS][WHEELSLOTS];
+    long long m_current;    // next tick to process, everything before it has been handed out
+    int       m_size;       // scheduled entries
+};
+
+#endif // TIMING_WHEEL_H